@@ -5,6 +5,6 @@
 #  error Conflicting definitions of CORE_ABIVERSION
 #endif
 
-#define CORE_ABIVERSION 20121210
+#define CORE_ABIVERSION 20261019
 
 #endif // COMPIZ_ABIVERSION_H
@@ -67,6 +67,14 @@ class CompMatch {
 	 */
 	bool evaluate (const CompWindow *window) const;
 
+	/**
+	 * Same as evaluate, but the result is remembered per window until
+	 * CompScreen::matchPropertyChanged is called for that window,
+	 * CompScreen::matchExpHandlerChanged is called or this match
+	 * changes. Use it for matches that are evaluated on every frame.
+	 */
+	bool evaluateCached (const CompWindow *window) const;
+
 	CompString toString () const;
 	bool isEmpty () const;
 
@@ -397,6 +397,10 @@ public:
     virtual void processEvents () = 0;
     virtual void alwaysHandleEvent (XEvent *event) = 0;
 
+    /* Number of queued events of a type which were merged into
+     * another event of the same type and never handled */
+    virtual unsigned int coalescedEvents (int type) const = 0;
+
     virtual ServerGrabInterface * serverGrabInterface () = 0;
 
     // Replacements for friends accessing priv. They are declared virtual to
@@ -577,6 +577,7 @@ class CompWindow :
 	friend class ModifierHandler;
 	friend class CoreWindow;
 	friend class StackDebugger;
+	friend class PrivateMatch;
 
     private:
 
@@ -585,6 +586,9 @@ class CompWindow :
 		    XWindowAttributes &wa,
 		    PrivateWindow     *priv);
 
+	/* See PrivateWindow::createStandIn */
+	CompWindow (PrivateWindow *priv);
+
 	PrivateWindow *priv;
 };
 
@@ -67,16 +67,19 @@
 {									\
     enum { num = func ## Index };                                       \
     unsigned int curr = mCurrFunction[num];				\
-    while (mCurrFunction[num] < mInterface.size () &&			\
-           !mInterface[mCurrFunction[num]].enabled[num])		\
-        mCurrFunction[num]++;						\
-    if (mCurrFunction[num] < mInterface.size ())			\
+    if (curr < mNextEnabled[num].size ())				\
     {									\
-	mInterface[mCurrFunction[num]++].obj-> func (__VA_ARGS__);	\
-	mCurrFunction[num] = curr;					\
-	return;								\
+	unsigned int next = mNextEnabled[num][curr];			\
+	if (next < mInterface.size ())					\
+	{								\
+	    if (mCountCalls)						\
+		mInterface[next].calls[num]++;				\
+	    mCurrFunction[num] = next + 1;				\
+	    mInterface[next].obj-> func (__VA_ARGS__);			\
+	    mCurrFunction[num] = curr;					\
+	    return;							\
+	}								\
     }									\
-    mCurrFunction[num] = curr;						\
 }
 
 // For compatability ignore num and forward
@@ -88,16 +91,19 @@
 {									\
     enum { num = func ## Index };                                       \
     unsigned int curr = mCurrFunction[num];				\
-    while (mCurrFunction[num] < mInterface.size () &&			\
-           !mInterface[mCurrFunction[num]].enabled[num])		\
-        mCurrFunction[num]++;						\
-    if (mCurrFunction[num] < mInterface.size ())			\
+    if (curr < mNextEnabled[num].size ())				\
     {									\
-	rtype rv = mInterface[mCurrFunction[num]++].obj-> func (__VA_ARGS__); \
-	mCurrFunction[num] = curr;					\
-	return rv;							\
+	unsigned int next = mNextEnabled[num][curr];			\
+	if (next < mInterface.size ())					\
+	{								\
+	    if (mCountCalls)						\
+		mInterface[next].calls[num]++;				\
+	    mCurrFunction[num] = next + 1;				\
+	    rtype rv = mInterface[next].obj-> func (__VA_ARGS__);	\
+	    mCurrFunction[num] = curr;					\
+	    return rv;							\
+	}								\
     }									\
-    mCurrFunction[num] = curr;						\
 }
 
 template <typename T, typename T2>
@@ -130,6 +136,29 @@ class WrapableHandler : public T
 
 	unsigned int numWrapClients () { return mInterface.size (); }
 
+	/**
+	 * Whether any interface currently has function num enabled,
+	 * so that calling it does more than the default implementation
+	 */
+	bool functionWrapped (unsigned int num) const;
+
+	/**
+	 * Same as functionWrapped, but leaving out the interfaces
+	 * in ignored
+	 */
+	bool functionWrappedBesides (unsigned int          num,
+				     const std::vector<T *> &ignored) const;
+
+	/**
+	 * Counts how often each interface gets called for each function,
+	 * to find out which ones sit in the hot paths. Off by default,
+	 * counting costs one branch per call while it is off.
+	 */
+	void setCountCalls (bool count) { mCountCalls = count; }
+	bool countCalls () const { return mCountCalls; }
+	unsigned int numCalls (T *obj, unsigned int num) const;
+	void resetCallCounts ();
+
     protected:
 
 	struct Interface
@@ -137,13 +166,15 @@ class WrapableHandler : public T
             Interface(T *obj, bool enable) : obj(obj)
             {
                 std::fill_n(this->enabled, N, enable);
+                std::fill_n(this->calls, N, 0);
             }
 
             T    *obj;
             bool enabled[N];
+            mutable unsigned int calls[N];
 	};
 
-	WrapableHandler () : mInterface ()
+	WrapableHandler () : mInterface (), mCountCalls (false)
 	{
             std::fill_n(mCurrFunction, N, 0);
         }
@@ -157,12 +188,42 @@ class WrapableHandler : public T
 
         mutable unsigned int mCurrFunction[N];
         std::vector<Interface> mInterface;
+
+	/* mNextEnabled[num][i] is the index of the first interface at or
+	 * after i that has function num enabled, or mInterface.size ().
+	 * Rebuilt whenever interfaces or their enabled flags change, so
+	 * the dispatch macros never have to skip disabled interfaces. */
+	std::vector<unsigned int> mNextEnabled[N];
+	bool                      mCountCalls;
+
+    private:
+
+	void updateNextEnabled (unsigned int num);
 };
 
+template <typename T, unsigned int N>
+void WrapableHandler<T,N>::updateNextEnabled (unsigned int num)
+{
+    unsigned int next = mInterface.size ();
+
+    mNextEnabled[num].resize (mInterface.size ());
+
+    for (unsigned int i = mInterface.size (); i > 0; i--)
+    {
+	if (mInterface[i - 1].enabled[num])
+	    next = i - 1;
+
+	mNextEnabled[num][i - 1] = next;
+    }
+}
+
 template <typename T, unsigned int N>
 void WrapableHandler<T,N>::registerWrap (T *obj, bool enabled)
 {
     mInterface.insert (mInterface.begin (), Interface(obj, enabled));
+
+    for (unsigned int num = 0; num < N; num++)
+	updateNextEnabled (num);
 }
 
 template <typename T, unsigned int N>
@@ -177,6 +238,9 @@ void WrapableHandler<T,N>::unregisterWrap (T *obj)
 	    break;
 	}
     }
+
+    for (unsigned int num = 0; num < N; num++)
+	updateNextEnabled (num);
 }
 
 template <typename T, unsigned int N>
@@ -188,10 +252,57 @@ void WrapableHandler<T,N>::functionSetEnabled (T *obj, unsigned int num,
     {
 	if (it->obj == obj)
 	{
-	    it->enabled[num] = enabled;
+	    if (it->enabled[num] != enabled)
+	    {
+		it->enabled[num] = enabled;
+		updateNextEnabled (num);
+	    }
 	    break;
 	}
     }
 }
 
+template <typename T, unsigned int N>
+bool WrapableHandler<T,N>::functionWrapped (unsigned int num) const
+{
+    return !mNextEnabled[num].empty () &&
+	   mNextEnabled[num][0] < mInterface.size ();
+}
+
+template <typename T, unsigned int N>
+bool WrapableHandler<T,N>::functionWrappedBesides (unsigned int          num,
+						   const std::vector<T *> &ignored) const
+{
+    typedef typename std::vector<Interface>::const_iterator iterator;
+    for (iterator it = mInterface.begin (); it != mInterface.end (); ++it)
+    {
+	if (it->enabled[num] &&
+	    std::find (ignored.begin (), ignored.end (), it->obj) == ignored.end ())
+	    return true;
+    }
+
+    return false;
+}
+
+template <typename T, unsigned int N>
+unsigned int WrapableHandler<T,N>::numCalls (T *obj, unsigned int num) const
+{
+    typedef typename std::vector<Interface>::const_iterator iterator;
+    for (iterator it = mInterface.begin (); it != mInterface.end (); ++it)
+    {
+	if (it->obj == obj)
+	    return it->calls[num];
+    }
+
+    return 0;
+}
+
+template <typename T, unsigned int N>
+void WrapableHandler<T,N>::resetCallCounts ()
+{
+    typedef typename std::vector<Interface>::iterator iterator;
+    for (iterator it = mInterface.begin (); it != mInterface.end (); ++it)
+	std::fill_n (it->calls, N, 0);
+}
+
 #endif
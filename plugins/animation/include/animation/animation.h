@@ -1,7 +1,7 @@
 #ifndef _ANIMATION_H
 #define _ANIMATION_H
 
-#define ANIMATION_ABI 20091205
+#define ANIMATION_ABI 20261017
 
 #include <core/core.h>
 #include <core/pluginclasshandler.h>
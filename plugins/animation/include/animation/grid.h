@@ -50,13 +50,12 @@ class GridAnim :
 	     ///< Currently only y offset can be used.
 	};
 
-	inline GridObject *objects () { return mObjects; }
-	inline unsigned int numObjects () { return mNumObjects; }
+	inline GridObject *objects () { return &mObjects[0]; }
+	inline unsigned int numObjects () { return mObjects.size (); }
 	inline Point &scale () { return mScale; }
 
     private:
-	GridObject *mObjects; // TODO: convert to vector
-	unsigned int mNumObjects;
+	std::vector<GridObject> mObjects;
 
 	Point mScale;
 	Point mScaleOrigin;
@@ -86,6 +85,10 @@ protected:
     				///< Default grid size is 2x2.
 				///< Override for custom grid size.
 
+    /// Returns the grid resolution to use for the given configured one,
+    /// which is halved while animations are running over the frame budget.
+    int adaptiveGridRes (int gridRes);
+
 public:
     GridAnim (CompWindow *w,
 	      WindowEvent curWindowEvent,
@@ -29,6 +29,7 @@ public:
     void enableCustomPaintList (bool enabled);
     bool isRestackAnimPossible ();
     bool isAnimEffectPossible (AnimEffect theEffect);
+    bool overFrameBudget ();
     bool otherPluginsActive ();
     bool initiateFocusAnim (AnimWindow *aw);
     
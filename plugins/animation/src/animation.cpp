@@ -88,11 +88,22 @@
 #include <core/core.h>
 #include <opengl/opengl.h>
 #include <sys/time.h>
+#include <time.h>
 #include <assert.h>
 #include "private.h"
 
 using namespace compiz::core;
 
+/// Monotonic time in microseconds, for measuring animation costs
+static unsigned long
+animTimeUsec ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
 class AnimPluginVTable :
     public CompPlugin::VTableForScreenAndWindow<AnimScreen, AnimWindow>
 {
@@ -265,6 +276,20 @@ PrivateAnimScreen::isAnimEffectPossible (AnimEffect theEffect)
     return false;
 }
 
+bool
+PrivateAnimScreen::overFrameBudget ()
+{
+    if (!optionGetAdaptiveQuality ())
+	return false;
+
+    // Also consider the time already spent on this frame, so that
+    // animations started together (e.g. minimizing all windows) can
+    // react before a whole frame has gone over budget.
+    unsigned long budget = optionGetFrameBudget () * 1000UL;
+
+    return mOverFrameBudget || mFrameCost > budget;
+}
+
 bool
 PrivateAnimScreen::isRestackAnimPossible ()
 {
@@ -1099,10 +1124,21 @@ PrivateAnimWindow::postAnimationCleanUpCustom (bool closing,
 
     if (mCurAnimation)
     {
+	if (mPAScreen->optionGetLogFrameCosts () && mCost.frames)
+	    compLogMessage ("animation", CompLogLevelInfo,
+			    "%s on window 0x%lx: %u frames, per frame "
+			    "%lu us step, %lu us geometry, %lu us paint",
+			    mCurAnimation->info ()->name, mWindow->id (),
+			    mCost.frames,
+			    mCost.step / mCost.frames,
+			    mCost.geometry / mCost.frames,
+			    mCost.paint / mCost.frames);
+
 	mCurAnimation->cleanUp (closing, destructing);
 	delete mCurAnimation;
 	mCurAnimation = 0;
     }
+    mCost.reset ();
 
     mBB.x1 = mBB.y1 = MAXSHORT;
     mBB.x2 = mBB.y2 = MINSHORT;
@@ -1324,6 +1360,11 @@ PrivateAnimScreen::preparePaint (int msSinceLastPaint)
 	mLastRedrawTime = curTime; // Store current time for next time
 	mLastRedrawTimeFresh = true;
 
+	// Cost of the animations in the frame painted last
+	mOverFrameBudget =
+	    (mFrameCost > optionGetFrameBudget () * 1000UL);
+	mFrameCost = 0;
+
 	/* Paint list includes destroyed windows */
 	for (CompWindowList::const_reverse_iterator rit = pl.rbegin ();
 	     rit != pl.rend (); ++rit)
@@ -1378,6 +1419,8 @@ PrivateAnimScreen::preparePaint (int msSinceLastPaint)
 		    if (!curAnim->initialized ())
 			curAnim->setInitialized ();
 
+		    unsigned long stepStart = animTimeUsec ();
+
 		    curAnim->step ();
 
 		    if (curAnim->updateBBUsed ())
@@ -1396,6 +1439,12 @@ PrivateAnimScreen::preparePaint (int msSinceLastPaint)
 			      COMPOSITE_SCREEN_DAMAGE_ALL_MASK))
 			    aw->damageThisAndLastStepRegion ();
 		    }
+
+		    unsigned long stepCost = animTimeUsec () - stepStart;
+
+		    aw->mCost.frames++;
+		    aw->mCost.step += stepCost;
+		    mFrameCost += stepCost;
 		}
 
 		bool finished = (curAnim->remainingTime () <= 0);
@@ -1473,6 +1522,9 @@ PrivateAnimScreen::donePaint ()
 	activateEvent (false);
 	mLastRedrawTimeFresh = false;
 
+	mFrameCost = 0;
+	mOverFrameBudget = false;
+
 	// Reset stacking related info after all animations are done.
 	ExtensionPluginAnimation *extPlugin =
 		static_cast<ExtensionPluginAnimation *> (mExtensionPlugins[0]);
@@ -1504,8 +1556,15 @@ PrivateAnimWindow::glAddGeometry (const GLTexture::MatrixList &matrix,
     if (mCurAnimation)
     {
 	if (mCurAnimation->initialized ())
+	{
+	    unsigned long geometryStart = animTimeUsec ();
+
 	    mCurAnimation->addGeometry (matrix, region, clip,
 					maxGridWidth, maxGridHeight);
+
+	    // Not added to the frame cost, glPaint already counts it
+	    mCost.geometry += animTimeUsec () - geometryStart;
+	}
     }
     else
     {
@@ -1666,11 +1725,18 @@ PrivateAnimWindow::glPaint (const GLWindowPaintAttrib &attrib,
     mCurAnimation->updateTransform (wTransform);
     mCurAnimation->prePaintWindow ();
 
+    unsigned long paintStart = animTimeUsec ();
+
     if (mCurAnimation->paintWindowUsed ())
 	status = mCurAnimation->paintWindow (gWindow, wAttrib, wTransform, region, mask);
     else
 	status = gWindow->glPaint (wAttrib, wTransform, region, mask);
 
+    unsigned long paintCost = animTimeUsec () - paintStart;
+
+    mCost.paint += paintCost;
+    mPAScreen->mFrameCost += paintCost;
+
     if (mCurAnimation->postPaintWindowUsed ())
     {
 #if 0 // Not ported yet
@@ -2625,7 +2691,9 @@ PrivateAnimScreen::PrivateAnimScreen (CompScreen *s, AnimScreen *as) :
     mOutput (0),
     mLockedPaintList (NULL),
     mLockedPaintListCnt (0),
-    mGetWindowPaintListEnableCnt (0)
+    mGetWindowPaintListEnableCnt (0),
+    mFrameCost (0),
+    mOverFrameBudget (false)
 {
     for (int i = 0; i < WatchedScreenPluginNum; i++)
 	mPluginActive[i] = false;
@@ -3000,6 +3068,12 @@ AnimScreen::isAnimEffectPossible (AnimEffect theEffect)
     return priv->isAnimEffectPossible (theEffect);
 }
 
+bool
+AnimScreen::overFrameBudget ()
+{
+    return priv->overFrameBudget ();
+}
+
 bool
 AnimScreen::initiateFocusAnim (AnimWindow *aw)
 {
@@ -78,7 +78,9 @@ void
 CurvedFoldAnim::initGrid ()
 {
     mGridWidth = 2;
-    mGridHeight = optValI (AnimationOptions::MagicLampWavyGridRes); // TODO new option
+    // TODO new option
+    mGridHeight =
+	adaptiveGridRes (optValI (AnimationOptions::MagicLampWavyGridRes));
 }
 
 float
@@ -75,7 +75,9 @@ void
 DreamAnim::initGrid ()
 {
     mGridWidth = 2;
-    mGridHeight = optValI (AnimationOptions::MagicLampWavyGridRes); // TODO new option
+    // TODO new option
+    mGridHeight =
+	adaptiveGridRes (optValI (AnimationOptions::MagicLampWavyGridRes));
 }
 
 void
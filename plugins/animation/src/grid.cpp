@@ -61,12 +61,10 @@ GridAnim::GridModel::GridModel (CompWindow *w,
 				int gridHeight,
 				int decorTopHeight,
 				int decorBottomHeight) :
+    mObjects ((unsigned)(gridWidth * gridHeight)),
     mScale (1.0f, 1.0f),
     mScaleOrigin (0, 0)
 {
-    mNumObjects = (unsigned)(gridWidth * gridHeight);
-    mObjects = new GridObject[mNumObjects];
-
     initObjects (curWindowEvent,
 		 height,
 		 gridWidth, gridHeight,
@@ -75,7 +73,6 @@ GridAnim::GridModel::GridModel (CompWindow *w,
 
 GridAnim::GridModel::~GridModel ()
 {
-    delete[] mObjects;
 }
 
 void
@@ -155,18 +152,19 @@ void
 GridAnim::GridModel::move (float tx,
 			   float ty)
 {
-    GridObject *object = mObjects;
-    for (unsigned int i = 0; i < mNumObjects; i++, object++)
+    std::vector<GridObject>::iterator it = mObjects.begin ();
+    for (; it != mObjects.end (); ++it)
     {
-	object->mPosition.add (Point3d (tx, ty, 0));
+	it->mPosition.add (Point3d (tx, ty, 0));
     }
 }
 
 void
 GridAnim::updateBB (CompOutput &output)
 {
-    GridModel::GridObject *object = mModel->mObjects;
-    for (unsigned int i = 0; i < mModel->mNumObjects; i++, object++)
+    GridModel::GridObject *object = mModel->objects ();
+    unsigned int n = mModel->numObjects ();
+    for (unsigned int i = 0; i < n; i++, object++)
     {
 	mAWindow->expandBBWithPoint (object->position ().x () + 0.5,
 				     object->position ().y () + 0.5);
@@ -180,6 +178,16 @@ GridAnim::initGrid ()
     mGridHeight = 2;
 }
 
+int
+GridAnim::adaptiveGridRes (int gridRes)
+{
+    if (!AnimScreen::get (::screen)->overFrameBudget ())
+	return gridRes;
+
+    // Shading needs at least 4 rows
+    return MAX (gridRes / 2, MIN (gridRes, 4));
+}
+
 GridAnim::GridAnim (CompWindow *w,
 		    WindowEvent curWindowEvent,
 		    float duration,
@@ -246,147 +254,127 @@ GridAnim::addGeometry (const GLTexture::MatrixList &matrix,
     GLVertexBuffer *vertexBuffer = gWindow->vertexBuffer ();
     int vSize = vertexBuffer->getVertexStride ();
 
-    // Indentation kept to provide a clean diff with the old code, for now...
-    {
-	int y1 = outRect.y1 ();
-	int x2 = outRect.x2 ();
-	int y2 = outRect.y2 ();
+    int y1 = outRect.y1 ();
+    int x2 = outRect.x2 ();
+    int y2 = outRect.y2 ();
+
+    float gridW = (float)owidth / (mGridWidth - 1);
+    float gridH;
 
-	float gridW = (float)owidth / (mGridWidth - 1);
-	float gridH;
+    // Which part of the window this call covers only depends on outRect,
+    // so every vertex maps to its fractional grid row through the same
+    // function: row = MIN ((y - rowOrigin) * rowScale + rowOffset, rowMax)
+    float rowOrigin = oy;
+    float rowScale;
+    float rowOffset = 0;
+    float rowMax = mGridHeight - 1;
 
-	if (mCurWindowEvent == WindowEventShade ||
-	    mCurWindowEvent == WindowEventUnshade)
+    if (mCurWindowEvent == WindowEventShade ||
+	mCurWindowEvent == WindowEventUnshade)
+    {
+	if (y1 < winContentsY)	// if at top part
 	{
-	    if (y1 < winContentsY)	// if at top part
-	    {
-		gridH = mDecorTopHeight;
-	    }
-	    else if (y2 > winContentsY + winContentsHeight)  // if at bottom
-	    {
-		gridH = mDecorBottomHeight;
-	    }
-	    else			// in window contents (only in Y coords)
-	    {
-		float winContentsHeight =
-		    oheight - (mDecorTopHeight + mDecorBottomHeight);
-		gridH = winContentsHeight / (mGridHeight - 3);
-	    }
+	    gridH = mDecorTopHeight;
+	    rowScale = mDecorTopHeight ? 1.0f / mDecorTopHeight : 0;
+	    rowMax = 0.999;	// avoid 1.0
 	}
-	else
-	    gridH = (float)oheight / (mGridHeight - 1);
-
-	int oldCount = vertexBuffer->countVertices ();
-	gWindow->glAddGeometry (matrix, region, clip, gridW, gridH);
-	int newCount = vertexBuffer->countVertices ();
-	v = vertexBuffer->getVertices () + (oldCount * vSize);
-	vMax = vertexBuffer->getVertices () + (newCount * vSize);
- 
-	// For each vertex
-	for (; v < vMax; v += vSize)
+	else if (y2 > winContentsY + winContentsHeight)  // if at bottom
+	{
+	    gridH = mDecorBottomHeight;
+	    rowOrigin = winContentsY + winContentsHeight;
+	    rowScale = mDecorBottomHeight ? 1.0f / mDecorBottomHeight : 0;
+	    rowOffset = mGridHeight - 2;
+	}
+	else			// in window contents (only in Y coords)
 	{
-	    float x = v[0];
-	    float y = v[1];
-	    float topiyFloat;
+	    rowOrigin = winContentsY;
+	    rowScale = (mGridHeight - 3) / winContentsHeight;
+	    rowOffset = 1;
 
-	    if (y > y2)
-		y = y2;
+	    float winContentsHeight =
+		oheight - (mDecorTopHeight + mDecorBottomHeight);
+	    gridH = winContentsHeight / (mGridHeight - 3);
+	}
+    }
+    else
+    {
+	gridH = (float)oheight / (mGridHeight - 1);
+	rowScale = (mGridHeight - 1) / (float)oheight;
+    }
 
-	    if (mCurWindowEvent == WindowEventShade ||
-		mCurWindowEvent == WindowEventUnshade)
-	    {
-		if (y1 < winContentsY)	// if at top part
-		{
-		    topiyFloat = (y - oy) / mDecorTopHeight;
-		    topiyFloat = MIN (topiyFloat, 0.999);	// avoid 1.0
-		}
-		else if (y2 > winContentsY + winContentsHeight)	// if at bottom
-		{
-		    topiyFloat = (mGridHeight - 2) +
-			(mDecorBottomHeight ? (y - winContentsY -
-					       winContentsHeight) /
-			 mDecorBottomHeight : 0);
-		}
-		else		// in window contents (only in Y coords)
-		{
-		    topiyFloat = (mGridHeight - 3) *
-			(y - winContentsY) / winContentsHeight + 1;
-		}
-	    }
-	    else
-	    {
-		topiyFloat = (mGridHeight - 1) * (y - oy) / oheight;
-	    }
-	    // topiy should be at most (mGridHeight - 2)
-	    int topiy = (int)(topiyFloat + 1e-4);
+    float colScale = (mGridWidth - 1) / (float)owidth;
 
-	    if (topiy == mGridHeight - 1)
-		topiy--;
-	    int bottomiy = topiy + 1;
-	    float iny = topiyFloat - topiy;
-	    float inyRest = 1 - iny;
+    int oldCount = vertexBuffer->countVertices ();
+    gWindow->glAddGeometry (matrix, region, clip, gridW, gridH);
+    int newCount = vertexBuffer->countVertices ();
+    v = vertexBuffer->getVertices () + (oldCount * vSize);
+    vMax = vertexBuffer->getVertices () + (newCount * vSize);
 
-	    // End of calculations for y
+    const GridModel::GridObject *objects = mModel->objects ();
 
-	    // Indentation kept to provide a clean diff with the old code...
-	    {
-		if (x > x2)
-		    x = x2;
-
-		// find containing grid cell (leftix rightix) x (topiy bottomiy)
-		float leftixFloat =
-		    (mGridWidth - 1) * (x - ox) / owidth;
-		int leftix = (int)(leftixFloat + 1e-4);
-
-		if (leftix == mGridWidth - 1)
-		    leftix--;
-		int rightix = leftix + 1;
-
-		// GridModel::GridObjects that are at top, bottom, left, right corners of quad
-		GridModel::GridObject *objToTopLeft =
-		    &(mModel->mObjects[topiy * mGridWidth + leftix]);
-		GridModel::GridObject *objToTopRight =
-		    &(mModel->mObjects[topiy * mGridWidth + rightix]);
-		GridModel::GridObject *objToBottomLeft =
-		    &(mModel->mObjects[bottomiy * mGridWidth + leftix]);
-		GridModel::GridObject *objToBottomRight =
-		    &(mModel->mObjects[bottomiy * mGridWidth + rightix]);
-
-		Point3d &objToTopLeftPos = objToTopLeft->mPosition;
-		Point3d &objToTopRightPos = objToTopRight->mPosition;
-		Point3d &objToBottomLeftPos = objToBottomLeft->mPosition;
-		Point3d &objToBottomRightPos = objToBottomRight->mPosition;
-
-		// find position in cell by taking remainder of flooring
-		float inx = leftixFloat - leftix;
-		float inxRest = 1 - inx;
-
-		// Interpolate to find deformed coordinates
-
-		float hor1x = (inxRest * objToTopLeftPos.x () +
-			       inx * objToTopRightPos.x ());
-		float hor1y = (inxRest * objToTopLeftPos.y () +
-			       inx * objToTopRightPos.y ());
-		float hor1z = (notUsing3dCoords ? 0 :
-			       inxRest * objToTopLeftPos.z () +
-			       inx * objToTopRightPos.z ());
-		float hor2x = (inxRest * objToBottomLeftPos.x () +
-			       inx * objToBottomRightPos.x ());
-		float hor2y = (inxRest * objToBottomLeftPos.y () +
-			       inx * objToBottomRightPos.y ());
-		float hor2z = (notUsing3dCoords ? 0 :
-			       inxRest * objToBottomLeftPos.z () +
-			       inx * objToBottomRightPos.z ());
-
-		float deformedX = inyRest * hor1x + iny * hor2x;
-		float deformedY = inyRest * hor1y + iny * hor2y;
-		float deformedZ = inyRest * hor1z + iny * hor2z;
-
-		v[0] = deformedX;
-		v[1] = deformedY;
-		v[2] = deformedZ;
+    // Deform each new vertex in place in the vertex buffer
+    for (; v < vMax; v += vSize)
+    {
+	float x = MIN (v[0], x2);
+	float y = MIN (v[1], y2);
+
+	// find containing grid cell (leftix rightix) x (topiy bottomiy)
+	float topiyFloat = MIN ((y - rowOrigin) * rowScale + rowOffset, rowMax);
+	float leftixFloat = (x - ox) * colScale;
+
+	// topiy should be at most (mGridHeight - 2)
+	int topiy = (int)(topiyFloat + 1e-4);
+	if (topiy == mGridHeight - 1)
+	    topiy--;
+
+	int leftix = (int)(leftixFloat + 1e-4);
+	if (leftix == mGridWidth - 1)
+	    leftix--;
+
+	// find position in cell by taking remainder of flooring
+	float iny = topiyFloat - topiy;
+	float inyRest = 1 - iny;
+	float inx = leftixFloat - leftix;
+	float inxRest = 1 - inx;
+
+	// GridModel::GridObjects that are at top, bottom, left, right corners
+	// of quad; the right ones directly follow the left ones in a row
+	const GridModel::GridObject *objToTopLeft =
+	    &objects[topiy * mGridWidth + leftix];
+	const GridModel::GridObject *objToBottomLeft =
+	    objToTopLeft + mGridWidth;
+
+	const Point3d &objToTopLeftPos = objToTopLeft[0].mPosition;
+	const Point3d &objToTopRightPos = objToTopLeft[1].mPosition;
+	const Point3d &objToBottomLeftPos = objToBottomLeft[0].mPosition;
+	const Point3d &objToBottomRightPos = objToBottomLeft[1].mPosition;
+
+	// Interpolate to find deformed coordinates
+
+	float hor1x = (inxRest * objToTopLeftPos.x () +
+		       inx * objToTopRightPos.x ());
+	float hor1y = (inxRest * objToTopLeftPos.y () +
+		       inx * objToTopRightPos.y ());
+	float hor2x = (inxRest * objToBottomLeftPos.x () +
+		       inx * objToBottomRightPos.x ());
+	float hor2y = (inxRest * objToBottomLeftPos.y () +
+		       inx * objToBottomRightPos.y ());
+
+	v[0] = inyRest * hor1x + iny * hor2x;
+	v[1] = inyRest * hor1y + iny * hor2y;
+
+	if (notUsing3dCoords)
+	{
+	    v[2] = 0;
+	}
+	else
+	{
+	    float hor1z = (inxRest * objToTopLeftPos.z () +
+			   inx * objToTopRightPos.z ());
+	    float hor2z = (inxRest * objToBottomLeftPos.z () +
+			   inx * objToBottomRightPos.z ());
 
-	    }
+	    v[2] = inyRest * hor1z + iny * hor2z;
 	}
     }
 }
@@ -42,14 +42,16 @@ void
 MagicLampAnim::initGrid ()
 {
     mGridWidth = 2;
-    mGridHeight = optValI (AnimationOptions::MagicLampGridRes);
+    mGridHeight =
+	adaptiveGridRes (optValI (AnimationOptions::MagicLampGridRes));
 }
 
 void
 MagicLampWavyAnim::initGrid ()
 {
     mGridWidth = 2;
-    mGridHeight = optValI (AnimationOptions::MagicLampWavyGridRes);
+    mGridHeight =
+	adaptiveGridRes (optValI (AnimationOptions::MagicLampWavyGridRes));
 }
 
 MagicLampAnim::MagicLampAnim (CompWindow *w,
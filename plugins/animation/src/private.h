@@ -116,6 +116,20 @@ typedef enum
     WatchedWindowPluginNum
 } WatchedWindowPlugin;
 
+/// CPU time in microseconds spent on one animation
+class AnimationCost
+{
+public:
+    AnimationCost () { reset (); }
+
+    void reset () { frames = 0; step = geometry = paint = 0; }
+
+    unsigned int  frames;   ///< Number of steps taken
+    unsigned long step;     ///< Time spent in step and updateBB
+    unsigned long geometry; ///< Time spent in addGeometry
+    unsigned long paint;    ///< Time spent painting, including addGeometry
+};
+
 // This must have the value of the first "effect setting" above
 // in PrivateAnimScreenOptions
 #define NUM_NONEFFECT_OPTIONS AnimationOptions::CurvedFoldAmpMult
@@ -239,6 +253,9 @@ private:
     unsigned int         mLockedPaintListCnt;
     unsigned int         mGetWindowPaintListEnableCnt;
 
+    unsigned long mFrameCost;    ///< Animation CPU time this frame, in usec
+    bool          mOverFrameBudget; ///< Last frame went over frame_budget
+
     void updateEventEffects (AnimEvent e,
 			     bool forRandom,
 			     bool callPost = true);
@@ -289,6 +306,10 @@ public:
     /// Is a restacking animation currently possible?
     bool isRestackAnimPossible ();
 
+    /// Should new animations use cheaper settings to stay within
+    /// the frame budget?
+    bool overFrameBudget ();
+
     void initAnimationList ();
     bool isAnimEffectPossible (AnimEffect theEffect);
     inline CompOutput &output () { return *mOutput; }
@@ -380,6 +401,8 @@ private:
     CompRegion mStepRegion;     ///< Region to damage this step
     CompRegion mLastStepRegion; ///< Region damaged last step
 
+    AnimationCost mCost; ///< Time spent on the current animation
+
     bool mPluginActive[WatchedWindowPluginNum];
 
     // Utility methods
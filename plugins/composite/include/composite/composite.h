@@ -230,6 +230,11 @@ class CompositeScreen :
 	int redrawTime ();
 	int optimalRedrawTime ();
 
+	/**
+	 * Number of X requests issued while painting the last frame
+	 */
+	unsigned long frameRequests ();
+
 	bool handlePaintTimeout ();
 
 	WRAPABLE_HND (0, CompositeScreenInterface, void, preparePaint, int);
@@ -72,11 +72,15 @@ PrivateCompositeScreen::setOption (const CompString  &name,
 	    if (optionGetDetectRefreshRate ())
 		detectRefreshRate ();
 	    break;
+	case CompositeOptions::ProfileFrames:
+	    frameProfiler.clear ();
+	    break;
 	case CompositeOptions::RefreshRate:
 	    if (optionGetDetectRefreshRate ())
 		return false;
 	    redrawTime = 1000 / optionGetRefreshRate ();
 	    optimalRedrawTime = redrawTime;
+	    frameScheduler.setRefreshRate (optionGetRefreshRate ());
 	    break;
 	default:
 	    break;
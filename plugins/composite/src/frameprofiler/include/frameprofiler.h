@@ -0,0 +1,132 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPOSITE_FRAME_PROFILER_H
+#define _COMPOSITE_FRAME_PROFILER_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace compiz
+{
+namespace composite
+{
+namespace profiler
+{
+
+enum Phase
+{
+    PreparePaint = 0,
+    Damage,       /* acknowledging X damage, including the round trip */
+    Paint,        /* includes the buffer swap done by the paint handler */
+    DonePaint,
+    NumPhases
+};
+
+/*
+ * Everything recorded about a single frame. Times are in
+ * microseconds.
+ */
+struct FrameTiming
+{
+    int64_t      start;
+    unsigned int total;
+    unsigned int phase[NumPhases];
+
+    unsigned int windows;
+    unsigned int damagedArea;
+    unsigned int outputs;
+    unsigned int requests;
+};
+
+struct PhaseSummary
+{
+    unsigned int average;
+    unsigned int max;
+};
+
+struct Summary
+{
+    unsigned int frames;
+    unsigned int overBudget;
+    PhaseSummary total;
+    PhaseSummary phase[NumPhases];
+};
+
+/*
+ * Keeps the timings of the last capacity () frames in a ring
+ * buffer. The caller supplies the timestamps, so this knows
+ * nothing about which clock is in use.
+ */
+class FrameProfiler
+{
+    public:
+
+	/* Number of values per frame written by serialize () */
+	static const unsigned int SerializedFields = 5 + NumPhases;
+
+	FrameProfiler (unsigned int capacity = 256);
+
+	void beginFrame (int64_t now);
+	void endPhase (Phase phase, int64_t now);
+	void endFrame (int64_t now);
+
+	/* The frame currently being recorded, for counters */
+	FrameTiming & current ();
+
+	bool recording () const;
+
+	unsigned int capacity () const;
+	unsigned int size () const;
+
+	/* 0 is the oldest frame still in the buffer */
+	const FrameTiming & frame (unsigned int i) const;
+
+	void clear ();
+
+	/* budget is the frame time in microseconds, 0 to ignore it */
+	Summary summarize (unsigned int budget) const;
+
+	/*
+	 * Appends every recorded frame, oldest first, as total,
+	 * the phase times, windows, damaged area, outputs and
+	 * requests.
+	 */
+	void serialize (std::vector<unsigned long> &data) const;
+
+    private:
+
+	std::vector<FrameTiming> mFrames;
+	unsigned int             mNext;
+	unsigned int             mSize;
+
+	FrameTiming mCurrent;
+	int64_t     mLastMark;
+	bool        mRecording;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "frameprofiler.h"
+
+namespace cprof = compiz::composite::profiler;
+
+namespace
+{
+    unsigned int elapsed (int64_t from, int64_t to)
+    {
+	/* Clocks can go backwards on a rollback */
+	if (to < from)
+	    return 0;
+
+	return static_cast <unsigned int> (to - from);
+    }
+}
+
+const unsigned int cprof::FrameProfiler::SerializedFields;
+
+cprof::FrameProfiler::FrameProfiler (unsigned int capacity) :
+    mFrames (capacity ? capacity : 1),
+    mNext (0),
+    mSize (0),
+    mLastMark (0),
+    mRecording (false)
+{
+    memset (&mCurrent, 0, sizeof (mCurrent));
+}
+
+void
+cprof::FrameProfiler::beginFrame (int64_t now)
+{
+    memset (&mCurrent, 0, sizeof (mCurrent));
+    mCurrent.start = now;
+    mLastMark = now;
+    mRecording = true;
+}
+
+void
+cprof::FrameProfiler::endPhase (Phase phase, int64_t now)
+{
+    if (!mRecording)
+	return;
+
+    mCurrent.phase[phase] += elapsed (mLastMark, now);
+    mLastMark = now;
+}
+
+void
+cprof::FrameProfiler::endFrame (int64_t now)
+{
+    if (!mRecording)
+	return;
+
+    mCurrent.total = elapsed (mCurrent.start, now);
+    mRecording = false;
+
+    mFrames[mNext] = mCurrent;
+    mNext = (mNext + 1) % mFrames.size ();
+
+    if (mSize < mFrames.size ())
+	mSize++;
+}
+
+cprof::FrameTiming &
+cprof::FrameProfiler::current ()
+{
+    return mCurrent;
+}
+
+bool
+cprof::FrameProfiler::recording () const
+{
+    return mRecording;
+}
+
+unsigned int
+cprof::FrameProfiler::capacity () const
+{
+    return mFrames.size ();
+}
+
+unsigned int
+cprof::FrameProfiler::size () const
+{
+    return mSize;
+}
+
+const cprof::FrameTiming &
+cprof::FrameProfiler::frame (unsigned int i) const
+{
+    unsigned int first = (mNext + mFrames.size () - mSize) % mFrames.size ();
+
+    return mFrames[(first + i) % mFrames.size ()];
+}
+
+void
+cprof::FrameProfiler::clear ()
+{
+    mNext = 0;
+    mSize = 0;
+    mRecording = false;
+}
+
+cprof::Summary
+cprof::FrameProfiler::summarize (unsigned int budget) const
+{
+    Summary            s;
+    unsigned long long total = 0;
+    unsigned long long phase[NumPhases];
+
+    memset (&s, 0, sizeof (s));
+    memset (phase, 0, sizeof (phase));
+
+    s.frames = mSize;
+
+    for (unsigned int i = 0; i < mSize; i++)
+    {
+	const FrameTiming &f = frame (i);
+
+	total += f.total;
+	if (f.total > s.total.max)
+	    s.total.max = f.total;
+
+	if (budget && f.total > budget)
+	    s.overBudget++;
+
+	for (unsigned int p = 0; p < NumPhases; p++)
+	{
+	    phase[p] += f.phase[p];
+	    if (f.phase[p] > s.phase[p].max)
+		s.phase[p].max = f.phase[p];
+	}
+    }
+
+    if (mSize)
+    {
+	s.total.average = total / mSize;
+
+	for (unsigned int p = 0; p < NumPhases; p++)
+	    s.phase[p].average = phase[p] / mSize;
+    }
+
+    return s;
+}
+
+void
+cprof::FrameProfiler::serialize (std::vector<unsigned long> &data) const
+{
+    data.reserve (data.size () + mSize * SerializedFields);
+
+    for (unsigned int i = 0; i < mSize; i++)
+    {
+	const FrameTiming &f = frame (i);
+
+	data.push_back (f.total);
+
+	for (unsigned int p = 0; p < NumPhases; p++)
+	    data.push_back (f.phase[p]);
+
+	data.push_back (f.windows);
+	data.push_back (f.damagedArea);
+	data.push_back (f.outputs);
+	data.push_back (f.requests);
+    }
+}
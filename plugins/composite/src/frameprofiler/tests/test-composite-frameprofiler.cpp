@@ -0,0 +1,180 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "frameprofiler.h"
+
+namespace cprof = compiz::composite::profiler;
+
+class CompositeFrameProfilerTest :
+    public ::testing::Test
+{
+    public:
+
+	CompositeFrameProfilerTest () :
+	    profiler (4)
+	{
+	}
+
+	/* Records a frame starting at start which spends
+	 * prepare, paint and done microseconds in each phase */
+	void recordFrame (int64_t      start,
+			  unsigned int prepare,
+			  unsigned int paint,
+			  unsigned int done)
+	{
+	    profiler.beginFrame (start);
+	    profiler.endPhase (cprof::PreparePaint, start + prepare);
+	    profiler.endPhase (cprof::Damage, start + prepare);
+	    profiler.endPhase (cprof::Paint, start + prepare + paint);
+	    profiler.endPhase (cprof::DonePaint, start + prepare + paint + done);
+	    profiler.endFrame (start + prepare + paint + done);
+	}
+
+	cprof::FrameProfiler profiler;
+};
+
+TEST_F (CompositeFrameProfilerTest, EmptyToBegin)
+{
+    EXPECT_EQ (0, profiler.size ());
+    EXPECT_EQ (4, profiler.capacity ());
+    EXPECT_FALSE (profiler.recording ());
+}
+
+TEST_F (CompositeFrameProfilerTest, RecordsPhaseTimes)
+{
+    recordFrame (1000, 10, 200, 30);
+
+    ASSERT_EQ (1, profiler.size ());
+
+    const cprof::FrameTiming &f = profiler.frame (0);
+
+    EXPECT_EQ (1000, f.start);
+    EXPECT_EQ (240, f.total);
+    EXPECT_EQ (10, f.phase[cprof::PreparePaint]);
+    EXPECT_EQ (0, f.phase[cprof::Damage]);
+    EXPECT_EQ (200, f.phase[cprof::Paint]);
+    EXPECT_EQ (30, f.phase[cprof::DonePaint]);
+}
+
+TEST_F (CompositeFrameProfilerTest, CountersGoToCurrentFrame)
+{
+    profiler.beginFrame (0);
+    profiler.current ().windows = 12;
+    profiler.current ().damagedArea = 640 * 480;
+    profiler.endFrame (10);
+
+    EXPECT_EQ (12, profiler.frame (0).windows);
+    EXPECT_EQ (640 * 480, profiler.frame (0).damagedArea);
+}
+
+TEST_F (CompositeFrameProfilerTest, UnfinishedFrameNotRecorded)
+{
+    profiler.beginFrame (0);
+    profiler.endPhase (cprof::PreparePaint, 5);
+
+    EXPECT_TRUE (profiler.recording ());
+    EXPECT_EQ (0, profiler.size ());
+}
+
+TEST_F (CompositeFrameProfilerTest, ClockRollbackClampsToZero)
+{
+    recordFrame (1000, 10, 0, 0);
+
+    profiler.beginFrame (2000);
+    profiler.endPhase (cprof::PreparePaint, 1500);
+    profiler.endFrame (1500);
+
+    EXPECT_EQ (0, profiler.frame (1).total);
+    EXPECT_EQ (0, profiler.frame (1).phase[cprof::PreparePaint]);
+}
+
+TEST_F (CompositeFrameProfilerTest, RingBufferKeepsNewestFrames)
+{
+    for (unsigned int i = 0; i < 6; i++)
+	recordFrame (i * 1000, i, 0, 0);
+
+    ASSERT_EQ (4, profiler.size ());
+
+    /* Frames 0 and 1 got overwritten, 2 is now the oldest */
+    for (unsigned int i = 0; i < 4; i++)
+	EXPECT_EQ ((i + 2) * 1000, profiler.frame (i).start);
+}
+
+TEST_F (CompositeFrameProfilerTest, ClearDropsFrames)
+{
+    recordFrame (0, 1, 1, 1);
+    profiler.clear ();
+
+    EXPECT_EQ (0, profiler.size ());
+}
+
+TEST_F (CompositeFrameProfilerTest, Summarize)
+{
+    recordFrame (0, 10, 1000, 10);
+    recordFrame (20000, 20, 20000, 30);
+
+    cprof::Summary s = profiler.summarize (16666);
+
+    EXPECT_EQ (2, s.frames);
+    EXPECT_EQ (1, s.overBudget);
+    EXPECT_EQ (15, s.phase[cprof::PreparePaint].average);
+    EXPECT_EQ (20, s.phase[cprof::PreparePaint].max);
+    EXPECT_EQ (10500, s.phase[cprof::Paint].average);
+    EXPECT_EQ (20000, s.phase[cprof::Paint].max);
+    EXPECT_EQ ((1020 + 20050) / 2, s.total.average);
+    EXPECT_EQ (20050, s.total.max);
+}
+
+TEST_F (CompositeFrameProfilerTest, SummarizeWithoutBudget)
+{
+    recordFrame (0, 0, 100000, 0);
+
+    EXPECT_EQ (0, profiler.summarize (0).overBudget);
+}
+
+TEST_F (CompositeFrameProfilerTest, SerializeOldestFirst)
+{
+    recordFrame (0, 1, 2, 3);
+    profiler.beginFrame (100);
+    profiler.current ().windows = 4;
+    profiler.current ().damagedArea = 5;
+    profiler.current ().outputs = 6;
+    profiler.current ().requests = 7;
+    profiler.endFrame (108);
+
+    std::vector<unsigned long> data;
+    profiler.serialize (data);
+
+    ASSERT_EQ (2 * cprof::FrameProfiler::SerializedFields, data.size ());
+
+    unsigned long expected[] =
+    {
+	6, 1, 0, 2, 3, 0, 0, 0, 0,
+	8, 0, 0, 0, 0, 4, 5, 6, 7
+    };
+
+    for (unsigned int i = 0; i < data.size (); i++)
+	EXPECT_EQ (expected[i], data[i]);
+}
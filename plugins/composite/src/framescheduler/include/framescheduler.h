@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPOSITE_FRAME_SCHEDULER_H
+#define _COMPOSITE_FRAME_SCHEDULER_H
+
+#include <stdint.h>
+
+namespace compiz
+{
+namespace composite
+{
+namespace scheduler
+{
+
+/*
+ * Source of timestamps in microseconds. Only differences between
+ * values are meaningful.
+ */
+class Clock
+{
+    public:
+
+	virtual ~Clock () {}
+
+	virtual int64_t now () = 0;
+};
+
+/* CLOCK_MONOTONIC, so it never jumps with the wall clock */
+class MonotonicClock :
+    public Clock
+{
+    public:
+
+	int64_t now ();
+};
+
+/*
+ * Decides when the next frame should start painting.
+ *
+ * Without vsync frames are simply paced one refresh period apart.
+ *
+ * With vsync the end of each frame is taken to be a vblank, which
+ * gives the phase of the refresh. The next frame then starts as
+ * late as possible while still expecting to finish before a vblank,
+ * so that whatever it shows is as recent as possible. The time a
+ * frame needs is learnt from recent frames: the estimate creeps
+ * down while frames make their vblank and backs off when one
+ * misses it. Since a frame that blocks on vsync tells us nothing
+ * about how much earlier it could have started, the level it
+ * missed at is remembered for a while so we don't keep probing.
+ */
+class FrameScheduler
+{
+    public:
+
+	/* Slack for timer wakeup latency, in microseconds */
+	static const unsigned int SafetyMargin = 2000;
+
+	FrameScheduler (Clock &clock);
+
+	void setRefreshRate (unsigned int hz);
+	unsigned int refreshPeriod () const;
+
+	void setVSync (bool vsync);
+	bool vsync () const;
+
+	/*
+	 * Microseconds from now until the next frame should start.
+	 * With vsync this also picks the vblank that frame aims for.
+	 */
+	unsigned int delay ();
+
+	void frameStarted ();
+	void frameFinished ();
+
+	/* Current estimate of the time a frame needs */
+	unsigned int renderCost () const;
+
+	/* The vblank the next frame aims for */
+	bool haveTarget () const;
+	int64_t targetVBlank () const;
+
+	/* Frames which finished a refresh later than they aimed for */
+	unsigned int missedFrames () const;
+
+    private:
+
+	void frameMissed ();
+	void frameMade ();
+
+	Clock        &mClock;
+
+	unsigned int mPeriod;
+	bool         mVSync;
+
+	unsigned int mCost;
+	unsigned int mFloor;
+
+	int64_t      mStart;
+	int64_t      mVBlank;
+	int64_t      mTarget;
+
+	bool         mHaveTarget;
+	bool         mHaveStart;
+	bool         mHaveVBlank;
+	bool         mPainting;
+	unsigned int mMissed;
+};
+
+}
+}
+}
+
+#endif
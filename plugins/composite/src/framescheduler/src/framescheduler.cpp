@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <time.h>
+
+#include "framescheduler.h"
+
+namespace cs = compiz::composite::scheduler;
+
+namespace
+{
+    const unsigned int DEFAULT_REFRESH_RATE = 60;
+}
+
+const unsigned int cs::FrameScheduler::SafetyMargin;
+
+int64_t
+cs::MonotonicClock::now ()
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+cs::FrameScheduler::FrameScheduler (Clock &clock) :
+    mClock (clock),
+    mPeriod (1000000 / DEFAULT_REFRESH_RATE),
+    mVSync (false),
+    mCost (mPeriod / 2),
+    mFloor (0),
+    mStart (0),
+    mVBlank (0),
+    mTarget (0),
+    mHaveTarget (false),
+    mHaveStart (false),
+    mHaveVBlank (false),
+    mPainting (false),
+    mMissed (0)
+{
+}
+
+void
+cs::FrameScheduler::setRefreshRate (unsigned int hz)
+{
+    if (!hz)
+	return;
+
+    mPeriod = 1000000 / hz;
+
+    if (mCost > mPeriod)
+	mCost = mPeriod;
+    if (mFloor > mPeriod)
+	mFloor = mPeriod;
+}
+
+unsigned int
+cs::FrameScheduler::refreshPeriod () const
+{
+    return mPeriod;
+}
+
+void
+cs::FrameScheduler::setVSync (bool vsync)
+{
+    if (vsync == mVSync)
+	return;
+
+    /* Whatever we knew about the refresh phase is useless now */
+    mVSync = vsync;
+    mHaveVBlank = false;
+    mHaveTarget = false;
+}
+
+bool
+cs::FrameScheduler::vsync () const
+{
+    return mVSync;
+}
+
+unsigned int
+cs::FrameScheduler::delay ()
+{
+    int64_t now = mClock.now ();
+    int64_t start;
+
+    mHaveTarget = false;
+
+    if (!mVSync)
+    {
+	if (!mHaveStart)
+	    return 0;
+
+	start = mStart + mPeriod;
+    }
+    else
+    {
+	if (!mHaveVBlank)
+	    return 0;
+
+	/* The first vblank after the last one we saw that we can
+	 * still make if we start right away */
+	int64_t earliest = now + mCost + SafetyMargin;
+	int64_t periods = (earliest - mVBlank + mPeriod - 1) / mPeriod;
+
+	if (periods < 1)
+	    periods = 1;
+
+	mTarget = mVBlank + periods * mPeriod;
+	mHaveTarget = true;
+	start = mTarget - mCost - SafetyMargin;
+    }
+
+    return start > now ? start - now : 0;
+}
+
+void
+cs::FrameScheduler::frameStarted ()
+{
+    mStart = mClock.now ();
+    mHaveStart = true;
+    mPainting = true;
+}
+
+void
+cs::FrameScheduler::frameFinished ()
+{
+    if (!mPainting)
+	return;
+
+    int64_t now = mClock.now ();
+
+    mPainting = false;
+
+    if (!mVSync)
+	return;
+
+    if (mHaveTarget)
+    {
+	if (now > mTarget + mPeriod / 2)
+	    frameMissed ();
+	else
+	    frameMade ();
+    }
+
+    /* The swap returns on the vblank */
+    mVBlank = now;
+    mHaveVBlank = true;
+    mHaveTarget = false;
+}
+
+void
+cs::FrameScheduler::frameMissed ()
+{
+    unsigned int floor = mCost + mCost / 2 + SafetyMargin / 2;
+
+    mMissed++;
+
+    if (floor > mPeriod)
+	floor = mPeriod;
+    if (floor > mFloor)
+	mFloor = floor;
+
+    mCost = mFloor;
+}
+
+void
+cs::FrameScheduler::frameMade ()
+{
+    unsigned int step = mCost / 32 + 1;
+
+    mCost = mCost > mFloor + step ? mCost - step : mFloor;
+
+    /* Slowly forget about old misses in case frames got cheaper */
+    if (mFloor)
+	mFloor -= mFloor / 4096 + 1;
+}
+
+unsigned int
+cs::FrameScheduler::renderCost () const
+{
+    return mCost;
+}
+
+bool
+cs::FrameScheduler::haveTarget () const
+{
+    return mHaveTarget;
+}
+
+int64_t
+cs::FrameScheduler::targetVBlank () const
+{
+    return mTarget;
+}
+
+unsigned int
+cs::FrameScheduler::missedFrames () const
+{
+    return mMissed;
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "framescheduler.h"
+
+namespace cs = compiz::composite::scheduler;
+
+namespace
+{
+    const unsigned int PERIOD = 1000000 / 60;
+
+    class SimulatedClock :
+	public cs::Clock
+    {
+	public:
+
+	    SimulatedClock () : time (1000000) {}
+
+	    int64_t now () { return time; }
+
+	    int64_t time;
+    };
+
+    /*
+     * Stands in for the paint handler: painting takes cost
+     * microseconds and with vsync the swap then blocks until
+     * the next vblank of a display whose refresh started at
+     * phase.
+     */
+    class FakePaintHandler
+    {
+	public:
+
+	    FakePaintHandler (SimulatedClock &clock) :
+		clock (clock),
+		vsync (true),
+		phase (1234),
+		cost (3000)
+	    {
+	    }
+
+	    void paint ()
+	    {
+		clock.time += cost;
+
+		if (vsync)
+		{
+		    int64_t since = (clock.time - phase) % PERIOD;
+
+		    if (since)
+			clock.time += PERIOD - since;
+		}
+	    }
+
+	    SimulatedClock &clock;
+	    bool           vsync;
+	    int64_t        phase;
+	    unsigned int   cost;
+    };
+}
+
+class CompositeFrameSchedulerTest :
+    public ::testing::Test
+{
+    public:
+
+	CompositeFrameSchedulerTest () :
+	    paintHandler (clock),
+	    scheduler (clock)
+	{
+	    scheduler.setRefreshRate (60);
+	}
+
+	/* Waits for the scheduled time and paints a frame, returns
+	 * how long it took from starting to paint to the frame
+	 * being shown */
+	unsigned int runFrame ()
+	{
+	    clock.time += scheduler.delay ();
+
+	    int64_t start = clock.time;
+
+	    scheduler.frameStarted ();
+	    paintHandler.paint ();
+	    scheduler.frameFinished ();
+
+	    return clock.time - start;
+	}
+
+	SimulatedClock       clock;
+	FakePaintHandler     paintHandler;
+	cs::FrameScheduler   scheduler;
+};
+
+TEST_F (CompositeFrameSchedulerTest, RefreshPeriod)
+{
+    EXPECT_EQ (PERIOD, scheduler.refreshPeriod ());
+
+    scheduler.setRefreshRate (50);
+    EXPECT_EQ (20000, scheduler.refreshPeriod ());
+
+    /* Ignored */
+    scheduler.setRefreshRate (0);
+    EXPECT_EQ (20000, scheduler.refreshPeriod ());
+}
+
+TEST_F (CompositeFrameSchedulerTest, CostNeverExceedsPeriod)
+{
+    scheduler.setRefreshRate (1000);
+    EXPECT_LE (scheduler.renderCost (), scheduler.refreshPeriod ());
+}
+
+TEST_F (CompositeFrameSchedulerTest, FirstFrameStartsImmediately)
+{
+    EXPECT_EQ (0, scheduler.delay ());
+
+    scheduler.setVSync (true);
+    EXPECT_EQ (0, scheduler.delay ());
+    EXPECT_FALSE (scheduler.haveTarget ());
+}
+
+TEST_F (CompositeFrameSchedulerTest, WithoutVSyncFramesArePaced)
+{
+    paintHandler.vsync = false;
+
+    runFrame ();
+    EXPECT_EQ (PERIOD - paintHandler.cost, scheduler.delay ());
+
+    /* Already late */
+    clock.time += PERIOD;
+    EXPECT_EQ (0, scheduler.delay ());
+}
+
+TEST_F (CompositeFrameSchedulerTest, VSyncAimsForNextVBlank)
+{
+    scheduler.setVSync (true);
+
+    runFrame ();
+
+    int64_t vblank = clock.time;
+    unsigned int delay = scheduler.delay ();
+
+    ASSERT_TRUE (scheduler.haveTarget ());
+    EXPECT_EQ (vblank + PERIOD, scheduler.targetVBlank ());
+    EXPECT_EQ (PERIOD - scheduler.renderCost () -
+	       cs::FrameScheduler::SafetyMargin, delay);
+}
+
+TEST_F (CompositeFrameSchedulerTest, VSyncSkipsVBlankTooCloseToMake)
+{
+    scheduler.setVSync (true);
+
+    runFrame ();
+
+    int64_t vblank = clock.time;
+
+    /* Woken up too late to make the next vblank */
+    clock.time += PERIOD - 1000;
+    EXPECT_LT (scheduler.delay (), PERIOD);
+    EXPECT_EQ (vblank + 2 * PERIOD, scheduler.targetVBlank ());
+}
+
+TEST_F (CompositeFrameSchedulerTest, VSyncLatencyConverges)
+{
+    scheduler.setVSync (true);
+
+    for (unsigned int i = 0; i < 600; i++)
+	runFrame ();
+
+    unsigned int missed = scheduler.missedFrames ();
+    unsigned int latency = 0;
+
+    for (unsigned int i = 0; i < 600; i++)
+	latency += runFrame ();
+
+    latency /= 600;
+
+    /* Painting right after the vblank like we used to would
+     * give a latency of a whole period */
+    EXPECT_LT (latency, paintHandler.cost + PERIOD / 4);
+    EXPECT_GE (scheduler.renderCost (), paintHandler.cost -
+	       cs::FrameScheduler::SafetyMargin);
+    EXPECT_LE (scheduler.missedFrames () - missed, 2);
+}
+
+TEST_F (CompositeFrameSchedulerTest, VSyncBacksOffAfterMiss)
+{
+    scheduler.setVSync (true);
+
+    for (unsigned int i = 0; i < 300; i++)
+	runFrame ();
+
+    unsigned int missed = scheduler.missedFrames ();
+
+    /* Frames suddenly get a lot more expensive */
+    paintHandler.cost = 10000;
+
+    for (unsigned int i = 0; i < 10; i++)
+	runFrame ();
+
+    EXPECT_GT (scheduler.missedFrames (), missed);
+    EXPECT_GE (scheduler.renderCost () + cs::FrameScheduler::SafetyMargin,
+	       paintHandler.cost);
+
+    /* And it settles again */
+    missed = scheduler.missedFrames ();
+
+    for (unsigned int i = 0; i < 300; i++)
+	runFrame ();
+
+    EXPECT_LE (scheduler.missedFrames () - missed, 1);
+}
+
+TEST_F (CompositeFrameSchedulerTest, ToggleVSyncForgetsPhase)
+{
+    scheduler.setVSync (true);
+    runFrame ();
+
+    scheduler.setVSync (false);
+    scheduler.setVSync (true);
+
+    EXPECT_EQ (0, scheduler.delay ());
+    EXPECT_FALSE (scheduler.haveTarget ());
+}
+
+TEST_F (CompositeFrameSchedulerTest, FinishWithoutStartIgnored)
+{
+    scheduler.setVSync (true);
+    scheduler.frameFinished ();
+
+    EXPECT_EQ (0, scheduler.delay ());
+}
+
+TEST (CompositeMonotonicClock, NeverGoesBackwards)
+{
+    cs::MonotonicClock clock;
+
+    int64_t last = clock.now ();
+
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+	int64_t now = clock.now ();
+
+	EXPECT_GE (now, last);
+	last = now;
+    }
+}
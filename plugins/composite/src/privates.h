@@ -36,6 +36,8 @@
 #include <map>
 
 #include "pixmapbinding.h"
+#include "frameprofiler.h"
+#include "framescheduler.h"
 #include "composite_options.h"
 
 extern CompPlugin::VTable *compositeVTable;
@@ -66,6 +68,12 @@ class PrivateCompositeScreen :
 
 	void scheduleRepaint ();
 
+	bool subtractDamages ();
+
+	bool dumpFrameTimings (CompAction         *action,
+			       CompAction::State  state,
+			       CompOption::Vector &options);
+
     public:
 
 	CompositeScreen *cScreen;
@@ -95,7 +103,10 @@ class PrivateCompositeScreen :
 	int overlayWindowCount;
 	bool outputShapeChanged;
 
-	struct timeval lastRedraw;
+	compiz::composite::scheduler::MonotonicClock clock;
+	compiz::composite::scheduler::FrameScheduler frameScheduler;
+
+	int64_t        lastRedraw;
 	int            redrawTime;
 	int            optimalRedrawTime;
 	bool           scheduled, painting, reschedule;
@@ -115,6 +126,15 @@ class PrivateCompositeScreen :
 
 	/* Map Damage handle to its bounding box */
 	std::map<Damage, XRectangle> damages;
+
+	/* Reused for every XDamageSubtract instead of a new region each */
+	XserverRegion damageSubtractRegion;
+
+	/* X requests issued by the last painted frame */
+	unsigned long frameRequests;
+
+	compiz::composite::profiler::FrameProfiler frameProfiler;
+	Atom                                       frameTimingsAtom;
 };
 
 class PrivateCompositeWindow :
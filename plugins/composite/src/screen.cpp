@@ -45,6 +45,8 @@
 
 #include <core/timer.h>
 
+namespace cprof = compiz::composite::profiler;
+
 template class WrapableInterface<CompositeScreen, CompositeScreenInterface>;
 
 static const int FALLBACK_REFRESH_RATE = 60;   /* if all else fails */
@@ -300,6 +302,9 @@ PrivateCompositeScreen::PrivateCompositeScreen (CompositeScreen *cs) :
     windowPaintOffset (0, 0),
     overlayWindowCount (0),
     outputShapeChanged (false),
+    clock (),
+    frameScheduler (clock),
+    lastRedraw (clock.now ()),
     redrawTime (1000 / FALLBACK_REFRESH_RATE),
     optimalRedrawTime (1000 / FALLBACK_REFRESH_RATE),
     scheduled (false),
@@ -310,13 +315,18 @@ PrivateCompositeScreen::PrivateCompositeScreen (CompositeScreen *cs) :
     FPSLimiterMode (CompositeFPSLimiterModeDefault),
     withDestroyedWindows (),
     cmSnAtom (0),
-    newCmSnOwner (None)
+    newCmSnOwner (None),
+    damageSubtractRegion (None),
+    frameRequests (0),
+    frameProfiler (),
+    frameTimingsAtom (XInternAtom (screen->dpy (), "_COMPIZ_FRAME_TIMINGS", 0))
 {
-    gettimeofday (&lastRedraw, 0);
     // wrap outputChangeNotify
     ScreenInterface::setHandler (screen);
 
     optionSetSlowAnimationsKeyInitiate (CompositeScreen::toggleSlowAnimations);
+    optionSetDumpFrameTimingsKeyInitiate (
+	boost::bind (&PrivateCompositeScreen::dumpFrameTimings, this, _1, _2, _3));
 }
 
 PrivateCompositeScreen::~PrivateCompositeScreen ()
@@ -328,6 +338,9 @@ PrivateCompositeScreen::~PrivateCompositeScreen ()
 
     if (newCmSnOwner != None)
 	XDestroyWindow (dpy, newCmSnOwner);
+
+    if (damageSubtractRegion != None)
+	XFixesDestroyRegion (dpy, damageSubtractRegion);
 }
 
 bool
@@ -700,11 +713,13 @@ PrivateCompositeScreen::detectRefreshRate ()
 	screen->setOptionForPlugin ("composite", "refresh_rate", value);
 	mOptions[CompositeOptions::DetectRefreshRate].value ().set (true);
 	optimalRedrawTime = redrawTime = 1000 / value.i ();
+	frameScheduler.setRefreshRate (value.i ());
     }
     else
     {
 	redrawTime = 1000 / optionGetRefreshRate ();
 	optimalRedrawTime = redrawTime;
+	frameScheduler.setRefreshRate (optionGetRefreshRate ());
     }
 }
 
@@ -735,19 +750,22 @@ PrivateCompositeScreen::scheduleRepaint ()
     scheduled = true;
 
     int delay;
-    if (FPSLimiterMode == CompositeFPSLimiterModeVSyncLike ||
-	(pHnd && pHnd->hasVSync ()))
+    if (FPSLimiterMode == CompositeFPSLimiterModeVSyncLike)
     {
 	delay = 1;
     }
     else
     {
-	struct timeval now;
-	gettimeofday (&now, 0);
-	int elapsed = compiz::core::timer::timeval_diff (&now, &lastRedraw);
-	if (elapsed < 0)
-	    elapsed = 0;
- 	delay = elapsed < optimalRedrawTime ? optimalRedrawTime - elapsed : 1;
+	/*
+	 * With vsync this starts the frame just early enough to make
+	 * the next vblank, otherwise frames are paced a refresh apart.
+	 * CompTimer has millisecond resolution, so round down and
+	 * never go below 1 ms.
+	 */
+	frameScheduler.setVSync (pHnd && pHnd->hasVSync ());
+	delay = frameScheduler.delay () / 1000;
+	if (delay < 1)
+	    delay = 1;
     }
 
     paintTimer.start
@@ -755,6 +773,41 @@ PrivateCompositeScreen::scheduleRepaint ()
 	delay);
 }
 
+/*
+ * Acknowledges the damage reported since the last frame, so that the
+ * server reports anything drawn from now on again. All windows share
+ * one XFixes region, which makes it two requests per damaged window.
+ * Returns false if there was nothing to acknowledge.
+ */
+bool
+PrivateCompositeScreen::subtractDamages ()
+{
+    if (damages.empty ())
+	return false;
+
+    Display *dpy = screen->dpy ();
+
+    if (damageSubtractRegion == None)
+	damageSubtractRegion = XFixesCreateRegion (dpy, NULL, 0);
+
+    std::map<Damage, XRectangle>::iterator d = damages.begin ();
+    for (; d != damages.end (); ++d)
+    {
+	XFixesSetRegion (dpy, damageSubtractRegion, &d->second, 1);
+	XDamageSubtract (dpy, d->first, damageSubtractRegion, None);
+    }
+
+    damages.clear ();
+
+    return true;
+}
+
+unsigned long
+CompositeScreen::frameRequests ()
+{
+    return priv->frameRequests;
+}
+
 int
 CompositeScreen::redrawTime ()
 {
@@ -770,11 +823,15 @@ CompositeScreen::optimalRedrawTime ()
 bool
 CompositeScreen::handlePaintTimeout ()
 {
-    struct      timeval tv;
+    int64_t     now;
+    Display     *dpy = screen->dpy ();
+    unsigned long firstRequest = NextRequest (dpy);
+    bool        profile = priv->optionGetProfileFrames ();
 
     priv->painting = true;
     priv->reschedule = false;
-    gettimeofday (&tv, 0);
+    now = priv->clock.now ();
+    priv->frameScheduler.frameStarted ();
 
     if (priv->damageMask)
     {
@@ -783,11 +840,8 @@ CompositeScreen::handlePaintTimeout ()
 	if (priv->pHnd)
 	    priv->pHnd->prepareDrawing ();
 
-	timeDiff = compiz::core::timer::timeval_diff (&tv, &priv->lastRedraw);
+	timeDiff = (now - priv->lastRedraw) / 1000;
 
-	/* handle clock rollback */
-	if (timeDiff < 0)
-	    timeDiff = 0;
 	/*
 	 * Now that we use a "tickless" timing algorithm, timeDiff could be
 	 * very large if the screen is truely idle.
@@ -799,8 +853,15 @@ CompositeScreen::handlePaintTimeout ()
 	    timeDiff = priv->optimalRedrawTime;
 
 	priv->redrawTime = timeDiff;
+
+	if (profile)
+	    priv->frameProfiler.beginFrame (priv->clock.now ());
+
 	preparePaint (priv->slowAnimations ? 1 : timeDiff);
 
+	if (profile)
+	    priv->frameProfiler.endPhase (cprof::PreparePaint, priv->clock.now ());
+
 	/* substract top most overlay window region */
 	if (priv->overlayWindowCount)
 	{
@@ -834,25 +895,36 @@ CompositeScreen::handlePaintTimeout ()
 		damageScreen ();
 	}
 
-	Display *dpy = screen->dpy ();
-	std::map<Damage, XRectangle>::iterator d = priv->damages.begin ();
-	for (; d != priv->damages.end (); ++d)
-	{
-	    XserverRegion sub = XFixesCreateRegion (dpy, &d->second, 1);
-	    if (sub != None)
-	    {
-		XDamageSubtract (dpy, d->first, sub, None);
-		XFixesDestroyRegion (dpy, sub);
-	    }
-	}
-	XSync (dpy, False);
-	priv->damages.clear ();
+	/* The subtracts have to be processed before we read from the
+	 * window pixmaps, otherwise damage done in between gets lost.
+	 * Frames driven only by plugins don't need the round trip. */
+	if (priv->subtractDamages ())
+	    XSync (dpy, False);
 
 	priv->damage = CompRegion ();
 
 	int mask = priv->damageMask;
 	priv->damageMask = 0;
 
+	if (profile)
+	{
+	    cprof::FrameTiming &frame = priv->frameProfiler.current ();
+	    unsigned int       area = 0;
+
+	    if (mask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK)
+		area = screen->width () * screen->height ();
+	    else
+	    {
+		foreach (const CompRect &r, priv->tmpRegion.rects ())
+		    area += r.area ();
+	    }
+
+	    frame.windows = screen->windows ().size ();
+	    frame.damagedArea = area;
+
+	    priv->frameProfiler.endPhase (cprof::Damage, priv->clock.now ());
+	}
+
 	CompOutput::ptrList outputs (0);
 
 	if (priv->optionGetForceIndependentOutputPainting ()
@@ -866,9 +938,14 @@ CompositeScreen::handlePaintTimeout ()
 
 	paint (outputs, mask);
 
+	if (profile)
+	    priv->frameProfiler.endPhase (cprof::Paint, priv->clock.now ());
 
 	donePaint ();
 
+	if (profile)
+	    priv->frameProfiler.endPhase (cprof::DonePaint, priv->clock.now ());
+
 	priv->outputShapeChanged = false;
 
 	foreach (CompWindow *w, screen->windows ())
@@ -879,9 +956,23 @@ CompositeScreen::handlePaintTimeout ()
 		break;
 	    }
 	}
+
+	priv->frameRequests = NextRequest (dpy) - firstRequest;
+
+	if (profile)
+	{
+	    cprof::FrameTiming &frame = priv->frameProfiler.current ();
+
+	    frame.outputs = outputs.size ();
+	    frame.requests = priv->frameRequests;
+
+	    priv->frameProfiler.endFrame (priv->clock.now ());
+	}
+
+	priv->frameScheduler.frameFinished ();
     }
 
-    priv->lastRedraw = tv;
+    priv->lastRedraw = now;
     priv->painting = false;
     priv->scheduled = false;
     if (priv->reschedule)
@@ -981,6 +1072,45 @@ PrivateCompositeScreen::outputChangeNotify ()
     cScreen->damageScreen ();
 }
 
+bool
+PrivateCompositeScreen::dumpFrameTimings (CompAction         *action,
+					  CompAction::State  state,
+					  CompOption::Vector &options)
+{
+    std::vector<unsigned long> data;
+    cprof::Summary             s;
+
+    s = frameProfiler.summarize (optimalRedrawTime * 1000);
+
+    compLogMessage ("composite", CompLogLevelInfo,
+		    "%u frames, %u over budget. Average/max in microseconds: "
+		    "total %u/%u, preparePaint %u/%u, damage %u/%u, "
+		    "paint %u/%u, donePaint %u/%u",
+		    s.frames, s.overBudget,
+		    s.total.average, s.total.max,
+		    s.phase[cprof::PreparePaint].average,
+		    s.phase[cprof::PreparePaint].max,
+		    s.phase[cprof::Damage].average,
+		    s.phase[cprof::Damage].max,
+		    s.phase[cprof::Paint].average,
+		    s.phase[cprof::Paint].max,
+		    s.phase[cprof::DonePaint].average,
+		    s.phase[cprof::DonePaint].max);
+
+    /* One run of FrameProfiler::SerializedFields values per
+     * frame, oldest first */
+    frameProfiler.serialize (data);
+
+    if (data.empty ())
+	XDeleteProperty (screen->dpy (), screen->root (), frameTimingsAtom);
+    else
+	XChangeProperty (screen->dpy (), screen->root (), frameTimingsAtom,
+			 XA_CARDINAL, 32, PropModeReplace,
+			 (unsigned char *) &data[0], data.size ());
+
+    return true;
+}
+
 bool
 CompositeScreen::toggleSlowAnimations (CompAction         *action,
 				       CompAction::State  state,
@@ -243,18 +243,60 @@ DecorWindow::glDecorate (const GLMatrix     &transform,
 	if (updateMatrix)
 	    updateDecorationScale ();
 
-	for (int i = 0; i < wd->nQuad; i++)
+	/* Plugins wrapping glAddGeometry may deform or add to the
+	 * geometry from frame to frame, so it can't be reused then */
+	bool reuseGeometry =
+	    !gWindow->functionWrapped (GLWindow::glAddGeometryIndex);
+
+	if (reuseGeometry && geometryValid && geometryClip == reg)
 	{
-	    box.setGeometry (wd->quad[i].box.x1,
-			     wd->quad[i].box.y1,
-			     wd->quad[i].box.x2 - wd->quad[i].box.x1,
-			     wd->quad[i].box.y2 - wd->quad[i].box.y1);
+	    GLVertexBuffer *vb = gWindow->vertexBuffer ();
+	    unsigned int   nVertices = geometryVertices.size () / 3;
+
+	    if (nVertices)
+	    {
+		vb->addVertices (nVertices, &geometryVertices[0]);
+		vb->addTexCoords (0, nVertices, &geometryTexCoords[0]);
+	    }
+	}
+	else
+	{
+	    for (int i = 0; i < wd->nQuad; i++)
+	    {
+		box.setGeometry (wd->quad[i].box.x1,
+				 wd->quad[i].box.y1,
+				 wd->quad[i].box.x2 - wd->quad[i].box.x1,
+				 wd->quad[i].box.y2 - wd->quad[i].box.y1);
+
+		if (box.width () > 0 && box.height () > 0)
+		{
+		    ml[0] = wd->quad[i].matrix;
+		    const CompRegionRef boxRegion (box.region ());
+		    gWindow->glAddGeometry (ml, boxRegion, reg);
+		}
+	    }
+
+	    geometryValid = reuseGeometry;
 
-	    if (box.width () > 0 && box.height () > 0)
+	    if (reuseGeometry)
 	    {
-		ml[0] = wd->quad[i].matrix;
-		const CompRegionRef boxRegion (box.region ());
-		gWindow->glAddGeometry (ml, boxRegion, reg);
+		GLVertexBuffer *vb = gWindow->vertexBuffer ();
+		unsigned int   nVertices = vb->countVertices ();
+		const GLfloat  *vertices = nVertices ? vb->getVertices () : NULL;
+		const GLfloat  *texCoords = vb->getTexCoords (0);
+
+		geometryClip = reg;
+
+		if (texCoords)
+		{
+		    geometryVertices.assign (vertices, vertices + nVertices * 3);
+		    geometryTexCoords.assign (texCoords, texCoords + nVertices * 2);
+		}
+		else
+		{
+		    geometryVertices.clear ();
+		    geometryTexCoords.clear ();
+		}
 	    }
 	}
 
@@ -372,7 +414,7 @@ DecorTexture::~DecorTexture ()
  *
  * Returns the texture for a given pixmap. Note
  * that if this particular pixmap was already found
- * in the list of decor textures, then the refcount
+ * in the map of decor textures, then the refcount
  * is increased and that one is returned instead of
  * binding a new texture.
  *
@@ -384,12 +426,13 @@ DecorScreen::getTexture (Pixmap pixmap)
     if (!cmActive)
 	return NULL;
 
-    foreach (DecorTexture *t, textures)
-	if (t->pixmap->getPixmap () == pixmap)
-	{
-	    t->refCount++;
-	    return t;
-	}
+    TextureMap::iterator it = textures.find (pixmap);
+
+    if (it != textures.end ())
+    {
+	it->second->refCount++;
+	return it->second;
+    }
 
     X11PixmapDeletor::Ptr dl = boost::make_shared <X11PixmapDeletor> (screen->dpy ());
     DecorPixmap::Ptr pm = boost::make_shared <DecorPixmap> (pixmap, dl);
@@ -402,7 +445,7 @@ DecorScreen::getTexture (Pixmap pixmap)
 	return NULL;
     }
 
-    textures.push_back (texture);
+    textures[pixmap] = texture;
 
     return texture;
 }
@@ -411,7 +454,7 @@ DecorScreen::getTexture (Pixmap pixmap)
  * DecorScreen::releaseTexture
  *
  * Unreferences the texture, deletes the texture from
- * the list of textures if its no longer in use
+ * the map of textures if its no longer in use
  */
 
 void
@@ -421,10 +464,9 @@ DecorScreen::releaseTexture (DecorTexture *texture)
     if (texture->refCount)
 	return;
 
-    std::list<DecorTexture *>::iterator it =
-	std::find (textures.begin (), textures.end (), texture);
+    TextureMap::iterator it = textures.find (texture->pixmap->getPixmap ());
 
-    if (it == textures.end ())
+    if (it == textures.end () || it->second != texture)
 	return;
 
     textures.erase (it);
@@ -1120,6 +1162,7 @@ DecorWindow::updateDecorationScale ()
     }
 
     setDecorationMatrices ();
+    geometryValid = false;
 }
 
 /*
@@ -1433,6 +1476,9 @@ DecorWindow::update (bool allowDecoration)
     else
 	old.reset ();
 
+    /* The type might have changed */
+    updateDrawBatchable ();
+
     /* Only want to decorate windows which have a frame or are in the process
      * of waiting for an animation to be unmapped (in which case we can give
      * them a new pixmap type frame since we don't actually need an input
@@ -2394,21 +2440,21 @@ DecorScreen::handleEvent (XEvent *event)
 		if (frames.find (de->drawable) != frames.end ())
 		    frames[de->drawable]->cWindow->damageOutputExtents ();
 
-		foreach (DecorTexture *t, textures)
+		TextureMap::iterator it = textures.find (de->drawable);
+
+		if (it != textures.end ())
 		{
-		    if (t->pixmap->getPixmap () == de->drawable)
+		    DecorTexture *t = it->second;
+
+		    foreach (CompWindow *w, screen->windows ())
 		    {
-			foreach (CompWindow *w, screen->windows ())
+			if (w->shaded () || w->mapNum ())
 			{
-			    if (w->shaded () || w->mapNum ())
-			    {
-				DECOR_WINDOW (w);
+			    DECOR_WINDOW (w);
 
-				if (dw->wd && dw->wd->decor->texture == t)
-				    dw->cWindow->damageOutputExtents ();
-			    }
+			    if (dw->wd && dw->wd->decor->texture == t)
+				dw->cWindow->damageOutputExtents ();
 			}
-			break;
 		    }
 		}
 	    }
@@ -2915,17 +2961,39 @@ DecorWindow::updateHandlers ()
 
 	CompositeWindowInterface::setHandler (cWindow);
 	GLWindowInterface::setHandler (gWindow);
+
+	updateDrawBatchable ();
     }
     else
     {
 	CompositeWindowInterface::setHandler (cWindow, false);
 	GLWindowInterface::setHandler (gWindow, false);
 
+	if (gWindow)
+	    gWindow->setDrawBatchable (this, false);
+
 	gWindow = NULL;
 	cWindow = NULL;
     }
 }
 
+/*
+ * DecorWindow::updateDrawBatchable
+ *
+ * Our glDraw only adds the decoration quads through the window's
+ * own vertex buffer, so it doesn't need to end the program batch.
+ * Desktop windows are the exception, since there we paint the docks
+ * through their whole glPaint chain to draw their shadows
+ *
+ */
+void
+DecorWindow::updateDrawBatchable ()
+{
+    if (gWindow)
+	gWindow->setDrawBatchable (this,
+				   !(window->type () & CompWindowTypeDesktopMask));
+}
+
 /*
  * DecorScreen::decoratorStartTimeout
  *
@@ -3079,6 +3147,7 @@ DecorWindow::DecorWindow (CompWindow *w) :
     regions (),
     updateReg (true),
     updateMatrix (true),
+    geometryValid (false),
     unshading (false),
     shading (false),
     isSwitcher (false),
@@ -3138,6 +3207,9 @@ DecorWindow::~DecorWindow ()
     if (mClipGroup)
 	mClipGroup->popClippable (this);
 
+    if (gWindow)
+	gWindow->setDrawBatchable (this, false);
+
     decor.mList.clear ();
 }
 
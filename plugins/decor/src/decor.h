@@ -224,7 +224,10 @@ class DecorScreen :
 
 	CompositeScreen *cScreen;
 
-	std::list<DecorTexture *> textures;
+	/* Decorations of the same type and state share a pixmap, so
+	 * this stays small; index it for the per-damage lookups */
+	typedef std::map<Pixmap, DecorTexture *> TextureMap;
+	TextureMap textures;
 
 	Atom supportingDmCheckAtom;
 	Atom winDecorAtom;
@@ -305,6 +308,7 @@ class DecorWindow :
 
 	void updateSwitcher ();
 	void updateHandlers ();
+	void updateDrawBatchable ();
 
 	static bool matchType (CompWindow *w, unsigned int decorType);
 	static bool matchState (CompWindow *w, unsigned int decorState);
@@ -348,6 +352,13 @@ class DecorWindow :
 	bool               updateReg;
 	bool		   updateMatrix;
 
+	/* Pixmap decoration quads as glAddGeometry produced them
+	 * last time, reused until the quads or the clip change */
+	CompRegion           geometryClip;
+	std::vector<GLfloat> geometryVertices;
+	std::vector<GLfloat> geometryTexCoords;
+	bool                 geometryValid;
+
 	CompTimer resizeUpdate;
 	CompTimer moveUpdate;
 
@@ -53,10 +53,9 @@ MousepollScreen::getMousePosition ()
     return false;
 }
 
-bool
-MousepollScreen::updatePosition ()
+void
+MousepollScreen::notifyPollers ()
 {
-
     if (getMousePosition ())
     {
         std::list<MousePoller *>::iterator it;
@@ -69,11 +68,52 @@ MousepollScreen::updatePosition ()
             poller->mCallback (pos);
         }
     }
+}
 
+bool
+MousepollScreen::updatePosition ()
+{
+    /* With raw motion the timer only runs while the pointer is moving,
+     * so let it expire after an interval without any motion */
+    if (xi2)
+    {
+	if (!motionPending)
+	    return false;
+
+	motionPending = false;
+    }
+
+    notifyPollers ();
 
     return true;
 }
 
+bool
+MousepollScreen::pollIdle ()
+{
+    /* While the pointer moves the motion timer is running anyway */
+    if (!timer.active ())
+	notifyPollers ();
+
+    return !pollers.empty ();
+}
+
+void
+MousepollScreen::motionDetected ()
+{
+    motionPending = true;
+
+    /* Report the first motion right away and coalesce the following
+     * ones to at most one position query per poll interval */
+    if (!timer.active ())
+    {
+	updatePosition ();
+
+	if (!pollers.empty ())
+	    timer.start ();
+    }
+}
+
 bool
 MousepollScreen::addTimer (MousePoller *poller)
 {
@@ -89,7 +129,14 @@ MousepollScreen::addTimer (MousePoller *poller)
     if (start)
     {
 	getMousePosition ();
-	timer.start ();
+
+	if (xi2)
+	{
+	    selectRawMotion (true);
+	    idleTimer.start ();
+	}
+	else
+	    timer.start ();
     }
 
     return true;
@@ -107,7 +154,55 @@ MousepollScreen::removeTimer (MousePoller *poller)
     pollers.erase (it);
 
     if (pollers.empty ())
+    {
 	timer.stop ();
+	idleTimer.stop ();
+
+	if (xi2)
+	    selectRawMotion (false);
+    }
+}
+
+void
+MousepollScreen::selectRawMotion (bool enable)
+{
+    XIEventMask   mask;
+    unsigned char bits[XIMaskLen (XI_LASTEVENT)] = { 0 };
+
+    if (enable)
+	XISetMask (bits, XI_RawMotion);
+
+    mask.deviceid = XIAllMasterDevices;
+    mask.mask_len = sizeof (bits);
+    mask.mask     = bits;
+
+    XISelectEvents (screen->dpy (), screen->root (), &mask, 1);
+
+    motionPending = false;
+    screen->handleEventSetEnabled (this, enable);
+}
+
+void
+MousepollScreen::handleEvent (XEvent *event)
+{
+    switch (event->type) {
+	case GenericEvent:
+	    if (event->xcookie.extension == xiOpcode &&
+		event->xcookie.evtype    == XI_RawMotion)
+		motionDetected ();
+	    break;
+	/* Core events also come for some pointer moves
+	 * that have no raw event, like warps */
+	case MotionNotify:
+	case EnterNotify:
+	case LeaveNotify:
+	    motionDetected ();
+	    break;
+	default:
+	    break;
+    }
+
+    screen->handleEvent (event);
 }
 
 void
@@ -224,20 +319,43 @@ MousepollScreen::updateTimer ()
 {
     float timeout = optionGetMousePollInterval ();
     timer.setTimes (timeout, timeout * 1.5);
+    idleTimer.setTimes (timeout * 10, timeout * 15);
 
 }
 
 template class PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>;
 
 MousepollScreen::MousepollScreen (CompScreen *screen) :
-    PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI> (screen)
+    PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI> (screen),
+    xi2 (false),
+    xiOpcode (0),
+    motionPending (false)
 {
+    int event, error;
+    int major = 2, minor = 1;
+
+    /* Raw events are only delivered during grabs of other clients
+     * since XI 2.1, older servers keep polling on the timer */
+    if (XQueryExtension (screen->dpy (), "XInputExtension",
+			 &xiOpcode, &event, &error) &&
+	XIQueryVersion (screen->dpy (), &major, &minor) == Success)
+	xi2 = major > 2 || (major == 2 && minor >= 1);
+
+    ScreenInterface::setHandler (screen, false);
+
     updateTimer ();
     timer.setCallback (boost::bind (&MousepollScreen::updatePosition, this));
+    idleTimer.setCallback (boost::bind (&MousepollScreen::pollIdle, this));
 
     optionSetMousePollIntervalNotify (boost::bind (&MousepollScreen::updateTimer, this));
 }
 
+MousepollScreen::~MousepollScreen ()
+{
+    if (xi2 && !pollers.empty ())
+	selectRawMotion (false);
+}
+
 bool
 MousepollPluginVTable::init ()
 {
@@ -24,6 +24,8 @@
 #include <core/pluginclasshandler.h>
 #include <core/timer.h>
 
+#include <X11/extensions/XInput2.h>
+
 #include <mousepoll/mousepoll.h>
 
 #include "mousepoll_options.h"
@@ -42,20 +44,46 @@ extern template class PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MO
 
 class MousepollScreen :
     public PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>,
+    public ScreenInterface,
     public MousepollOptions
 {
     public:
 
 	MousepollScreen (CompScreen *screen);
+	~MousepollScreen ();
 
 	std::list<MousePoller *> pollers;
 	CompTimer		 timer;
 
 	CompPoint pos;
 
+	/* XInput 2 raw motion, used instead of polling when available */
+	bool xi2;
+	int  xiOpcode;
+	bool motionPending;
+
+	/* With raw motion, polls less often while the pointer seems idle,
+	 * to pick up warps that come without any motion event */
+	CompTimer idleTimer;
+
+	void
+	handleEvent (XEvent *event);
+
+	void
+	selectRawMotion (bool enable);
+
+	void
+	notifyPollers ();
+
 	bool
 	updatePosition ();
 
+	bool
+	pollIdle ();
+
+	void
+	motionDetected ();
+
 	bool
 	getMousePosition ();
 
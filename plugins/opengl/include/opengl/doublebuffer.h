@@ -1,6 +1,7 @@
 #ifndef _COMPIZ_OPENGL_BUFFERBLIT_H
 #define _COMPIZ_OPENGL_BUFFERBLIT_H
 
+#include <deque>
 #include <core/region.h>
 #include <boost/function.hpp>
 
@@ -29,6 +30,13 @@ class DoubleBuffer
 	virtual void fallbackBlit (const CompRegion &region) const = 0;
 	virtual void copyFrontToBack () const = 0;
 
+	/*
+	 * Age of the back buffer in frames as reported by the driver
+	 * (GLX_EXT_buffer_age or EGL_EXT_buffer_age), 0 if its
+	 * contents are undefined or -1 if the driver can't tell.
+	 */
+	virtual int queryBufferAge () const = 0;
+
 	typedef enum
 	{
 	    VSYNC,
@@ -62,6 +70,23 @@ class DoubleBuffer
 
 	bool hardwareVSyncFunctional ();
 
+	/*
+	 * How many frames ago the contents of the back buffer were
+	 * presented, or 0 if they are unknown. A back buffer that was
+	 * brought up to date by copyFrontToBack is one frame old,
+	 * whatever the driver says.
+	 */
+	unsigned int bufferAge () const;
+
+	/*
+	 * Computes the region of the back buffer that has to be
+	 * repainted along with damage so that all of it can be
+	 * swapped: damage plus everything presented since the back
+	 * buffer was last current. Returns false if the back buffer
+	 * is too old or its age is unknown.
+	 */
+	bool staleRegion (const CompRegion &damage, CompRegion &stale) const;
+
     protected:
 	bool setting[_NSETTINGS];
 
@@ -80,6 +105,12 @@ class DoubleBuffer
 	impl::GLXSwapIntervalEXTFunc  swapIntervalFunc;
 	impl::GLXWaitVideoSyncSGIFunc waitVideoSyncFunc;
 	unsigned int                  lastVSyncCounter;
+
+	/* Damage of the most recently swapped frames, newest first */
+	std::deque <CompRegion>       damageHistory;
+	/* Damage blitted since the last swap */
+	CompRegion                    blittedDamage;
+	bool                          backBufferCurrent;
 };
 
 }
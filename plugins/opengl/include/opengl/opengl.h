@@ -50,7 +50,7 @@
 #include <opengl/programcache.h>
 #include <opengl/shadercache.h>
 
-#define COMPIZ_OPENGL_ABI 6
+#define COMPIZ_OPENGL_ABI 7
 
 /*
  * Some plugins check for #ifdef USE_MODERN_COMPIZ_GL. Support it for now, but
@@ -230,6 +230,19 @@ namespace GL {
                                          GLsizeiptr size,
                                          const GLvoid *data);
 
+    typedef void (*GLGetProgramBinaryProc) (GLuint program,
+                                            GLsizei bufSize,
+                                            GLsizei *length,
+                                            GLenum *binaryFormat,
+                                            GLvoid *binary);
+    typedef void (*GLProgramBinaryProc) (GLuint program,
+                                         GLenum binaryFormat,
+                                         const GLvoid *binary,
+                                         GLsizei length);
+    typedef void (*GLProgramParameteriProc) (GLuint program,
+                                             GLenum pname,
+                                             GLint value);
+
     typedef void (*GLGetShaderivProc) (GLuint shader,
                                        GLenum pname,
                                        GLint *params);
@@ -382,6 +395,10 @@ namespace GL {
     extern GLBufferDataProc    bufferData;
     extern GLBufferSubDataProc bufferSubData;
 
+    extern GLGetProgramBinaryProc  getProgramBinary;
+    extern GLProgramBinaryProc     programBinary;
+    extern GLProgramParameteriProc programParameteri;
+
 
     extern GLGetShaderivProc        getShaderiv;
     extern GLGetShaderInfoLogProc   getShaderInfoLog;
@@ -508,6 +525,11 @@ namespace GL {
 
 #endif
 
+    /* Same values for GL_ARB_get_program_binary and GL_OES_get_program_binary */
+    static const GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+    static const GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+    static const GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
     extern bool  textureFromPixmap;
     extern bool  textureRectangle;
     extern bool  textureNonPowerOfTwo;
@@ -523,6 +545,8 @@ namespace GL {
     extern bool  vboSupported;
     extern bool  vboEnabled;
     extern bool  shaders;
+    extern bool  programBinaries;
+    extern bool  bufferAge;
     extern bool  stencilBuffer;
     extern GLint maxTextureUnits;
 
@@ -761,6 +785,16 @@ class GLScreen :
 	 */
 	GLFramebufferObject *fbo ();
 
+	/**
+	 * Number of draw calls submitted while painting the last frame
+	 */
+	unsigned int drawCalls ();
+
+	/**
+	 * Number of times a program got bound while painting the last frame
+	 */
+	unsigned int programBinds ();
+
 	/**
 	 * Returns a default icon texture
 	 */
@@ -945,6 +979,15 @@ class GLWindow :
 
 	GLTexture *getIcon (int width, int height);
 
+	/**
+	 * Tells whether iface may be left wrapping glPaint, glDraw,
+	 * glAddGeometry and glDrawTexture while this window shares the
+	 * bound program with its neighbours. Only pass interfaces that
+	 * draw through this window and its vertex buffer and leave the
+	 * program state alone, and unset it before iface goes away.
+	 */
+	void setDrawBatchable (GLWindowInterface *iface, bool batchable);
+
 	WRAPABLE_HND (0, GLWindowInterface, bool, glPaint,
 		      const GLWindowPaintAttrib &, const GLMatrix &,
 		      const CompRegion &, unsigned int);
@@ -65,6 +65,32 @@ class GLProgram
 	                   GLint z,
                            GLint w);
 
+	/*
+	 * Locations are looked up once per program and remembered, and
+	 * values which are already current for a location are not sent
+	 * to the driver again. Callers setting the same uniform every
+	 * draw can fetch its location once and use the overloads below.
+	 */
+	GLint uniformLocation (const char *name);
+
+	bool setUniform   (GLint location, GLfloat value);
+	bool setUniform   (GLint location, GLint value);
+	bool setUniform   (GLint location, const GLMatrix &value);
+	bool setUniform2f (GLint location, GLfloat x, GLfloat y);
+	bool setUniform3f (GLint location, GLfloat x, GLfloat y, GLfloat z);
+	bool setUniform4f (GLint location,
+	                   GLfloat x,
+	                   GLfloat y,
+	                   GLfloat z,
+	                   GLfloat w);
+	bool setUniform2i (GLint location, GLint x, GLint y);
+	bool setUniform3i (GLint location, GLint x, GLint y, GLint z);
+	bool setUniform4i (GLint location,
+	                   GLint x,
+	                   GLint y,
+	                   GLint z,
+	                   GLint w);
+
 	GLuint attributeLocation (const char *name);
 
     private:
@@ -44,7 +44,7 @@ class GLProgramCache
 	GLProgramCache (size_t);
 	~GLProgramCache ();
 
-	GLProgram* operator () (std::list<const GLShaderData*>);
+	GLProgram* operator () (const std::list<const GLShaderData*> &);
 };
 
 #endif // _COMPIZ_GLPROGRAMCACHE_H
@@ -89,6 +89,7 @@ class GLVertexBuffer
 	void addTexCoords (GLuint texture,
 	                   GLuint nTexcoords,
 	                   const GLfloat *texcoords);
+	GLfloat *getTexCoords (GLuint texture) const; // NULL if none added
 
 	void addUniform (const char *name, GLfloat value);
 	void addUniform (const char *name, GLint value);
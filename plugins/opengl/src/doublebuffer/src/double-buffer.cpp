@@ -33,6 +33,7 @@ using namespace compiz::opengl;
 namespace
 {
 const unsigned int UNTHROTTLED_FRAMES_MAX = 5;
+const unsigned int BUFFER_AGE_MAX = 4;
 }
 
 namespace compiz
@@ -47,7 +48,8 @@ DoubleBuffer::DoubleBuffer (const impl::GLXSwapIntervalEXTFunc  &swapIntervalFun
     blockingVSyncUnthrottledFrames (0),
     swapIntervalFunc (swapIntervalFunc),
     waitVideoSyncFunc (waitVideoSyncFunc),
-    lastVSyncCounter (0)
+    lastVSyncCounter (0),
+    backBufferCurrent (false)
 {
     setting[VSYNC] = true;
     setting[HAVE_PERSISTENT_BACK_BUFFER] = false;
@@ -75,10 +77,21 @@ DoubleBuffer::render (const CompRegion &region,
 
 	swap ();
 
+	/* Blitted damage was only painted into the buffer that was just
+	 * presented, so the other buffers are missing it as well */
+	damageHistory.push_front (region + blittedDamage);
+	blittedDamage = CompRegion ();
+
+	if (damageHistory.size () > BUFFER_AGE_MAX)
+	    damageHistory.pop_back ();
+
+	backBufferCurrent = false;
+
 	if (setting[NEED_PERSISTENT_BACK_BUFFER] &&
 	    !setting[HAVE_PERSISTENT_BACK_BUFFER])
 	{
 	    copyFrontToBack ();
+	    backBufferCurrent = true;
 	}
     }
     else
@@ -96,9 +109,38 @@ DoubleBuffer::render (const CompRegion &region,
 	    assert (false);
 	    abort ();
 	}
+
+	blittedDamage += region;
     }
 }
 
+unsigned int
+DoubleBuffer::bufferAge () const
+{
+    if (backBufferCurrent)
+	return 1;
+
+    int age = queryBufferAge ();
+
+    return age > 0 ? age : 0;
+}
+
+bool
+DoubleBuffer::staleRegion (const CompRegion &damage, CompRegion &stale) const
+{
+    unsigned int age = bufferAge ();
+
+    if (age == 0 || age - 1 > damageHistory.size ())
+	return false;
+
+    stale = damage;
+
+    for (unsigned int i = 0; i < age - 1; i++)
+	stale += damageHistory[i];
+
+    return true;
+}
+
 void
 DoubleBuffer::vsync (FrontbufferRedrawType redrawType)
 {
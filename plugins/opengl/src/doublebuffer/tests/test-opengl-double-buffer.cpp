@@ -35,6 +35,7 @@ class MockDoubleBuffer :
 	MOCK_CONST_METHOD0 (fallbackBlitAvailable, bool ());
 	MOCK_CONST_METHOD1 (fallbackBlit, void (const CompRegion &));
 	MOCK_CONST_METHOD0 (copyFrontToBack, void ());
+	MOCK_CONST_METHOD0 (queryBufferAge, int ());
 };
 
 class MockVSyncDoubleBuffer :
@@ -280,6 +281,143 @@ TEST_F(DoubleBufferTest, TestRestoreReportHardwareVSync)
     EXPECT_FALSE (db.hardwareVSyncFunctional ());
 }
 
+class DoubleBufferAgeTest :
+    public DoubleBufferTest
+{
+    public:
+
+	DoubleBufferAgeTest () :
+	    r1 (0, 0, 100, 100),
+	    r2 (100, 100, 100, 100),
+	    r3 (200, 200, 100, 100),
+	    damage (300, 300, 10, 10)
+	{
+	    db.set (DoubleBuffer::VSYNC, false);
+	    ON_CALL (db, blitAvailable ()).WillByDefault (Return (true));
+	}
+
+	void setAge (int age)
+	{
+	    ON_CALL (db, queryBufferAge ()).WillByDefault (Return (age));
+	}
+
+	CompRegion r1, r2, r3;
+	CompRegion damage;
+};
+
+TEST_F(DoubleBufferAgeTest, NoStaleRegionIfDriverCannotTell)
+{
+    CompRegion stale;
+
+    setAge (-1);
+    db.render (r1, true);
+
+    EXPECT_EQ (0, db.bufferAge ());
+    EXPECT_FALSE (db.staleRegion (damage, stale));
+}
+
+TEST_F(DoubleBufferAgeTest, NoStaleRegionIfBackBufferUndefined)
+{
+    CompRegion stale;
+
+    setAge (0);
+    db.render (r1, true);
+
+    EXPECT_FALSE (db.staleRegion (damage, stale));
+}
+
+TEST_F(DoubleBufferAgeTest, OneFrameOldBackBufferOnlyNeedsDamage)
+{
+    CompRegion stale;
+
+    setAge (1);
+    db.render (r1, true);
+
+    ASSERT_TRUE (db.staleRegion (damage, stale));
+    EXPECT_EQ (damage, stale);
+}
+
+TEST_F(DoubleBufferAgeTest, OlderBackBufferNeedsDamageOfNewerFrames)
+{
+    CompRegion stale;
+
+    db.render (r1, true);
+    db.render (r2, true);
+    db.render (r3, true);
+
+    setAge (2);
+    ASSERT_TRUE (db.staleRegion (damage, stale));
+    EXPECT_EQ (damage + r3, stale);
+
+    setAge (3);
+    ASSERT_TRUE (db.staleRegion (damage, stale));
+    EXPECT_EQ (damage + r3 + r2, stale);
+}
+
+TEST_F(DoubleBufferAgeTest, NoStaleRegionIfOlderThanHistory)
+{
+    CompRegion stale;
+
+    db.render (r1, true);
+
+    setAge (3);
+    EXPECT_FALSE (db.staleRegion (damage, stale));
+
+    /* Only a limited number of frames are remembered */
+    for (unsigned int i = 0; i < 10; i++)
+	db.render (r1, true);
+
+    setAge (10);
+    EXPECT_FALSE (db.staleRegion (damage, stale));
+}
+
+TEST_F(DoubleBufferAgeTest, BlittedDamageCountsTowardsNextSwap)
+{
+    CompRegion stale;
+
+    db.render (r1, true);
+    EXPECT_CALL (db, blit (r2));
+    db.render (r2, false);
+    db.render (r3, true);
+
+    setAge (2);
+    ASSERT_TRUE (db.staleRegion (damage, stale));
+    EXPECT_EQ (damage + r3 + r2, stale);
+}
+
+TEST_F(DoubleBufferAgeTest, CopiedFrontBufferIsOneFrameOld)
+{
+    CompRegion stale;
+
+    db.set (DoubleBuffer::HAVE_PERSISTENT_BACK_BUFFER, false);
+    db.set (DoubleBuffer::NEED_PERSISTENT_BACK_BUFFER, true);
+
+    setAge (-1);
+    EXPECT_CALL (db, copyFrontToBack ());
+    db.render (r1, true);
+
+    EXPECT_EQ (1, db.bufferAge ());
+    ASSERT_TRUE (db.staleRegion (damage, stale));
+    EXPECT_EQ (damage, stale);
+
+    /* Blits keep it up to date */
+    db.render (r2, false);
+    EXPECT_EQ (1, db.bufferAge ());
+}
+
+TEST_F(DoubleBufferAgeTest, SwapWithoutCopyUsesDriverAge)
+{
+    db.set (DoubleBuffer::HAVE_PERSISTENT_BACK_BUFFER, false);
+    db.set (DoubleBuffer::NEED_PERSISTENT_BACK_BUFFER, true);
+    db.render (r1, true);
+
+    db.set (DoubleBuffer::NEED_PERSISTENT_BACK_BUFFER, false);
+    db.render (r2, true);
+
+    setAge (2);
+    EXPECT_EQ (2, db.bufferAge ());
+}
+
 namespace
 {
 class MockOpenGLFunctionsTable
@@ -71,6 +71,9 @@ PrivateGLScreen::setOption (const CompString  &name,
 	    else
 		textureFilter = GL_LINEAR;
 	    break;
+	case OpenglOptions::ProgramBinaryCache:
+	    updateProgramBinaries ();
+	    break;
 	default:
 	    break;
     }
@@ -229,6 +229,24 @@ PrivateGLScreen::paintBackground (const GLMatrix   &transform,
 }
 
 
+/*
+ * Switches the occlusion detection pass from reusing the results of
+ * the last pass to computing them, from the nth occluding window down.
+ */
+static void
+stopOcclusionReuse (bool                                &reuse,
+		    CompRegion                          &tmpRegion,
+		    const CompRegion                    &region,
+		    const std::vector<GLOcclusionEntry> &occlusion,
+		    unsigned int                        n)
+{
+    if (!reuse)
+	return;
+
+    tmpRegion = n ? occlusion[n - 1].below : region;
+    reuse = false;
+}
+
 /* This function currently always performs occlusion detection to
    minimize paint regions. OpenGL precision requirements are no good
    enough to guarantee that the results from using occlusion detection
@@ -252,8 +270,8 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
     CompPoint     offXY;
     std::set<CompWindow*> unredirected;
 
-    CompWindowList                   pl;
-    CompWindowList::reverse_iterator rit;
+    std::vector<CompWindow *>                   pl;
+    std::vector<CompWindow *>::reverse_iterator rit;
 
     unredirectFS = CompositeScreen::get (screen)->
 	getOption ("unredirect_fullscreen_windows")->value ().b ();
@@ -278,20 +296,60 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
     /*
      * We need to COPY the PaintList for now because there seem to be some
      * odd cases where the master list might change during the below loops.
-     * (LP: #958540)
+     * (LP: #958540) A vector at least does it in a single allocation.
      */
-    pl = cScreen->getWindowPaintList ();
+    const CompWindowList &paintList = cScreen->getWindowPaintList ();
+    pl.assign (paintList.begin (), paintList.end ());
 
     if (!(mask & PAINT_SCREEN_NO_OCCLUSION_DETECTION_MASK))
     {
 	FullscreenRegion fs (*output, screen->region ());
 
+	/*
+	 * Only full repaints of an output use and update the result of
+	 * the last pass. Partial ones are cheap to compute directly, as
+	 * the damage is usually small. If this pass runs with the same
+	 * parameters as the last full one, the clips that one found stay
+	 * valid for as long as the windows from the top down are the
+	 * same, in the same place, with the same shape and still (not)
+	 * occluding. So only start recomputing from the first window
+	 * where that changes.
+	 */
+	bool         cache = (region == CompRegion (*output));
+	bool         reuse = cache &&
+			     occlusionValid &&
+			     occlusionOutput == output &&
+			     occlusionBounds == *output &&
+			     occlusionMask == mask &&
+			     occlusionOffset == cScreen->windowPaintOffset ();
+	unsigned int n = 0;
+
+	if (cache)
+	{
+	    if (!reuse)
+	    {
+		occlusionOutput = output;
+		occlusionBounds = *output;
+		occlusionMask = mask;
+		occlusionOffset = cScreen->windowPaintOffset ();
+	    }
+
+	    occlusionValid = true;
+	}
+
 	/* detect occlusions */
 	for (rit = pl.rbegin (); rit != pl.rend (); ++rit)
 	{
 	    w = (*rit);
 	    gw = GLWindow::get (w);
 
+	    /* A window got created behind our back */
+	    if (cache && !occlusionValid)
+	    {
+		stopOcclusionReuse (reuse, tmpRegion, region, occlusion, n);
+		occlusionValid = true;
+	    }
+
 	    if (w->destroyed ())
 		continue;
 
@@ -309,9 +367,6 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 		    continue;
 	    }
 
-	    /* copy region */
-	    gw->priv->clip = tmpRegion;
-
 	    odMask = PAINT_WINDOW_OCCLUSION_DETECTION_MASK;
 
 	    if ((cScreen->windowPaintOffset ().x () != 0 ||
@@ -325,29 +380,70 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 		vTransform = transform;
 		vTransform.translate (offXY.x (), offXY.y (), 0);
 
-		gw->priv->clip.translate (-offXY.x (), -offXY. y ());
-
 		odMask |= PAINT_WINDOW_WITH_OFFSET_MASK;
-		status = gw->glPaint (gw->paintAttrib (), vTransform,
-				      tmpRegion, odMask);
 	    }
 	    else
 	    {
 		withOffset = false;
-		status = gw->glPaint (gw->paintAttrib (), transform, tmpRegion,
-				      odMask);
+		offXY = CompPoint ();
 	    }
 
-	    if (status)
+	    if (reuse &&
+		(n >= occlusion.size () ||
+		 occlusion[n].window != w ||
+		 occlusion[n].offset != offXY))
+		stopOcclusionReuse (reuse, tmpRegion, region, occlusion, n);
+
+	    /* what is left above this window, which is also its clip */
+	    const CompRegion &above = reuse ?
+				      (n ? occlusion[n - 1].below : region) :
+				      tmpRegion;
+
+	    /* copy region, partial repaints may have changed it since */
+	    gw->priv->clip = above;
+
+	    if (withOffset)
+		gw->priv->clip.translate (-offXY.x (), -offXY. y ());
+
+	    status = gw->glPaint (gw->paintAttrib (),
+				  withOffset ? vTransform : transform,
+				  above, odMask);
+
+	    if (reuse &&
+		(status != occlusion[n].occludes ||
+		 (status && w->region () != occlusion[n].region)))
+		stopOcclusionReuse (reuse, tmpRegion, region, occlusion, n);
+
+	    if (!reuse)
 	    {
-		if (withOffset)
+		if (status)
 		{
-		    tmpRegion -= w->region ().translated (offXY);
+		    if (withOffset)
+		    {
+			tmpRegion -= w->region ().translated (offXY);
+		    }
+		    else
+			tmpRegion -= w->region ();
+		}
+
+		if (cache)
+		{
+		    if (n == occlusion.size ())
+			occlusion.push_back (GLOcclusionEntry ());
+
+		    GLOcclusionEntry &entry = occlusion[n];
+
+		    entry.window = w;
+		    entry.offset = offXY;
+		    entry.occludes = status;
+		    if (status)
+			entry.region = w->region ();
+		    entry.below = tmpRegion;
 		}
-		else
-		    tmpRegion -= w->region ();
 	    }
 
+	    n++;
+
 	    FullscreenRegion::WinFlags flags = 0;
 	    if (w->type () & CompWindowTypeDesktopMask)
 	        flags |= FullscreenRegion::Desktop;
@@ -360,20 +456,20 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 	     * Windows with alpha channels can partially occlude windows
 	     * beneath them and so neither should be unredirected in that case.
 	     *
-	     * Performance note:  unredirectable.evaluate is SLOW because it
-	     * involves regex matching. Too slow to do on every window for
-	     * every frame. So we only call it if a window is redirected AND
-	     * potentially needs unredirecting. This means changes to
-	     * unredirect_match while a window is unredirected already may not
-	     * take effect until it is un-fullscreened again. But that's better
-	     * than the high price of regex matching on every frame.
+	     * Performance note:  evaluating unredirectable involves regex
+	     * matching, which is too slow to do on every window for every
+	     * frame, so the cached result is used. It is also only checked
+	     * if a window is redirected AND potentially needs unredirecting.
+	     * This means changes to unredirect_match while a window is
+	     * unredirected already may not take effect until it is
+	     * un-fullscreened again.
 	     */
 	    if (unredirectFS &&
 		!blacklisted &&
 		!(mask & PAINT_SCREEN_TRANSFORMED_MASK) &&
 		!(mask & PAINT_SCREEN_WITH_TRANSFORMED_WINDOWS_MASK) &&
 		fs.isCoveredBy (w->region (), flags) &&
-		(!cw->redirected () || unredirectable.evaluate (w)))
+		(!cw->redirected () || unredirectable.evaluateCached (w)))
 	    {
 		unredirected.insert (w);
 	    }
@@ -401,6 +497,13 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 		}
 	    }
 	}
+
+	/* Nothing changed all the way down */
+	if (reuse)
+	    tmpRegion = n ? occlusion[n - 1].below : region;
+
+	if (cache)
+	    occlusion.resize (n);
     }
 
     /* Unredirect any redirected fullscreen windows */
@@ -429,6 +532,17 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 
 	gw = GLWindow::get (w);
 
+	/*
+	 * Windows drawn entirely by us, or by wrappers which said they
+	 * only add draws of their own (see GLWindow::setDrawBatchable),
+	 * can share one program bind. Other plugins wrapping the draw
+	 * may do anything with GL state, so give them a clean slate.
+	 */
+	if (gw->priv->drawBatchable ())
+	    PrivateVertexBuffer::beginBatch ();
+	else
+	    PrivateVertexBuffer::endBatch ();
+
 	const CompRegion &clip =
 	    (!(mask & PAINT_SCREEN_NO_OCCLUSION_DETECTION_MASK)) ?
 	    gw->clip () : region;
@@ -449,6 +563,8 @@ PrivateGLScreen::paintOutputRegion (const GLMatrix   &transform,
 	    gw->glPaint (gw->paintAttrib (), transform, clip, windowMask);
 	}
     }
+
+    PrivateVertexBuffer::endBatch ();
 }
 
 // transformIsSimple tells you if it's simple enough to use scissoring
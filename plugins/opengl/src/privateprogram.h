@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2011 Linaro Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Linaro Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Linaro Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * LINARO LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL LINARO LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Authors: Travis Watkins <travis.watkins@linaro.org>
+ */
+
+#ifndef _PROGRAM_PRIVATE_H
+#define _PROGRAM_PRIVATE_H
+
+#include <opengl/program.h>
+
+#include "uniform-cache.h"
+#include "program-binary-cache.h"
+
+class PrivateProgram
+{
+    public:
+	PrivateProgram ();
+
+	int lookupUniform (const char *name);
+	int lookupAttribute (const char *name);
+
+	bool changed (GLint location, unsigned int count, const GLfloat *values);
+	bool changed (GLint location, unsigned int count, const GLint *values);
+
+	bool loadBinary (compiz::opengl::ProgramBinaryCache::Key key);
+	void storeBinary (compiz::opengl::ProgramBinaryCache::Key key);
+
+	// Where linked programs are kept between runs, NULL when the
+	// driver can't give us binaries or the cache is disabled
+	static compiz::opengl::ProgramBinaryCache *binaryCache;
+
+	GLuint program;
+	bool valid;
+
+	compiz::opengl::LocationCache uniformLocations;
+	compiz::opengl::LocationCache attributeLocations;
+	compiz::opengl::UniformShadow uniformValues;
+};
+
+#endif //_PROGRAM_PRIVATE_H
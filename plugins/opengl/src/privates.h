@@ -42,6 +42,7 @@
 
 #include "privatetexture.h"
 #include "privatevertexbuffer.h"
+#include "privateprogram.h"
 #include "opengl_options.h"
 
 extern CompOutput *targetOutput;
@@ -79,6 +80,7 @@ class GLXDoubleBuffer :
 	bool fallbackBlitAvailable () const;
 	void fallbackBlit (const CompRegion &region) const;
 	void copyFrontToBack () const;
+	int queryBufferAge () const;
 
     protected:
 
@@ -102,6 +104,7 @@ class EGLDoubleBuffer :
 	bool fallbackBlitAvailable () const;
 	void fallbackBlit (const CompRegion &region) const;
 	void copyFrontToBack () const;
+	int queryBufferAge () const;
 
     private:
 
@@ -119,6 +122,27 @@ class GLIcon
 	GLTexture::List textures;
 };
 
+/*
+ * What the occlusion detection pass of paintOutputRegion found for
+ * one window, so the next pass can tell where things changed.
+ */
+class GLOcclusionEntry
+{
+    public:
+
+	GLOcclusionEntry () :
+	    window (NULL),
+	    occludes (false)
+	{
+	}
+
+	CompWindow *window;
+	CompPoint  offset;
+	bool       occludes;
+	CompRegion region;	/* window region taken out, if it occludes */
+	CompRegion below;	/* what is left for the windows below */
+};
+
 class PrivateGLScreen :
     public ScreenInterface,
     public compiz::composite::PaintHandler,
@@ -162,6 +186,9 @@ class PrivateGLScreen :
 
 	bool driverIsBlacklisted (const char *regex) const;
 
+	void initProgramBinaries ();
+	void updateProgramBinaries ();
+
     public:
 
 	GLScreen        *gScreen;
@@ -215,6 +242,7 @@ class PrivateGLScreen :
 			   // https://bugs.launchpad.net/ubuntu/+source/compiz/+bug/807487
 
 	GLProgramCache *programCache;
+	compiz::opengl::ProgramBinaryCache *programBinaries;
 	GLShaderCache   shaderCache;
 	GLVertexBuffer::AutoProgram *autoProgram;
 
@@ -225,6 +253,18 @@ class PrivateGLScreen :
 
 	mutable CompString prevRegex;
 	mutable bool       prevBlacklisted;
+
+	/* Result of the last occlusion detection pass over a whole
+	 * output and what it was run with */
+	std::vector<GLOcclusionEntry> occlusion;
+	bool                          occlusionValid;
+	CompOutput                    *occlusionOutput;
+	CompRect                      occlusionBounds;
+	unsigned int                  occlusionMask;
+	CompPoint                     occlusionOffset;
+
+	unsigned int frameDrawCalls;
+	unsigned int frameProgramBinds;
 };
 
 class PrivateGLWindow :
@@ -250,6 +290,8 @@ class PrivateGLWindow :
 
 	void clearTextures ();
 
+	bool drawBatchable () const;
+
 	CompWindow      *window;
 	GLWindow        *gWindow;
 	CompositeWindow *cWindow;
@@ -283,6 +325,10 @@ class PrivateGLWindow :
 	GLVertexBuffer::AutoProgram *autoProgram;
 
 	std::list<GLIcon> icons;
+
+	// Interfaces which may wrap the draw without ending the batch,
+	// see GLWindow::setDrawBatchable
+	std::vector<GLWindowInterface *> batchableInterfaces;
 };
 
 #endif
@@ -36,6 +36,8 @@
 #include <opengl/program.h>
 #include <typeinfo>
 
+#include "stream-ring.h"
+
 class GLVertexBuffer;
 
 class AbstractUniform
@@ -113,9 +115,35 @@ class PrivateVertexBuffer
 	                  const GLMatrix            &modelview,
 	                  const GLWindowPaintAttrib &attrib);
 
+	bool canInterleave () const;
+	void uploadInterleaved ();
+
+	// While a batch is open, consecutive renders using the same
+	// program leave it bound instead of binding and unbinding it
+	// around every draw. Only valid while nothing else touches the
+	// current program, so callers must end the batch before handing
+	// control to code which might (like plugins wrapping the draw).
+	static void beginBatch ();
+	static void endBatch ();
+	static void forgetProgram (GLProgram *program);
+
+	// Deletes the shared stream storage, which belongs to the
+	// GL context of the screen going away
+	static void releaseStreamBuffer ();
+
     public:
 	static GLVertexBuffer *streamingBuffer;
 
+	// Shared storage for the interleaved arrays of GL::STREAM_DRAW
+	// buffers, see uploadInterleaved
+	static GLuint                     streamBuffer;
+	static compiz::opengl::StreamRing streamRing;
+
+	static bool         batching;
+	static GLProgram    *batchProgram;
+	static unsigned int drawCalls;
+	static unsigned int programBinds;
+
 	std::vector<GLfloat> vertexData;
 	std::vector<GLfloat> normalData;
 	std::vector<GLfloat> colorData;
@@ -142,6 +170,15 @@ class PrivateVertexBuffer
 	GLuint textureBuffers[4];
 	std::vector<AbstractUniform*> uniforms;
 
+	std::vector<GLfloat> interleavedData;
+	bool         interleaved;
+	unsigned int interleavedGeneration;
+	GLsizei      stride;
+	size_t       vertexPointer;
+	size_t       normalPointer;
+	size_t       colorPointer;
+	size_t       texCoordPointer[MAX_TEXTURES];
+
 	GLVertexBuffer::AutoProgram *autoProgram;
 };
 
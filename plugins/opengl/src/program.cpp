@@ -25,15 +25,96 @@
 
 #include <iostream>
 #include <fstream>
+#include <boost/bind.hpp>
 #include <opengl/opengl.h>
 
-class PrivateProgram
+#include "privateprogram.h"
+#include "privatevertexbuffer.h"
+
+namespace cgl = compiz::opengl;
+
+cgl::ProgramBinaryCache *PrivateProgram::binaryCache = NULL;
+
+PrivateProgram::PrivateProgram () :
+    program (0),
+    valid (false),
+    uniformLocations (boost::bind (&PrivateProgram::lookupUniform, this, _1)),
+    attributeLocations (boost::bind (&PrivateProgram::lookupAttribute, this, _1))
+{
+}
+
+int
+PrivateProgram::lookupUniform (const char *name)
+{
+    return (*GL::getUniformLocation) (program, name);
+}
+
+int
+PrivateProgram::lookupAttribute (const char *name)
+{
+    return (*GL::getAttribLocation) (program, name);
+}
+
+bool
+PrivateProgram::changed (GLint location, unsigned int count, const GLfloat *values)
+{
+    return uniformValues.update (location, cgl::UniformShadow::Float,
+				 count, values);
+}
+
+bool
+PrivateProgram::changed (GLint location, unsigned int count, const GLint *values)
+{
+    return uniformValues.update (location, cgl::UniformShadow::Int,
+				 count, values);
+}
+
+bool
+PrivateProgram::loadBinary (cgl::ProgramBinaryCache::Key key)
+{
+    unsigned int      format;
+    std::vector<char> binary;
+    GLint             status = GL_FALSE;
+
+    if (!binaryCache->load (key, format, binary))
+	return false;
+
+    (*GL::programBinary) (program, format, &binary[0], binary.size ());
+    (*GL::getProgramiv) (program, GL::LINK_STATUS, &status);
+
+    // The driver is free to reject binaries, for instance after an
+    // update that didn't change its version strings
+    if (status == GL_FALSE)
+    {
+	binaryCache->remove (key);
+	return false;
+    }
+
+    return true;
+}
+
+void
+PrivateProgram::storeBinary (cgl::ProgramBinaryCache::Key key)
 {
-    public:
-	GLuint program;
-	bool valid;
-};
+    GLint   length = 0;
+    GLsizei written = 0;
+    GLenum  format = 0;
+
+    (*GL::getProgramiv) (program, GL::PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+	return;
+
+    std::vector<char> binary (length);
 
+    (*GL::getProgramBinary) (program, length, &written, &format, &binary[0]);
+
+    if (written <= 0)
+	return;
+
+    binary.resize (written);
+    binaryCache->store (key, format, binary);
+}
 
 void printShaderInfoLog (GLuint shader)
 {
@@ -89,10 +170,22 @@ GLProgram::GLProgram (CompString &vertexShader, CompString &fragmentShader) :
 {
     GLuint vertex, fragment;
     GLint status;
+    cgl::ProgramBinaryCache::Key key = 0;
 
     priv->valid = false;
     priv->program = (*GL::createProgram) ();
 
+    if (PrivateProgram::binaryCache)
+    {
+	key = PrivateProgram::binaryCache->key (vertexShader, fragmentShader);
+
+	if (priv->loadBinary (key))
+	{
+	    priv->valid = true;
+	    return;
+	}
+    }
+
     if (!compileShader (&vertex, GL::VERTEX_SHADER, vertexShader))
     {
 	printShaderInfoLog (vertex);
@@ -110,6 +203,10 @@ GLProgram::GLProgram (CompString &vertexShader, CompString &fragmentShader) :
     (*GL::attachShader) (priv->program, vertex);
     (*GL::attachShader) (priv->program, fragment);
 
+    if (PrivateProgram::binaryCache && GL::programParameteri)
+	(*GL::programParameteri) (priv->program,
+				  GL::PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     (*GL::linkProgram) (priv->program);
     (*GL::validateProgram) (priv->program);
 
@@ -124,10 +221,14 @@ GLProgram::GLProgram (CompString &vertexShader, CompString &fragmentShader) :
     (*GL::deleteShader) (fragment);
 
     priv->valid = true;
+
+    if (PrivateProgram::binaryCache)
+	priv->storeBinary (key);
 }
 
 GLProgram::~GLProgram ()
 {
+    PrivateVertexBuffer::forgetProgram (this);
     (*GL::deleteProgram) (priv->program);
     delete priv;
 }
@@ -147,116 +248,195 @@ void GLProgram::unbind ()
     (*GL::useProgram) (0);
 }
 
-bool GLProgram::setUniform (const char *name, GLfloat value)
+GLint GLProgram::uniformLocation (const char *name)
+{
+    return priv->uniformLocations.location (name);
+}
+
+bool GLProgram::setUniform (GLint location, GLfloat value)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform1f) (location, value);
+    if (priv->changed (location, 1, &value))
+	(*GL::uniform1f) (location, value);
     return true;
 }
 
-bool GLProgram::setUniform (const char *name, GLint value)
+bool GLProgram::setUniform (GLint location, GLint value)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform1i) (location, value);
+    if (priv->changed (location, 1, &value))
+	(*GL::uniform1i) (location, value);
     return true;
 }
 
-bool GLProgram::setUniform (const char *name, const GLMatrix &value)
+bool GLProgram::setUniform (GLint location, const GLMatrix &value)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniformMatrix4fv) (location, 1, GL_FALSE, value.getMatrix ());
+    if (priv->changed (location, 16, value.getMatrix ()))
+	(*GL::uniformMatrix4fv) (location, 1, GL_FALSE, value.getMatrix ());
     return true;
 }
 
-bool GLProgram::setUniform2f (const char *name,
+bool GLProgram::setUniform2f (GLint location,
                               GLfloat x,
                               GLfloat y)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform2f) (location, x, y);
+    GLfloat values[2] = { x, y };
+
+    if (priv->changed (location, 2, values))
+	(*GL::uniform2f) (location, x, y);
     return true;
 }
 
-bool GLProgram::setUniform3f (const char *name,
+bool GLProgram::setUniform3f (GLint location,
                               GLfloat x,
                               GLfloat y,
                               GLfloat z)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform3f) (location, x, y, z);
+    GLfloat values[3] = { x, y, z };
+
+    if (priv->changed (location, 3, values))
+	(*GL::uniform3f) (location, x, y, z);
     return true;
 }
 
-bool GLProgram::setUniform4f (const char *name,
+bool GLProgram::setUniform4f (GLint location,
                               GLfloat x,
                               GLfloat y,
                               GLfloat z,
                               GLfloat w)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform4f) (location, x, y, z, w);
+    GLfloat values[4] = { x, y, z, w };
+
+    if (priv->changed (location, 4, values))
+	(*GL::uniform4f) (location, x, y, z, w);
     return true;
 }
 
-bool GLProgram::setUniform2i (const char *name,
+bool GLProgram::setUniform2i (GLint location,
                               GLint x,
                               GLint y)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform2i) (location, x, y);
+    GLint values[2] = { x, y };
+
+    if (priv->changed (location, 2, values))
+	(*GL::uniform2i) (location, x, y);
     return true;
 }
 
-bool GLProgram::setUniform3i (const char *name,
+bool GLProgram::setUniform3i (GLint location,
                               GLint x,
                               GLint y,
                               GLint z)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform3i) (location, x, y, z);
+    GLint values[3] = { x, y, z };
+
+    if (priv->changed (location, 3, values))
+	(*GL::uniform3i) (location, x, y, z);
     return true;
 }
 
-bool GLProgram::setUniform4i (const char *name,
+bool GLProgram::setUniform4i (GLint location,
                               GLint x,
                               GLint y,
                               GLint z,
                               GLint w)
 {
-    GLint location = (*GL::getUniformLocation) (priv->program, name);
     if (location == -1)
 	return false;
 
-    (*GL::uniform4i) (location, x, y, z, w);
+    GLint values[4] = { x, y, z, w };
+
+    if (priv->changed (location, 4, values))
+	(*GL::uniform4i) (location, x, y, z, w);
     return true;
 }
 
-GLuint GLProgram::attributeLocation (const char *name)
+bool GLProgram::setUniform (const char *name, GLfloat value)
+{
+    return setUniform (uniformLocation (name), value);
+}
+
+bool GLProgram::setUniform (const char *name, GLint value)
+{
+    return setUniform (uniformLocation (name), value);
+}
+
+bool GLProgram::setUniform (const char *name, const GLMatrix &value)
+{
+    return setUniform (uniformLocation (name), value);
+}
+
+bool GLProgram::setUniform2f (const char *name,
+                              GLfloat x,
+                              GLfloat y)
 {
-    return (*GL::getAttribLocation) (priv->program, name);
+    return setUniform2f (uniformLocation (name), x, y);
 }
 
+bool GLProgram::setUniform3f (const char *name,
+                              GLfloat x,
+                              GLfloat y,
+                              GLfloat z)
+{
+    return setUniform3f (uniformLocation (name), x, y, z);
+}
+
+bool GLProgram::setUniform4f (const char *name,
+                              GLfloat x,
+                              GLfloat y,
+                              GLfloat z,
+                              GLfloat w)
+{
+    return setUniform4f (uniformLocation (name), x, y, z, w);
+}
+
+bool GLProgram::setUniform2i (const char *name,
+                              GLint x,
+                              GLint y)
+{
+    return setUniform2i (uniformLocation (name), x, y);
+}
+
+bool GLProgram::setUniform3i (const char *name,
+                              GLint x,
+                              GLint y,
+                              GLint z)
+{
+    return setUniform3i (uniformLocation (name), x, y, z);
+}
+
+bool GLProgram::setUniform4i (const char *name,
+                              GLint x,
+                              GLint y,
+                              GLint z,
+                              GLint w)
+{
+    return setUniform4i (uniformLocation (name), x, y, z, w);
+}
+
+GLuint GLProgram::attributeLocation (const char *name)
+{
+    return priv->attributeLocations.location (name);
+}
@@ -0,0 +1,100 @@
+/*
+ * Compiz, opengl plugin, GLSL program binary cache
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_OPENGL_PROGRAM_BINARY_CACHE_H
+#define _COMPIZ_OPENGL_PROGRAM_BINARY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace compiz
+{
+    namespace opengl
+    {
+	/*
+	 * Keeps linked program binaries (as returned by
+	 * glGetProgramBinary) on disk, one file per program, so that
+	 * later runs can skip compiling and linking them.
+	 *
+	 * Binaries are only meaningful to the driver which produced
+	 * them, so every entry is keyed by a hash of the shader sources
+	 * and of a string identifying the driver. Entries are only
+	 * validated when loaded, and removed then if they fail.
+	 */
+	class ProgramBinaryCache
+	{
+	    public:
+
+		typedef uint64_t Key;
+
+		ProgramBinaryCache (const std::string &directory,
+				    const std::string &driver);
+
+		/*
+		 * $XDG_CACHE_HOME/compiz-1/glprograms, or
+		 * ~/.cache/compiz-1/glprograms if that isn't set
+		 */
+		static std::string defaultDirectory ();
+
+		Key key (const std::string &vertexShader,
+			 const std::string &fragmentShader) const;
+
+		bool load (Key               key,
+			   unsigned int      &format,
+			   std::vector<char> &binary) const;
+		bool store (Key                     key,
+			    unsigned int            format,
+			    const std::vector<char> &binary);
+		void remove (Key key) const;
+
+		/*
+		 * Removes the temporary files of stores which were
+		 * interrupted more than maxAge seconds ago, returns how
+		 * many. Younger ones may still belong to another running
+		 * instance. Entries themselves are left alone.
+		 */
+		unsigned int prune (unsigned int maxAge = StaleTempAge) const;
+
+		const std::string &directory () const;
+
+		/* Binaries larger than this are never trusted */
+		static const uint32_t MaxBinarySize = 16 * 1024 * 1024;
+
+		/* Default age after which prune drops temporary files */
+		static const unsigned int StaleTempAge = 60 * 60;
+
+	    private:
+
+		std::string path (Key key) const;
+		bool validate (const std::string &path,
+			       Key               key,
+			       unsigned int      &format,
+			       std::vector<char> &binary) const;
+
+		std::string mDirectory;
+		uint64_t    mDriver;
+	};
+    } // namespace opengl
+} // namespace compiz
+#endif
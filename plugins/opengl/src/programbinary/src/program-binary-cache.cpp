@@ -0,0 +1,314 @@
+/*
+ * Compiz, opengl plugin, GLSL program binary cache
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "program-binary-cache.h"
+
+namespace cgl = compiz::opengl;
+
+const uint32_t cgl::ProgramBinaryCache::MaxBinarySize;
+const unsigned int cgl::ProgramBinaryCache::StaleTempAge;
+
+namespace
+{
+    const char     Magic[8] = { 'C', 'Z', 'G', 'L', 'P', 'B', 'I', 'N' };
+    const char     Suffix[] = ".bin";
+    const uint32_t Version = 1;
+
+    struct Header
+    {
+	char     magic[8];
+	uint64_t driver;
+	uint64_t key;
+	uint64_t checksum;
+	uint32_t version;
+	uint32_t format;
+	uint32_t length;
+	uint32_t reserved;
+    };
+
+    /* 64 bit FNV-1a */
+    const uint64_t FnvOffset = 14695981039346656037ULL;
+    const uint64_t FnvPrime = 1099511628211ULL;
+
+    uint64_t
+    hash (const char *data, size_t length, uint64_t h = FnvOffset)
+    {
+	for (size_t i = 0; i < length; i++)
+	{
+	    h ^= static_cast <unsigned char> (data[i]);
+	    h *= FnvPrime;
+	}
+
+	return h;
+    }
+
+    uint64_t
+    hash (const std::string &s, uint64_t h = FnvOffset)
+    {
+	/* Include the terminator so "ab" + "c" != "a" + "bc" */
+	return hash (s.c_str (), s.size () + 1, h);
+    }
+
+    bool
+    createDirectory (const std::string &path)
+    {
+	if (mkdir (path.c_str (), 0700) == 0 || errno == EEXIST)
+	    return true;
+
+	if (errno != ENOENT)
+	    return false;
+
+	size_t pos = path.rfind ('/', path.size () - 1);
+	if (pos == std::string::npos || pos == 0)
+	    return false;
+
+	if (!createDirectory (path.substr (0, pos)))
+	    return false;
+
+	return mkdir (path.c_str (), 0700) == 0 || errno == EEXIST;
+    }
+
+    /* Names store () writes to before moving them into place,
+     * <key>.bin.<pid> */
+    bool
+    isTempFile (const std::string &name)
+    {
+	size_t pos = name.rfind (Suffix);
+
+	return pos != std::string::npos && pos > 0 &&
+	       name.size () > pos + strlen (Suffix) + 1 &&
+	       name[pos + strlen (Suffix)] == '.';
+    }
+}
+
+cgl::ProgramBinaryCache::ProgramBinaryCache (const std::string &directory,
+					     const std::string &driver) :
+    mDirectory (directory),
+    mDriver (hash (driver))
+{
+}
+
+std::string
+cgl::ProgramBinaryCache::defaultDirectory ()
+{
+    const char  *cacheHome = getenv ("XDG_CACHE_HOME");
+    std::string directory;
+
+    if (cacheHome && cacheHome[0] == '/')
+	directory = cacheHome;
+    else
+    {
+	const char *home = getenv ("HOME");
+
+	if (!home || !home[0])
+	    return std::string ();
+
+	directory = home;
+	directory += "/.cache";
+    }
+
+    return directory + "/compiz-1/glprograms";
+}
+
+cgl::ProgramBinaryCache::Key
+cgl::ProgramBinaryCache::key (const std::string &vertexShader,
+			      const std::string &fragmentShader) const
+{
+    return hash (fragmentShader, hash (vertexShader, mDriver));
+}
+
+std::string
+cgl::ProgramBinaryCache::path (Key key) const
+{
+    char name[17];
+
+    snprintf (name, sizeof (name), "%016llx",
+	      static_cast <unsigned long long> (key));
+
+    return mDirectory + "/" + name + Suffix;
+}
+
+bool
+cgl::ProgramBinaryCache::validate (const std::string &path,
+				   Key               key,
+				   unsigned int      &format,
+				   std::vector<char> &binary) const
+{
+    FILE   *fp = fopen (path.c_str (), "rb");
+    Header header;
+    bool   valid = false;
+
+    if (!fp)
+	return false;
+
+    if (fread (&header, sizeof (header), 1, fp) == 1 &&
+	memcmp (header.magic, Magic, sizeof (Magic)) == 0 &&
+	header.version == Version &&
+	header.driver == mDriver &&
+	header.key == key &&
+	header.length > 0 &&
+	header.length <= MaxBinarySize)
+    {
+	std::vector<char> data (header.length);
+
+	if (fread (&data[0], 1, data.size (), fp) == data.size () &&
+	    fgetc (fp) == EOF &&
+	    hash (&data[0], data.size ()) == header.checksum)
+	{
+	    valid = true;
+	    format = header.format;
+	    binary.swap (data);
+	}
+    }
+
+    fclose (fp);
+
+    return valid;
+}
+
+bool
+cgl::ProgramBinaryCache::load (Key               key,
+			       unsigned int      &format,
+			       std::vector<char> &binary) const
+{
+    if (mDirectory.empty ())
+	return false;
+
+    std::string file (path (key));
+
+    if (validate (file, key, format, binary))
+	return true;
+
+    unlink (file.c_str ());
+    return false;
+}
+
+bool
+cgl::ProgramBinaryCache::store (Key                     key,
+				unsigned int            format,
+				const std::vector<char> &binary)
+{
+    if (mDirectory.empty () ||
+	binary.empty () ||
+	binary.size () > MaxBinarySize ||
+	!createDirectory (mDirectory))
+	return false;
+
+    Header header;
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, Magic, sizeof (Magic));
+    header.driver = mDriver;
+    header.key = key;
+    header.checksum = hash (&binary[0], binary.size ());
+    header.version = Version;
+    header.format = format;
+    header.length = binary.size ();
+
+    /* Write a private copy first and move it into place, so that a
+     * concurrent reader never sees a partially written entry */
+    std::string file (path (key));
+    char        pid[16];
+
+    snprintf (pid, sizeof (pid), ".%d", static_cast <int> (getpid ()));
+
+    std::string tmp (file + pid);
+    FILE        *fp = fopen (tmp.c_str (), "wb");
+
+    if (!fp)
+	return false;
+
+    bool written = fwrite (&header, sizeof (header), 1, fp) == 1 &&
+		   fwrite (&binary[0], 1, binary.size (), fp) == binary.size ();
+
+    if (fclose (fp) != 0)
+	written = false;
+
+    if (!written || rename (tmp.c_str (), file.c_str ()) != 0)
+    {
+	unlink (tmp.c_str ());
+	return false;
+    }
+
+    return true;
+}
+
+void
+cgl::ProgramBinaryCache::remove (Key key) const
+{
+    if (!mDirectory.empty ())
+	unlink (path (key).c_str ());
+}
+
+unsigned int
+cgl::ProgramBinaryCache::prune (unsigned int maxAge) const
+{
+    if (mDirectory.empty ())
+	return 0;
+
+    DIR          *dir = opendir (mDirectory.c_str ());
+    unsigned int removed = 0;
+    time_t       now = time (NULL);
+
+    if (!dir)
+	return 0;
+
+    while (struct dirent *entry = readdir (dir))
+    {
+	std::string name (entry->d_name);
+
+	if (!isTempFile (name))
+	    continue;
+
+	std::string file (mDirectory + "/" + name);
+	struct stat st;
+
+	if (lstat (file.c_str (), &st) != 0 ||
+	    !S_ISREG (st.st_mode) ||
+	    now - st.st_mtime < static_cast <time_t> (maxAge))
+	    continue;
+
+	if (unlink (file.c_str ()) == 0)
+	    removed++;
+    }
+
+    closedir (dir);
+
+    return removed;
+}
+
+const std::string &
+cgl::ProgramBinaryCache::directory () const
+{
+    return mDirectory;
+}
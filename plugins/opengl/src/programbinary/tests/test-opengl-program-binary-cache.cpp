@@ -0,0 +1,286 @@
+/*
+ * Compiz, opengl plugin, GLSL program binary cache
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <gtest/gtest.h>
+
+#include "program-binary-cache.h"
+
+namespace cgl = compiz::opengl;
+
+namespace
+{
+    const std::string vertex ("void main () { gl_Position = vec4 (0.0); }");
+    const std::string fragment ("void main () { gl_FragColor = vec4 (1.0); }");
+    const std::string driver ("Vendor\nRenderer\n1.0");
+    const unsigned int format = 0x1234;
+
+    std::vector<char> binary (const char *contents)
+    {
+	return std::vector<char> (contents, contents + strlen (contents));
+    }
+
+    unsigned int countFiles (const std::string &directory)
+    {
+	DIR          *dir = opendir (directory.c_str ());
+	unsigned int count = 0;
+
+	if (!dir)
+	    return 0;
+
+	while (struct dirent *entry = readdir (dir))
+	    if (entry->d_name[0] != '.')
+		count++;
+
+	closedir (dir);
+	return count;
+    }
+
+    void createFile (const std::string &file, time_t age)
+    {
+	FILE *fp = fopen (file.c_str (), "wb");
+
+	ASSERT_TRUE (fp != NULL);
+	fclose (fp);
+
+	struct utimbuf times;
+	times.actime = times.modtime = time (NULL) - age;
+	ASSERT_EQ (0, utime (file.c_str (), &times));
+    }
+}
+
+class OpenGLProgramBinaryCache :
+    public ::testing::Test
+{
+    public:
+
+	void SetUp ()
+	{
+	    char tmpl[] = "/tmp/compiz-program-binary-XXXXXX";
+
+	    ASSERT_TRUE (mkdtemp (tmpl) != NULL);
+	    root = tmpl;
+	    directory = root + "/cache/glprograms";
+	}
+
+	void TearDown ()
+	{
+	    DIR *dir = opendir (directory.c_str ());
+
+	    if (dir)
+	    {
+		while (struct dirent *entry = readdir (dir))
+		    unlink ((directory + "/" + entry->d_name).c_str ());
+
+		closedir (dir);
+	    }
+
+	    rmdir (directory.c_str ());
+	    rmdir ((root + "/cache").c_str ());
+	    rmdir (root.c_str ());
+	}
+
+	std::string root;
+	std::string directory;
+};
+
+TEST_F (OpenGLProgramBinaryCache, MissIsReported)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    unsigned int            loadedFormat;
+    std::vector<char>       loaded;
+
+    EXPECT_FALSE (cache.load (cache.key (vertex, fragment), loadedFormat, loaded));
+}
+
+TEST_F (OpenGLProgramBinaryCache, StoredBinaryIsLoaded)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache::Key key = cache.key (vertex, fragment);
+    unsigned int            loadedFormat = 0;
+    std::vector<char>       loaded;
+
+    ASSERT_TRUE (cache.store (key, format, binary ("linked program")));
+    ASSERT_TRUE (cache.load (key, loadedFormat, loaded));
+
+    EXPECT_EQ (format, loadedFormat);
+    EXPECT_EQ (binary ("linked program"), loaded);
+}
+
+TEST_F (OpenGLProgramBinaryCache, KeyDependsOnSourcesAndDriver)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache other (directory, "Vendor\nRenderer\n1.1");
+
+    EXPECT_EQ (cache.key (vertex, fragment), cache.key (vertex, fragment));
+    EXPECT_NE (cache.key (vertex, fragment), cache.key (fragment, vertex));
+    EXPECT_NE (cache.key (vertex, fragment), cache.key (vertex, fragment + " "));
+    EXPECT_NE (cache.key (vertex, fragment), other.key (vertex, fragment));
+    EXPECT_NE (cache.key ("ab", "c"), cache.key ("a", "bc"));
+}
+
+TEST_F (OpenGLProgramBinaryCache, OtherDriverCannotLoad)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache other (directory, "Vendor\nRenderer\n1.1");
+    cgl::ProgramBinaryCache::Key key = cache.key (vertex, fragment);
+    unsigned int            loadedFormat;
+    std::vector<char>       loaded;
+
+    ASSERT_TRUE (cache.store (key, format, binary ("linked program")));
+    EXPECT_FALSE (other.load (key, loadedFormat, loaded));
+}
+
+TEST_F (OpenGLProgramBinaryCache, CorruptEntryIsRejectedAndRemoved)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache::Key key = cache.key (vertex, fragment);
+    unsigned int            loadedFormat;
+    std::vector<char>       loaded;
+
+    ASSERT_TRUE (cache.store (key, format, binary ("linked program")));
+    ASSERT_EQ (1, countFiles (directory));
+
+    /* Flip the last byte of the binary */
+    char name[17];
+    snprintf (name, sizeof (name), "%016llx", (unsigned long long) key);
+    std::string file (directory + "/" + name + ".bin");
+    FILE *fp = fopen (file.c_str (), "r+b");
+    ASSERT_TRUE (fp != NULL);
+    fseek (fp, -1, SEEK_END);
+    fputc ('X', fp);
+    fclose (fp);
+
+    EXPECT_FALSE (cache.load (key, loadedFormat, loaded));
+    EXPECT_EQ (0, countFiles (directory));
+}
+
+TEST_F (OpenGLProgramBinaryCache, TruncatedEntryIsRejected)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache::Key key = cache.key (vertex, fragment);
+    unsigned int            loadedFormat;
+    std::vector<char>       loaded;
+
+    ASSERT_TRUE (cache.store (key, format, binary ("linked program")));
+
+    char name[17];
+    snprintf (name, sizeof (name), "%016llx", (unsigned long long) key);
+    ASSERT_EQ (0, truncate ((directory + "/" + name + ".bin").c_str (), 20));
+
+    EXPECT_FALSE (cache.load (key, loadedFormat, loaded));
+}
+
+TEST_F (OpenGLProgramBinaryCache, RemoveDeletesEntry)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache::Key key = cache.key (vertex, fragment);
+    unsigned int            loadedFormat;
+    std::vector<char>       loaded;
+
+    ASSERT_TRUE (cache.store (key, format, binary ("linked program")));
+    cache.remove (key);
+
+    EXPECT_FALSE (cache.load (key, loadedFormat, loaded));
+}
+
+TEST_F (OpenGLProgramBinaryCache, PruneOnlyRemovesStaleTemporaryFiles)
+{
+    const unsigned int      age = cgl::ProgramBinaryCache::StaleTempAge;
+    cgl::ProgramBinaryCache cache (directory, driver);
+    cgl::ProgramBinaryCache other (directory, "Vendor\nRenderer\n1.1");
+
+    ASSERT_TRUE (cache.store (cache.key (vertex, fragment), format, binary ("a")));
+    ASSERT_TRUE (other.store (other.key (vertex, fragment), format, binary ("c")));
+
+    /* A crashed store, and one which might still be in progress */
+    createFile (directory + "/0123456789abcdef.bin.42", age + 60);
+    createFile (directory + "/fedcba9876543210.bin.43", 0);
+
+    /* Old entries are not temporary files, however they look */
+    createFile (directory + "/00000000000000ff.bin", age + 60);
+
+    ASSERT_EQ (5, countFiles (directory));
+    EXPECT_EQ (1, cache.prune ());
+    EXPECT_EQ (4, countFiles (directory));
+
+    unsigned int      loadedFormat;
+    std::vector<char> loaded;
+
+    EXPECT_TRUE (other.load (other.key (vertex, fragment), loadedFormat, loaded));
+    EXPECT_EQ (binary ("c"), loaded);
+
+    EXPECT_EQ (1, cache.prune (0));
+    EXPECT_EQ (3, countFiles (directory));
+}
+
+TEST_F (OpenGLProgramBinaryCache, EmptyBinaryIsNotStored)
+{
+    cgl::ProgramBinaryCache cache (directory, driver);
+
+    EXPECT_FALSE (cache.store (cache.key (vertex, fragment), format,
+			       std::vector<char> ()));
+}
+
+TEST_F (OpenGLProgramBinaryCache, NoDirectoryDisablesCache)
+{
+    cgl::ProgramBinaryCache cache ("", driver);
+    unsigned int            loadedFormat;
+    std::vector<char>       loaded;
+
+    EXPECT_FALSE (cache.store (1, format, binary ("linked program")));
+    EXPECT_FALSE (cache.load (1, loadedFormat, loaded));
+    EXPECT_EQ (0, cache.prune ());
+}
+
+TEST (OpenGLProgramBinaryCacheDirectory, FollowsXdgCacheHome)
+{
+    const char  *oldCache = getenv ("XDG_CACHE_HOME");
+    const char  *oldHome = getenv ("HOME");
+    std::string savedCache (oldCache ? oldCache : "");
+    std::string savedHome (oldHome ? oldHome : "");
+
+    setenv ("XDG_CACHE_HOME", "/somewhere/cache", 1);
+    EXPECT_EQ ("/somewhere/cache/compiz-1/glprograms",
+	       cgl::ProgramBinaryCache::defaultDirectory ());
+
+    unsetenv ("XDG_CACHE_HOME");
+    setenv ("HOME", "/home/someone", 1);
+    EXPECT_EQ ("/home/someone/.cache/compiz-1/glprograms",
+	       cgl::ProgramBinaryCache::defaultDirectory ());
+
+    if (oldCache)
+	setenv ("XDG_CACHE_HOME", savedCache.c_str (), 1);
+
+    if (oldHome)
+	setenv ("HOME", savedHome.c_str (), 1);
+}
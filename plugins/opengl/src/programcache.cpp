@@ -23,15 +23,24 @@
  * Authors: Travis Watkins <travis.watkins@linaro.org>
  */
 
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <opengl/programcache.h>
+#include <program-table.h>
 #include "privates.h"
 
-typedef std::list<std::string> access_history_t;
-typedef std::pair<boost::shared_ptr<GLProgram>, access_history_t::iterator> value;
+typedef std::list<unsigned int> access_history_t;
+
+struct CachedProgram
+{
+    std::string                       name;
+    compiz::opengl::ProgramKey::Value key;
+    boost::shared_ptr<GLProgram>      program;
+    access_history_t::iterator        access;
+};
 
 static GLProgram *
-compileProgram (std::string name, std::list<const GLShaderData*> shaders)
+compileProgram (const std::string &name, const std::list<const GLShaderData*> &shaders)
 {
     std::list<const GLShaderData*>::const_iterator it;
     std::string vertex_shader;
@@ -88,6 +97,34 @@ compileProgram (std::string name, std::list<const GLShaderData*> shaders)
     return new GLProgram (vertex_shader, fragment_shader);
 }
 
+// check a cached program's name against a shader list without
+// joining the shader names again
+static bool
+sameNames (const std::string &name, const std::list<const GLShaderData*> &shaders)
+{
+    std::list<const GLShaderData*>::const_iterator it;
+    std::string::size_type pos = 0;
+
+    for (it = shaders.begin (); it != shaders.end (); ++it)
+    {
+	const std::string &shaderName = (*it)->name;
+
+	if (it != shaders.begin ())
+	{
+	    if (pos >= name.length () || name[pos] != ':')
+		return false;
+	    ++pos;
+	}
+
+	if (name.compare (pos, shaderName.length (), shaderName) != 0)
+	    return false;
+
+	pos += shaderName.length ();
+    }
+
+    return pos == name.length ();
+}
+
 class PrivateProgramCache
 {
     public:
@@ -95,9 +132,12 @@ class PrivateProgramCache
 
 	const size_t                 capacity;
 	access_history_t             access_history;
-	std::map<std::string, value> cache;
+	std::vector<CachedProgram>   programs;
+	std::vector<unsigned int>    freeSlots;
+	compiz::opengl::ProgramTable table;
 
-	void insert (std::string, GLProgram *);
+	void insert (compiz::opengl::ProgramKey::Value, const std::string &, GLProgram *);
+	void remove (unsigned int);
 	void evict ();
 };
 
@@ -112,9 +152,29 @@ GLProgramCache::~GLProgramCache ()
     delete priv;
 }
  
-GLProgram* GLProgramCache::operator () (std::list<const GLShaderData*> shaders)
+GLProgram* GLProgramCache::operator () (const std::list<const GLShaderData*> &shaders)
 {
     std::list<const GLShaderData*>::const_iterator name_it;
+    compiz::opengl::ProgramKey key;
+
+    for (name_it = shaders.begin(); name_it != shaders.end(); ++name_it)
+	key.add ((*name_it)->name);
+
+    unsigned int slot = priv->table.find (key.value ());
+
+    if (slot != compiz::opengl::ProgramTable::Missing &&
+	sameNames (priv->programs[slot].name, shaders))
+    {
+	CachedProgram &cached = priv->programs[slot];
+
+	// splice keeps cached.access pointing at the moved element
+	priv->access_history.splice (priv->access_history.end (),
+	                             priv->access_history,
+	                             cached.access);
+
+	return cached.program.get ();
+    }
+
     std::string name;
 
     for (name_it = shaders.begin(); name_it != shaders.end(); ++name_it)
@@ -125,41 +185,66 @@ GLProgram* GLProgramCache::operator () (std::list<const GLShaderData*> shaders)
 	    name += ":" + (*name_it)->name;
     }
 
-    std::map<std::string, value>::iterator it = priv->cache.find (name);
- 
-    if (it == priv->cache.end ())
-    {
-	GLProgram *program = compileProgram (name, shaders);
-	priv->insert (name, program);
-	return program;
-    }
-    else
-    {
-	priv->access_history.splice (priv->access_history.end (),
-	                             priv->access_history,
-	                             (*it).second.second);
-	(*it).second.second = priv->access_history.rbegin ().base ();
+    // two different shader lists hashed to the same key, the newer
+    // one replaces the older
+    if (slot != compiz::opengl::ProgramTable::Missing)
+	priv->remove (slot);
 
-	return (*it).second.first.get ();
-    }
+    GLProgram *program = compileProgram (name, shaders);
+    priv->insert (key.value (), name, program);
+    return program;
 }
 
 PrivateProgramCache::PrivateProgramCache (size_t c) :
-    capacity (c)
+    capacity (c),
+    table (c)
 {
+    programs.reserve (capacity);
 }
 
-void PrivateProgramCache::insert (std::string name, GLProgram *program)
+void PrivateProgramCache::insert (compiz::opengl::ProgramKey::Value key,
+				  const std::string                 &name,
+				  GLProgram                         *program)
 {
-    assert (cache.find (name) == cache.end ());
+    assert (table.find (key) == compiz::opengl::ProgramTable::Missing);
 
-    if (cache.size () == capacity)
+    if (access_history.size () == capacity)
 	evict ();
 
+    unsigned int slot;
+
+    if (freeSlots.empty ())
+    {
+	slot = programs.size ();
+	programs.push_back (CachedProgram ());
+    }
+    else
+    {
+	slot = freeSlots.back ();
+	freeSlots.pop_back ();
+    }
+
+    CachedProgram &cached = programs[slot];
+
+    cached.name = name;
+    cached.key = key;
+    cached.program.reset (program);
+
     // update most recently used GLProgram
-    access_history_t::iterator it = access_history.insert (access_history.end (), name);
+    cached.access = access_history.insert (access_history.end (), slot);
 
-    cache.insert (std::make_pair (name, std::make_pair (program, it)));
+    table.insert (key, slot);
+}
+
+void PrivateProgramCache::remove (unsigned int slot)
+{
+    CachedProgram &cached = programs[slot];
+
+    table.erase (cached.key);
+    access_history.erase (cached.access);
+    cached.program.reset ();
+    cached.name.clear ();
+    freeSlots.push_back (slot);
 }
 
 void PrivateProgramCache::evict ()
@@ -167,10 +252,5 @@ void PrivateProgramCache::evict ()
     assert (!access_history.empty ());
 
     // find least recently used GLProgram
-    std::map<std::string, value>::iterator it = cache.find (access_history.front ());
-    assert (it != cache.end ());
- 
-    cache.erase (it);
-    access_history.pop_front ();
+    remove (access_history.front ());
 }
-
@@ -0,0 +1,105 @@
+/*
+ * Compiz, opengl plugin, program key table
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_OPENGL_PROGRAM_TABLE_H
+#define _COMPIZ_OPENGL_PROGRAM_TABLE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace compiz
+{
+    namespace opengl
+    {
+	/*
+	 * Builds the key for a list of shaders without joining their
+	 * names into a string. Two lists of names produce the same
+	 * value if and only if their ":" joined names are equal (up to
+	 * hash collisions, which the caller must check for).
+	 */
+	class ProgramKey
+	{
+	    public:
+
+		typedef uint64_t Value;
+
+		ProgramKey ();
+
+		void add (const std::string &name);
+		void add (int value);
+
+		Value value () const;
+
+	    private:
+
+		Value mValue;
+		bool  mEmpty;
+	};
+
+	/*
+	 * Maps keys to small integers (usually an index into an array
+	 * of cached objects) with open addressing and linear probing
+	 * in a single flat array, so that a lookup touches a couple of
+	 * adjacent slots instead of chasing tree nodes.
+	 */
+	class ProgramTable
+	{
+	    public:
+
+		typedef uint64_t Key;
+
+		static const unsigned int Missing = ~0u;
+
+		ProgramTable (unsigned int expected = 16);
+
+		/* Returns the value stored for key, or Missing */
+		unsigned int find (Key key) const;
+
+		/* Stores value for key, replacing any earlier value */
+		void insert (Key key, unsigned int value);
+
+		bool erase (Key key);
+		void clear ();
+
+		unsigned int size () const;
+		unsigned int capacity () const;
+
+	    private:
+
+		struct Slot
+		{
+		    Key          key;
+		    unsigned int value;
+		};
+
+		unsigned int home (Key key) const;
+		void grow ();
+
+		std::vector <Slot> mSlots;
+		unsigned int       mMask;
+		unsigned int       mSize;
+	};
+    } // namespace opengl
+} // namespace compiz
+#endif
@@ -0,0 +1,217 @@
+/*
+ * Compiz, opengl plugin, program key table
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "program-table.h"
+
+namespace cgl = compiz::opengl;
+
+namespace
+{
+    const cgl::ProgramKey::Value FNVOffsetBasis = 0xcbf29ce484222325ULL;
+    const cgl::ProgramKey::Value FNVPrime = 0x100000001b3ULL;
+
+    inline cgl::ProgramKey::Value
+    mix (cgl::ProgramKey::Value value, unsigned char byte)
+    {
+	return (value ^ byte) * FNVPrime;
+    }
+}
+
+cgl::ProgramKey::ProgramKey () :
+    mValue (FNVOffsetBasis),
+    mEmpty (true)
+{
+}
+
+void
+cgl::ProgramKey::add (const std::string &name)
+{
+    if (!mEmpty)
+	mValue = mix (mValue, ':');
+
+    for (std::string::const_iterator it = name.begin (); it != name.end (); ++it)
+	mValue = mix (mValue, static_cast <unsigned char> (*it));
+
+    mEmpty = false;
+}
+
+void
+cgl::ProgramKey::add (int value)
+{
+    unsigned int bits = static_cast <unsigned int> (value);
+
+    if (!mEmpty)
+	mValue = mix (mValue, ':');
+
+    for (unsigned int i = 0; i < sizeof (bits); i++)
+	mValue = mix (mValue, (bits >> (i * 8)) & 0xff);
+
+    mEmpty = false;
+}
+
+cgl::ProgramKey::Value
+cgl::ProgramKey::value () const
+{
+    return mValue;
+}
+
+const unsigned int cgl::ProgramTable::Missing;
+
+cgl::ProgramTable::ProgramTable (unsigned int expected) :
+    mMask (0),
+    mSize (0)
+{
+    unsigned int capacity = 8;
+
+    /* Keep the table at most half full */
+    while (capacity < expected * 2)
+	capacity *= 2;
+
+    Slot empty = { 0, Missing };
+    mSlots.assign (capacity, empty);
+    mMask = capacity - 1;
+}
+
+unsigned int
+cgl::ProgramTable::home (Key key) const
+{
+    /* Small keys such as GLShaderParameters::hash () are not spread
+     * over the whole range, so finish them off before masking */
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+
+    return static_cast <unsigned int> (key) & mMask;
+}
+
+unsigned int
+cgl::ProgramTable::find (Key key) const
+{
+    for (unsigned int i = home (key);; i = (i + 1) & mMask)
+    {
+	const Slot &slot = mSlots[i];
+
+	if (slot.value == Missing)
+	    return Missing;
+	else if (slot.key == key)
+	    return slot.value;
+    }
+}
+
+void
+cgl::ProgramTable::insert (Key key, unsigned int value)
+{
+    if ((mSize + 1) * 2 > mSlots.size ())
+	grow ();
+
+    for (unsigned int i = home (key);; i = (i + 1) & mMask)
+    {
+	Slot &slot = mSlots[i];
+
+	if (slot.value == Missing)
+	{
+	    slot.key = key;
+	    slot.value = value;
+	    ++mSize;
+	    return;
+	}
+	else if (slot.key == key)
+	{
+	    slot.value = value;
+	    return;
+	}
+    }
+}
+
+bool
+cgl::ProgramTable::erase (Key key)
+{
+    unsigned int i = home (key);
+
+    while (mSlots[i].key != key || mSlots[i].value == Missing)
+    {
+	if (mSlots[i].value == Missing)
+	    return false;
+
+	i = (i + 1) & mMask;
+    }
+
+    /* Shift the following entries of the cluster back instead of
+     * leaving a tombstone, so lookups never get slower over time */
+    for (unsigned int j = (i + 1) & mMask;
+	 mSlots[j].value != Missing;
+	 j = (j + 1) & mMask)
+    {
+	unsigned int h = home (mSlots[j].key);
+
+	/* Move j into the hole at i unless its home lies in (i, j] */
+	if ((j > i && (h <= i || h > j)) ||
+	    (j < i && (h <= i && h > j)))
+	{
+	    mSlots[i] = mSlots[j];
+	    i = j;
+	}
+    }
+
+    mSlots[i].value = Missing;
+    --mSize;
+
+    return true;
+}
+
+void
+cgl::ProgramTable::clear ()
+{
+    Slot empty = { 0, Missing };
+
+    mSlots.assign (mSlots.size (), empty);
+    mSize = 0;
+}
+
+unsigned int
+cgl::ProgramTable::size () const
+{
+    return mSize;
+}
+
+unsigned int
+cgl::ProgramTable::capacity () const
+{
+    return mSlots.size ();
+}
+
+void
+cgl::ProgramTable::grow ()
+{
+    std::vector <Slot> old;
+    Slot empty = { 0, Missing };
+
+    old.swap (mSlots);
+    mSlots.assign (old.size () * 2, empty);
+    mMask = mSlots.size () - 1;
+    mSize = 0;
+
+    for (std::vector <Slot>::const_iterator it = old.begin (); it != old.end (); ++it)
+	if (it->value != Missing)
+	    insert (it->key, it->value);
+}
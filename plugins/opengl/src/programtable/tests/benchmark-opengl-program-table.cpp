@@ -0,0 +1,269 @@
+/*
+ * Compiz, opengl plugin, program key table
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Replays the program lookups the opengl plugin makes while painting a
+ * frame with the animation and decor plugins active: every window
+ * draws its decoration and its contents, and the windows being
+ * animated are drawn with opacity, brightness and saturation changing
+ * from frame to frame. Each draw resolves its GLShaderParameters to
+ * shader data and then the shader list to a program, once the way
+ * GLProgramCache used to (joining the names into a string and looking
+ * it up in a std::map) and once through ProgramKey and ProgramTable.
+ */
+
+#include "program-table.h"
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cgl = compiz::opengl;
+
+namespace
+{
+    const unsigned int frames = 2000;
+
+    struct Params
+    {
+	bool opacity;
+	bool brightness;
+	bool saturation;
+	int  numTextures;
+
+	int hash () const
+	{
+	    return opacity | (brightness << 1) | (saturation << 2) |
+		   (numTextures << 8);
+	}
+
+	std::string id () const
+	{
+	    std::string s;
+
+	    s += opacity ? "t" : "f";
+	    s += brightness ? "t" : "f";
+	    s += saturation ? "t" : "f";
+	    s += "nu";
+	    s += static_cast <char> ('0' + numTextures);
+
+	    return s;
+	}
+    };
+
+    struct Shader
+    {
+	std::string name;
+    };
+
+    /* Stand-in for a GLProgram */
+    struct Program
+    {
+	std::string name;
+    };
+
+    double
+    elapsedMs (const struct timeval &start)
+    {
+	struct timeval now;
+	gettimeofday (&now, NULL);
+
+	return (now.tv_sec - start.tv_sec) * 1000.0 +
+	       (now.tv_usec - start.tv_usec) / 1000.0;
+    }
+
+    /* The parameters of every draw in one frame */
+    std::vector <Params>
+    frameDraws (unsigned int windows, unsigned int animated, unsigned int frame)
+    {
+	std::vector <Params> draws;
+
+	for (unsigned int i = 0; i < windows; i++)
+	{
+	    bool animating = i < animated;
+	    Params p;
+
+	    p.opacity = animating && (frame + i) % 4 != 0;
+	    p.brightness = animating && (frame + i) % 3 == 0;
+	    p.saturation = animating && (frame + i) % 5 == 0;
+	    p.numTextures = 1;
+
+	    /* Decoration, then contents */
+	    draws.push_back (p);
+	    draws.push_back (p);
+	}
+
+	return draws;
+    }
+
+    class StringLookup
+    {
+	public:
+
+	    ~StringLookup ()
+	    {
+		for (std::map <std::string, Program *>::iterator it = programs.begin ();
+		     it != programs.end (); ++it)
+		    delete it->second;
+	    }
+
+	    const Program *
+	    lookup (const Params &params)
+	    {
+		std::map <int, Shader>::iterator sit = shaders.find (params.hash ());
+
+		if (sit == shaders.end ())
+		{
+		    Shader shader;
+		    shader.name = params.id ();
+		    sit = shaders.insert (std::make_pair (params.hash (), shader)).first;
+		}
+
+		std::list <const Shader *> list;
+		list.push_back (&sit->second);
+
+		std::string name;
+		for (std::list <const Shader *>::const_iterator it = list.begin ();
+		     it != list.end (); ++it)
+		{
+		    if (name.length () == 0)
+			name += (*it)->name;
+		    else
+			name += ":" + (*it)->name;
+		}
+
+		std::map <std::string, Program *>::iterator pit = programs.find (name);
+
+		if (pit == programs.end ())
+		{
+		    Program *program = new Program;
+		    program->name = name;
+		    pit = programs.insert (std::make_pair (name, program)).first;
+		}
+
+		return pit->second;
+	    }
+
+	private:
+
+	    std::map <int, Shader>              shaders;
+	    std::map <std::string, Program *>   programs;
+    };
+
+    class TableLookup
+    {
+	public:
+
+	    ~TableLookup ()
+	    {
+		for (unsigned int i = 0; i < programs.size (); i++)
+		    delete programs[i];
+	    }
+
+	    const Program *
+	    lookup (const Params &params)
+	    {
+		unsigned int s = shaderTable.find (params.hash ());
+
+		if (s == cgl::ProgramTable::Missing)
+		{
+		    Shader shader;
+		    shader.name = params.id ();
+		    s = shaders.size ();
+		    shaders.push_back (shader);
+		    shaderTable.insert (params.hash (), s);
+		}
+
+		cgl::ProgramKey key;
+		key.add (shaders[s].name);
+
+		unsigned int p = programTable.find (key.value ());
+
+		if (p == cgl::ProgramTable::Missing ||
+		    programs[p]->name != shaders[s].name)
+		{
+		    Program *program = new Program;
+		    program->name = shaders[s].name;
+		    p = programs.size ();
+		    programs.push_back (program);
+		    programTable.insert (key.value (), p);
+		}
+
+		return programs[p];
+	    }
+
+	private:
+
+	    cgl::ProgramTable        shaderTable;
+	    std::vector <Shader>     shaders;
+	    cgl::ProgramTable        programTable;
+	    std::vector <Program *>  programs;
+    };
+
+    template <typename Lookup>
+    double
+    run (const std::vector <std::vector <Params> > &frameList,
+	 const Program                            *&sink)
+    {
+	Lookup lookup;
+	struct timeval start;
+
+	gettimeofday (&start, NULL);
+
+	for (unsigned int f = 0; f < frameList.size (); f++)
+	    for (unsigned int d = 0; d < frameList[f].size (); d++)
+		sink = lookup.lookup (frameList[f][d]);
+
+	return elapsedMs (start) * 1000.0 / frameList.size ();
+    }
+}
+
+int
+main ()
+{
+    const unsigned int counts[] = { 10, 30, 100 };
+    const Program *sink = NULL;
+
+    printf ("%8s %8s %16s %20s %16s\n", "windows", "animated",
+	    "lookups/frame", "string+map (us)", "table (us)");
+
+    for (unsigned int i = 0; i < sizeof (counts) / sizeof (counts[0]); i++)
+    {
+	std::vector <std::vector <Params> > frameList;
+	unsigned int animated = counts[i] / 3;
+
+	for (unsigned int f = 0; f < frames; f++)
+	    frameList.push_back (frameDraws (counts[i], animated, f));
+
+	printf ("%8u %8u %16u %20.3f %16.3f\n", counts[i], animated,
+		static_cast <unsigned int> (frameList[0].size ()),
+		run <StringLookup> (frameList, sink),
+		run <TableLookup> (frameList, sink));
+    }
+
+    return sink ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/*
+ * Compiz, opengl plugin, program key table
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <map>
+#include <stdlib.h>
+
+#include "program-table.h"
+
+namespace cgl = compiz::opengl;
+
+namespace
+{
+    cgl::ProgramKey::Value
+    keyOf (const char *first, const char *second = NULL)
+    {
+	cgl::ProgramKey key;
+
+	key.add (std::string (first));
+	if (second)
+	    key.add (std::string (second));
+
+	return key.value ();
+    }
+}
+
+TEST (OpenGLProgramKey, SameNamesGiveSameKey)
+{
+    EXPECT_EQ (keyOf ("blur", "tffn1"), keyOf ("blur", "tffn1"));
+}
+
+TEST (OpenGLProgramKey, OrderMatters)
+{
+    EXPECT_NE (keyOf ("blur", "tffn1"), keyOf ("tffn1", "blur"));
+}
+
+TEST (OpenGLProgramKey, NamesAreSeparated)
+{
+    /* "ab" + "c" must not collide with "a" + "bc" */
+    EXPECT_NE (keyOf ("ab", "c"), keyOf ("a", "bc"));
+    EXPECT_NE (keyOf ("ab", "c"), keyOf ("abc"));
+}
+
+TEST (OpenGLProgramKey, MatchesJoinedName)
+{
+    EXPECT_EQ (keyOf ("blur:tffn1"), keyOf ("blur", "tffn1"));
+}
+
+TEST (OpenGLProgramKey, IntegersAreDistinct)
+{
+    cgl::ProgramKey a, b;
+
+    a.add (1);
+    b.add (256);
+
+    EXPECT_NE (a.value (), b.value ());
+}
+
+TEST (OpenGLProgramTable, EmptyTableFindsNothing)
+{
+    cgl::ProgramTable table;
+
+    EXPECT_EQ (cgl::ProgramTable::Missing, table.find (42));
+    EXPECT_EQ (0, table.size ());
+}
+
+TEST (OpenGLProgramTable, FindsInsertedValues)
+{
+    cgl::ProgramTable table;
+
+    table.insert (1, 10);
+    table.insert (2, 20);
+
+    EXPECT_EQ (10, table.find (1));
+    EXPECT_EQ (20, table.find (2));
+    EXPECT_EQ (2, table.size ());
+}
+
+TEST (OpenGLProgramTable, InsertReplacesValue)
+{
+    cgl::ProgramTable table;
+
+    table.insert (1, 10);
+    table.insert (1, 11);
+
+    EXPECT_EQ (11, table.find (1));
+    EXPECT_EQ (1, table.size ());
+}
+
+TEST (OpenGLProgramTable, GrowsAndKeepsValues)
+{
+    cgl::ProgramTable table (4);
+    unsigned int initial = table.capacity ();
+
+    for (unsigned int i = 0; i < 100; i++)
+	table.insert (i, i * 3);
+
+    EXPECT_GT (table.capacity (), initial);
+    EXPECT_LE (table.size () * 2, table.capacity ());
+
+    for (unsigned int i = 0; i < 100; i++)
+	EXPECT_EQ (i * 3, table.find (i));
+}
+
+TEST (OpenGLProgramTable, EraseRemovesOnlyThatKey)
+{
+    cgl::ProgramTable table;
+
+    table.insert (1, 10);
+    table.insert (2, 20);
+
+    EXPECT_TRUE (table.erase (1));
+    EXPECT_FALSE (table.erase (1));
+
+    EXPECT_EQ (cgl::ProgramTable::Missing, table.find (1));
+    EXPECT_EQ (20, table.find (2));
+    EXPECT_EQ (1, table.size ());
+}
+
+TEST (OpenGLProgramTable, EraseKeepsCollidingKeysReachable)
+{
+    /* Fill a small table so that clusters form and wrap around,
+     * then erase every other key and check the rest survive */
+    cgl::ProgramTable table (8);
+
+    for (unsigned int i = 0; i < 8; i++)
+	table.insert (i * 0x100000001ULL, i);
+
+    for (unsigned int i = 0; i < 8; i += 2)
+	EXPECT_TRUE (table.erase (i * 0x100000001ULL));
+
+    for (unsigned int i = 0; i < 8; i++)
+	EXPECT_EQ (i % 2 ? i : cgl::ProgramTable::Missing,
+		   table.find (i * 0x100000001ULL));
+}
+
+TEST (OpenGLProgramTable, ClearEmptiesTable)
+{
+    cgl::ProgramTable table;
+
+    table.insert (1, 10);
+    table.clear ();
+
+    EXPECT_EQ (cgl::ProgramTable::Missing, table.find (1));
+    EXPECT_EQ (0, table.size ());
+}
+
+TEST (OpenGLProgramTable, BehavesLikeAMap)
+{
+    cgl::ProgramTable table (4);
+    std::map <cgl::ProgramTable::Key, unsigned int> reference;
+
+    srand (1);
+    for (unsigned int i = 0; i < 10000; i++)
+    {
+	cgl::ProgramTable::Key key = rand () % 64;
+
+	if (rand () % 3)
+	{
+	    table.insert (key, i);
+	    reference[key] = i;
+	}
+	else
+	{
+	    EXPECT_EQ (reference.erase (key) == 1, table.erase (key));
+	}
+    }
+
+    EXPECT_EQ (reference.size (), table.size ());
+
+    for (cgl::ProgramTable::Key key = 0; key < 64; key++)
+    {
+	if (reference.count (key))
+	    EXPECT_EQ (reference[key], table.find (key));
+	else
+	    EXPECT_EQ (cgl::ProgramTable::Missing, table.find (key));
+    }
+}
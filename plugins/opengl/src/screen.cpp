@@ -43,6 +43,14 @@
 
 template class WrapableInterface<GLScreen, GLScreenInterface>;
 
+#ifndef GLX_BACK_BUFFER_AGE_EXT
+#define GLX_BACK_BUFFER_AGE_EXT 0x20F4
+#endif
+
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+
 #ifndef USE_GLES
 /*
  * Historically most versions of fglrx have contained a nasty hack that checks
@@ -116,6 +124,10 @@ namespace GL {
     GLBufferDataProc    bufferData = NULL;
     GLBufferSubDataProc bufferSubData = NULL;
 
+    GLGetProgramBinaryProc  getProgramBinary = NULL;
+    GLProgramBinaryProc     programBinary = NULL;
+    GLProgramParameteriProc programParameteri = NULL;
+
     GLGetShaderivProc        getShaderiv = NULL;
     GLGetShaderInfoLogProc   getShaderInfoLog = NULL;
     GLGetProgramivProc       getProgramiv = NULL;
@@ -185,6 +197,8 @@ namespace GL {
     bool  vboSupported = false;
     bool  vboEnabled = false;
     bool  shaders = false;
+    bool  programBinaries = false;
+    bool  bufferAge = false;
     GLint maxTextureUnits = 1;
 
     bool canDoSaturated = false;
@@ -286,17 +300,22 @@ CompOutput *targetOutput = NULL;
 class GLScreenAutoProgram : public GLVertexBuffer::AutoProgram
 {
 public:
-    GLScreenAutoProgram (GLScreen *gScreen) : gScreen(gScreen) {}
+    GLScreenAutoProgram (PrivateGLScreen *pScreen) :
+	pScreen (pScreen),
+	shaders (1, NULL)
+    {
+    }
 
     GLProgram *getProgram (GLShaderParameters &params)
     {
-        const GLShaderData *shaderData = gScreen->getShaderData (params);
-        std::list<const GLShaderData *> tempShaders;
-        tempShaders.push_back (shaderData);
-        return gScreen->getProgram (tempShaders);
+	// reuse the one element list rather than allocating a new one
+	// (and copying it through GLScreen::getProgram) on every draw
+	shaders.front () = &pScreen->shaderCache.getShaderData (params);
+	return (*pScreen->programCache) (shaders);
     }
 
-    GLScreen *gScreen;
+    PrivateGLScreen *pScreen;
+    std::list<const GLShaderData *> shaders;
 };
 
 #ifndef USE_GLES
@@ -513,6 +532,8 @@ GLScreen::glInitContext (XVisualInfo *visinfo)
 	GL::postSubBuffer = (GL::EGLPostSubBufferNVProc)
 	    eglGetProcAddress ("eglPostSubBufferNV");
 
+    GL::bufferAge = strstr (eglExtensions, "EGL_EXT_buffer_age");
+
     GL::fboStencilSupported = GL::fboSupported &&
         strstr (glExtensions, "GL_OES_packed_depth_stencil");
 
@@ -897,6 +918,8 @@ GLScreen::glInitContext (XVisualInfo *visinfo)
 	registerBindPixmap (TfpTexture::bindPixmapToTexture);
 #endif
 
+    priv->initProgramBinaries ();
+
     if (GL::fboSupported)
     {
 	priv->scratchFbo = new GLFramebufferObject;
@@ -1037,6 +1060,8 @@ GLScreen::GLScreen (CompScreen *s) :
 	GL::copySubBuffer = (GL::GLXCopySubBufferProc)
 	    getProcAddress ("glXCopySubBufferMESA");
 
+    GL::bufferAge = strstr (glxExtensions, "GLX_EXT_buffer_age");
+
     if (strstr (glxExtensions, "GLX_SGI_video_sync"))
     {
 	GL::getVideoSync = (GL::GLXGetVideoSyncProc)
@@ -1193,6 +1218,9 @@ GLScreen::~GLScreen ()
     if (priv->hasCompositing)
 	CompositeScreen::get (screen)->unregisterPaintHandler ();
 
+    // Still needs the context
+    PrivateVertexBuffer::releaseStreamBuffer ();
+
     #ifdef USE_GLES
     Display *xdpy = screen->dpy ();
     EGLDisplay dpy = eglGetDisplay (xdpy);
@@ -1242,15 +1270,24 @@ PrivateGLScreen::PrivateGLScreen (GLScreen   *gs) :
     commonFrontbuffer (true),
     incorrectRefreshRate (false),
     programCache (new GLProgramCache (30)),
+    programBinaries (NULL),
     shaderCache (),
-    autoProgram (new GLScreenAutoProgram(gs)),
+    autoProgram (new GLScreenAutoProgram (this)),
     rootPixmapCopy (None),
     rootPixmapSize (),
     glVendor (NULL),
     glRenderer (NULL),
     glVersion (NULL),
     prevRegex (),
-    prevBlacklisted (false)
+    prevBlacklisted (false),
+    occlusion (),
+    occlusionValid (false),
+    occlusionOutput (NULL),
+    occlusionBounds (),
+    occlusionMask (0),
+    occlusionOffset (),
+    frameDrawCalls (0),
+    frameProgramBinds (0)
 {
     ScreenInterface::setHandler (screen);
 }
@@ -1260,6 +1297,10 @@ PrivateGLScreen::~PrivateGLScreen ()
     delete projection;
     delete programCache;
     delete autoProgram;
+
+    if (PrivateProgram::binaryCache == programBinaries)
+	PrivateProgram::binaryCache = NULL;
+    delete programBinaries;
     if (rootPixmapCopy)
 	XFreePixmap (screen->dpy (), rootPixmapCopy);
 
@@ -1859,6 +1900,19 @@ GLXDoubleBuffer::blit (const CompRegion &region) const
     }
 }
 
+int
+GLXDoubleBuffer::queryBufferAge () const
+{
+    unsigned int age = 0;
+
+    if (!GL::bufferAge)
+	return -1;
+
+    glXQueryDrawable (mDpy, mOutput, GLX_BACK_BUFFER_AGE_EXT, &age);
+
+    return age;
+}
+
 bool
 GLXDoubleBuffer::fallbackBlitAvailable () const
 {
@@ -1941,6 +1995,19 @@ EGLDoubleBuffer::blit (const CompRegion &region) const
     }
 }
 
+int
+EGLDoubleBuffer::queryBufferAge () const
+{
+    EGLint age = 0;
+
+    if (!GL::bufferAge ||
+	!eglQuerySurface (eglGetDisplay (mDpy), mSurface,
+			  EGL_BUFFER_AGE_EXT, &age))
+	return -1;
+
+    return age;
+}
+
 bool
 EGLDoubleBuffer::fallbackBlitAvailable () const
 {
@@ -2009,6 +2076,18 @@ PrivateGLScreen::paintOutputs (CompOutput::ptrList &outputs,
     CompRegion tmpRegion = (mask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK) ?
                            screen->region () : region;
 
+    /*
+     * If we know what the back buffer is missing, repainting that along
+     * with the damage brings all of it up to date and it can be swapped
+     * instead of being copied to the front buffer piece by piece. With
+     * an FBO the damage is painted into the FBO as usual and only the
+     * stale region needs to be copied out of it.
+     */
+    CompRegion staleRegion;
+    bool partialSwap = !(mask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK) &&
+		       doubleBuffer.staleRegion (tmpRegion, staleRegion);
+    CompRegion paintRegion = (partialSwap && !useFbo) ? staleRegion : tmpRegion;
+
     foreach (CompOutput *output, outputs)
     {
 	XRectangle r;
@@ -2054,10 +2133,10 @@ PrivateGLScreen::paintOutputs (CompOutput::ptrList &outputs,
 	     * damaged region.
 	     */
 	    if (refreshSubBuffer)
-		tmpRegion = CompRegion (*output);
+		tmpRegion = paintRegion = CompRegion (*output);
 #endif
 
-	    outputRegion = tmpRegion & CompRegion (*output);
+	    outputRegion = paintRegion & CompRegion (*output);
 
 	    if (!gScreen->glPaintOutput (defaultScreenPaintAttrib,
 					 identity,
@@ -2072,6 +2151,7 @@ PrivateGLScreen::paintOutputs (CompOutput::ptrList &outputs,
 					PAINT_SCREEN_FULL_MASK);
 
 		tmpRegion += *output;
+		staleRegion += *output;
 	    }
 	}
     }
@@ -2086,9 +2166,16 @@ PrivateGLScreen::paintOutputs (CompOutput::ptrList &outputs,
 
 	// FIXME: does not work if screen dimensions exceed max texture size
 	//        We should try to use glBlitFramebuffer instead.
-	gScreen->glPaintCompositedOutput (screen->region (), scratchFbo, mask);
+	gScreen->glPaintCompositedOutput (partialSwap ? staleRegion :
+							screen->region (),
+					  scratchFbo, mask);
     }
 
+    frameDrawCalls = PrivateVertexBuffer::drawCalls;
+    PrivateVertexBuffer::drawCalls = 0;
+    frameProgramBinds = PrivateVertexBuffer::programBinds;
+    PrivateVertexBuffer::programBinds = 0;
+
     if (cScreen->outputWindowChanged ())
     {
 	/*
@@ -2101,7 +2188,8 @@ PrivateGLScreen::paintOutputs (CompOutput::ptrList &outputs,
     }
 
     bool alwaysSwap = optionGetAlwaysSwapBuffers ();
-    bool fullscreen = useFbo ||
+    bool fullscreen = partialSwap ||
+                      useFbo ||
                       alwaysSwap ||
                       ((mask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK) &&
                        commonFrontbuffer);
@@ -2170,6 +2258,82 @@ PrivateGLScreen::driverIsBlacklisted (const char *regex) const
     return prevBlacklisted;
 }
 
+void
+PrivateGLScreen::initProgramBinaries ()
+{
+    const char *glExtensions = (const char *) glGetString (GL_EXTENSIONS);
+    GLint      formats = 0;
+
+    if (!glExtensions || !GL::shaders)
+	return;
+
+    #ifdef USE_GLES
+    if (strstr (glExtensions, "GL_OES_get_program_binary"))
+    {
+	GL::getProgramBinary = (GL::GLGetProgramBinaryProc)
+	    eglGetProcAddress ("glGetProgramBinaryOES");
+	GL::programBinary = (GL::GLProgramBinaryProc)
+	    eglGetProcAddress ("glProgramBinaryOES");
+    }
+    #else
+    if (strstr (glExtensions, "GL_ARB_get_program_binary"))
+    {
+	GL::getProgramBinary = (GL::GLGetProgramBinaryProc)
+	    gScreen->getProcAddress ("glGetProgramBinary");
+	GL::programBinary = (GL::GLProgramBinaryProc)
+	    gScreen->getProcAddress ("glProgramBinary");
+	GL::programParameteri = (GL::GLProgramParameteriProc)
+	    gScreen->getProcAddress ("glProgramParameteri");
+    }
+    #endif
+
+    if (!GL::getProgramBinary || !GL::programBinary)
+	return;
+
+    // Some drivers advertise the extension without any binary formats
+    glGetIntegerv (GL::NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+	return;
+
+    GL::programBinaries = true;
+
+    // Same identification as driverIsBlacklisted uses
+    const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    CompString   driver;
+
+    for (unsigned int i = 0; i < sizeof (names) / sizeof (names[0]); i++)
+    {
+	const char *value = (const char *) glGetString (names[i]);
+
+	if (i)
+	    driver += "\n";
+	if (value)
+	    driver += value;
+    }
+
+    programBinaries =
+	new compiz::opengl::ProgramBinaryCache (
+	    compiz::opengl::ProgramBinaryCache::defaultDirectory (), driver);
+
+    // Entries are checked as they get loaded, this only drops what
+    // crashed instances left behind while storing
+    unsigned int pruned = programBinaries->prune ();
+
+    if (pruned)
+	compLogMessage ("opengl", CompLogLevelDebug,
+			"Removed %u stale temporary files from %s",
+			pruned, programBinaries->directory ().c_str ());
+
+    updateProgramBinaries ();
+}
+
+void
+PrivateGLScreen::updateProgramBinaries ()
+{
+    PrivateProgram::binaryCache =
+	optionGetProgramBinaryCache () ? programBinaries : NULL;
+}
+
 GLTexture::BindPixmapHandle
 GLScreen::registerBindPixmap (GLTexture::BindPixmapProc proc)
 {
@@ -2201,6 +2365,18 @@ GLScreen::fbo ()
     return priv->scratchFbo;
 }
 
+unsigned int
+GLScreen::drawCalls ()
+{
+    return priv->frameDrawCalls;
+}
+
+unsigned int
+GLScreen::programBinds ()
+{
+    return priv->frameProgramBinds;
+}
+
 GLTexture *
 GLScreen::defaultIcon ()
 {
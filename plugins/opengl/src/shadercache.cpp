@@ -22,25 +22,11 @@
  *
  * Authors: Alexandros Frantzis <alexandros.frantzis@linaro.org>
  */
-#include <map>
+#include <deque>
 #include <sstream>
 
 #include <opengl/shadercache.h>
-
-/** 
- * Compares two GLShaderParameters objects.
- */
-class GLShaderParametersComparer
-{
-public:
-    bool operator()(const GLShaderParameters &left, const GLShaderParameters &right) const
-    {
-        return left.hash() < right.hash();
-    }
-
-};
-
-typedef std::map<GLShaderParameters, GLShaderData, GLShaderParametersComparer> ShaderMapType;
+#include <program-table.h>
 
 /** 
  * Private data for GLPrivate
@@ -50,12 +36,15 @@ class PrivateShaderCache
 public:
     PrivateShaderCache() {}
 
-    ShaderMapType::const_iterator addShaderData(const GLShaderParameters &params);
+    unsigned int addShaderData(const GLShaderParameters &params);
 
     std::string createVertexShader (const GLShaderParameters &params);
     std::string createFragmentShader (const GLShaderParameters &params);
 
-    ShaderMapType shaderMap;
+    /** Indexes into shaders by GLShaderParameters::hash () */
+    compiz::opengl::ProgramTable shaderTable;
+    /** A deque so that references handed out stay valid */
+    std::deque<GLShaderData> shaders;
 };
 
 /**********************
@@ -108,21 +97,21 @@ GLShaderCache::~GLShaderCache ()
 const GLShaderData &
 GLShaderCache::getShaderData (const GLShaderParameters &params)
 {
-    ShaderMapType::const_iterator iter;
+    unsigned int index = priv->shaderTable.find (params.hash ());
 
     // Try to find a cached shader pair that matches the parameters.
     // If we don't have it cached, create it.
-    if ((iter = priv->shaderMap.find (params)) == priv->shaderMap.end ())
-        iter = priv->addShaderData (params);
+    if (index == compiz::opengl::ProgramTable::Missing)
+        index = priv->addShaderData (params);
 
-    return iter->second;
+    return priv->shaders[index];
 }
 
 /**********************
  * PrivateShaderCache *
  **********************/
 
-ShaderMapType::const_iterator
+unsigned int
 PrivateShaderCache::addShaderData (const GLShaderParameters &params)
 {
     GLShaderData shaderData;
@@ -131,10 +120,12 @@ PrivateShaderCache::addShaderData (const GLShaderParameters &params)
     shaderData.fragmentShader = createFragmentShader (params);
     shaderData.vertexShader = createVertexShader (params);
 
-    std::pair<ShaderMapType::iterator, bool> ret =
-        shaderMap.insert(std::pair<GLShaderParameters, GLShaderData>(params,shaderData));
+    unsigned int index = shaders.size ();
+
+    shaders.push_back (shaderData);
+    shaderTable.insert (params.hash (), index);
 
-    return ret.first;
+    return index;
 }
 
 /** 
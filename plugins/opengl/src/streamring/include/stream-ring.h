@@ -0,0 +1,85 @@
+/*
+ * Compiz, opengl plugin, streaming vertex ring buffer
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_OPENGL_STREAM_RING_H
+#define _COMPIZ_OPENGL_STREAM_RING_H
+
+#include <cstddef>
+
+namespace compiz
+{
+    namespace opengl
+    {
+	/*
+	 * Hands out space in one large, append-only buffer object so that
+	 * streamed geometry does not need a buffer object (and a
+	 * glBufferData) per array per draw. When the ring is full it
+	 * wraps around to the start, and the caller must orphan the
+	 * storage (glBufferData with NULL) before writing. This lets the
+	 * driver keep the old storage alive for draws still in flight
+	 * instead of stalling on them.
+	 */
+	class StreamRing
+	{
+	    public:
+
+		StreamRing (size_t capacity, size_t alignment = 16);
+
+		/*
+		 * Returns the offset at which bytes may be written.
+		 * orphan is set when the storage must be (re)allocated
+		 * at capacity () bytes before writing, either because
+		 * the ring wrapped or because it had to grow to fit
+		 * a single large reservation.
+		 */
+		size_t reserve (size_t bytes, bool &orphan);
+
+		/*
+		 * Forgets the storage, as when its buffer object got
+		 * deleted. The next reservation allocates it again,
+		 * and the generation moves on so that no offset handed
+		 * out so far is taken for valid data.
+		 */
+		void reset ();
+
+		/*
+		 * Incremented every time the storage is orphaned.
+		 * Offsets handed out under an older generation no
+		 * longer refer to valid data.
+		 */
+		unsigned int generation () const;
+
+		size_t capacity () const;
+		size_t used () const;
+
+	    private:
+
+		size_t       mCapacity;
+		size_t       mAlignment;
+		size_t       mHead;
+		unsigned int mGeneration;
+		bool         mAllocated;
+	};
+    } // namespace opengl
+} // namespace compiz
+#endif
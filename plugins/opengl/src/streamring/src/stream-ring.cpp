@@ -0,0 +1,93 @@
+/*
+ * Compiz, opengl plugin, streaming vertex ring buffer
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "stream-ring.h"
+
+namespace cgl = compiz::opengl;
+
+cgl::StreamRing::StreamRing (size_t capacity, size_t alignment) :
+    mCapacity (capacity),
+    mAlignment (alignment ? alignment : 1),
+    mHead (0),
+    mGeneration (0),
+    mAllocated (false)
+{
+    if (!mCapacity)
+	mCapacity = mAlignment;
+}
+
+size_t
+cgl::StreamRing::reserve (size_t bytes, bool &orphan)
+{
+    size_t offset = mHead;
+
+    /* The storage hasn't been allocated yet */
+    orphan = !mAllocated;
+
+    if (bytes > mCapacity)
+    {
+	while (mCapacity < bytes)
+	    mCapacity *= 2;
+
+	orphan = true;
+    }
+
+    if (orphan || offset + bytes > mCapacity)
+    {
+	offset = 0;
+	orphan = true;
+	mAllocated = true;
+	++mGeneration;
+    }
+
+    mHead = offset + bytes;
+    mHead += (mAlignment - mHead % mAlignment) % mAlignment;
+
+    return offset;
+}
+
+void
+cgl::StreamRing::reset ()
+{
+    mHead = 0;
+    mAllocated = false;
+    ++mGeneration;
+}
+
+unsigned int
+cgl::StreamRing::generation () const
+{
+    return mGeneration;
+}
+
+size_t
+cgl::StreamRing::capacity () const
+{
+    return mCapacity;
+}
+
+size_t
+cgl::StreamRing::used () const
+{
+    return mHead < mCapacity ? mHead : mCapacity;
+}
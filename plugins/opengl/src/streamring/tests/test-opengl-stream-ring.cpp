@@ -0,0 +1,133 @@
+/*
+ * Compiz, opengl plugin, streaming vertex ring buffer
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include "stream-ring.h"
+
+namespace cgl = compiz::opengl;
+
+TEST (OpenGLStreamRing, FirstReservationAllocatesStorage)
+{
+    cgl::StreamRing ring (1024);
+    bool orphan = false;
+
+    EXPECT_EQ (0, ring.reserve (96, orphan));
+    EXPECT_TRUE (orphan);
+    EXPECT_EQ (1, ring.generation ());
+}
+
+TEST (OpenGLStreamRing, ReservationsAreAppended)
+{
+    cgl::StreamRing ring (1024);
+    bool orphan = false;
+
+    ring.reserve (96, orphan);
+    EXPECT_EQ (96, ring.reserve (64, orphan));
+    EXPECT_FALSE (orphan);
+    EXPECT_EQ (160, ring.reserve (32, orphan));
+    EXPECT_FALSE (orphan);
+    EXPECT_EQ (1, ring.generation ());
+}
+
+TEST (OpenGLStreamRing, OffsetsAreAligned)
+{
+    cgl::StreamRing ring (1024, 16);
+    bool orphan = false;
+
+    ring.reserve (20, orphan);
+    EXPECT_EQ (32, ring.reserve (4, orphan));
+    EXPECT_EQ (48, ring.reserve (4, orphan));
+}
+
+TEST (OpenGLStreamRing, WrapsAndOrphansWhenFull)
+{
+    cgl::StreamRing ring (256);
+    bool orphan = false;
+
+    ring.reserve (128, orphan);
+    ring.reserve (96, orphan);
+    EXPECT_FALSE (orphan);
+
+    EXPECT_EQ (0, ring.reserve (64, orphan));
+    EXPECT_TRUE (orphan);
+    EXPECT_EQ (2, ring.generation ());
+    EXPECT_EQ (64, ring.used ());
+}
+
+TEST (OpenGLStreamRing, ExactFitDoesNotWrap)
+{
+    cgl::StreamRing ring (256);
+    bool orphan = false;
+
+    ring.reserve (128, orphan);
+    EXPECT_EQ (128, ring.reserve (128, orphan));
+    EXPECT_FALSE (orphan);
+    EXPECT_EQ (256, ring.used ());
+}
+
+TEST (OpenGLStreamRing, GrowsForLargeReservation)
+{
+    cgl::StreamRing ring (256);
+    bool orphan = false;
+
+    ring.reserve (64, orphan);
+    EXPECT_EQ (0, ring.reserve (1000, orphan));
+    EXPECT_TRUE (orphan);
+    EXPECT_EQ (1024, ring.capacity ());
+    EXPECT_EQ (2, ring.generation ());
+
+    EXPECT_EQ (1008, ring.reserve (16, orphan));
+    EXPECT_FALSE (orphan);
+}
+
+TEST (OpenGLStreamRing, ZeroCapacityStillGrows)
+{
+    cgl::StreamRing ring (0);
+    bool orphan = false;
+
+    EXPECT_EQ (0, ring.reserve (100, orphan));
+    EXPECT_TRUE (orphan);
+    EXPECT_GE (ring.capacity (), 100);
+}
+
+TEST (OpenGLStreamRing, ResetAllocatesAgainUnderNewGeneration)
+{
+    cgl::StreamRing ring (256);
+    bool orphan = false;
+
+    ring.reserve (64, orphan);
+    ring.reserve (64, orphan);
+    unsigned int before = ring.generation ();
+
+    ring.reset ();
+    EXPECT_NE (before, ring.generation ());
+    EXPECT_EQ (0, ring.used ());
+
+    EXPECT_EQ (0, ring.reserve (32, orphan));
+    EXPECT_TRUE (orphan);
+    EXPECT_NE (before, ring.generation ());
+
+    EXPECT_EQ (32, ring.reserve (32, orphan));
+    EXPECT_FALSE (orphan);
+}
@@ -0,0 +1,111 @@
+/*
+ * Compiz, opengl plugin, GLSL uniform location and value caching
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_OPENGL_UNIFORM_CACHE_H
+#define _COMPIZ_OPENGL_UNIFORM_CACHE_H
+
+#include <map>
+#include <string>
+#include <boost/function.hpp>
+
+namespace compiz
+{
+    namespace opengl
+    {
+	typedef boost::function <int (const char *)> LocationLookupFunc;
+
+	/*
+	 * Remembers the location the driver returned for each name so that
+	 * it only has to be asked once per program. Names which are not
+	 * active in the program are remembered as -1 too.
+	 */
+	class LocationCache
+	{
+	    public:
+
+		LocationCache (const LocationLookupFunc &lookup);
+
+		int location (const char *name);
+		unsigned int size () const;
+		void clear ();
+
+	    private:
+
+		typedef std::map <std::string, int> Map;
+
+		LocationLookupFunc mLookup;
+		Map                mLocations;
+	};
+
+	/*
+	 * Shadows the last value uploaded to each uniform location of a
+	 * program. Uniforms are program state, so a value which is
+	 * already current does not need to be sent to the driver again.
+	 */
+	class UniformShadow
+	{
+	    public:
+
+		enum ValueType
+		{
+		    Float,
+		    Int
+		};
+
+		/* Large enough for a 4x4 matrix */
+		static const unsigned int MaxComponents = 16;
+
+		/*
+		 * Records the value for location and returns true if
+		 * it differs from what was last recorded there (and
+		 * so needs uploading). Data is count floats or ints,
+		 * depending on type.
+		 */
+		bool update (int          location,
+			     ValueType    type,
+			     unsigned int count,
+			     const void   *data);
+
+		void invalidate (int location);
+		void clear ();
+
+	    private:
+
+		struct Value
+		{
+		    ValueType    type;
+		    unsigned int count;
+		    union
+		    {
+			float f[MaxComponents];
+			int   i[MaxComponents];
+		    } data;
+		};
+
+		typedef std::map <int, Value> Map;
+
+		Map mValues;
+	};
+    } // namespace opengl
+} // namespace compiz
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Compiz, opengl plugin, GLSL uniform location and value caching
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <cstring>
+#include "uniform-cache.h"
+
+namespace cgl = compiz::opengl;
+
+const unsigned int cgl::UniformShadow::MaxComponents;
+
+cgl::LocationCache::LocationCache (const LocationLookupFunc &lookup) :
+    mLookup (lookup)
+{
+}
+
+int
+cgl::LocationCache::location (const char *name)
+{
+    Map::iterator it = mLocations.find (name);
+
+    if (it != mLocations.end ())
+	return it->second;
+
+    int location = mLookup (name);
+
+    mLocations.insert (std::make_pair (std::string (name), location));
+    return location;
+}
+
+unsigned int
+cgl::LocationCache::size () const
+{
+    return mLocations.size ();
+}
+
+void
+cgl::LocationCache::clear ()
+{
+    mLocations.clear ();
+}
+
+bool
+cgl::UniformShadow::update (int          location,
+			    ValueType    type,
+			    unsigned int count,
+			    const void   *data)
+{
+    if (location < 0)
+	return false;
+
+    /* Nothing we can shadow, always upload */
+    if (count == 0 || count > MaxComponents)
+    {
+	mValues.erase (location);
+	return true;
+    }
+
+    /* Both members of the union are four bytes wide */
+    size_t bytes = count * sizeof (float);
+    Map::iterator it = mValues.find (location);
+
+    if (it != mValues.end ())
+    {
+	Value &current = it->second;
+
+	if (current.type == type &&
+	    current.count == count &&
+	    memcmp (current.data.f, data, bytes) == 0)
+	    return false;
+    }
+    else
+    {
+	it = mValues.insert (std::make_pair (location, Value ())).first;
+    }
+
+    Value &value = it->second;
+
+    value.type = type;
+    value.count = count;
+    memcpy (value.data.f, data, bytes);
+
+    return true;
+}
+
+void
+cgl::UniformShadow::invalidate (int location)
+{
+    mValues.erase (location);
+}
+
+void
+cgl::UniformShadow::clear ()
+{
+    mValues.clear ();
+}
@@ -0,0 +1,199 @@
+/*
+ * Compiz, opengl plugin, GLSL uniform location and value caching
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <map>
+#include <string>
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+#include "uniform-cache.h"
+
+namespace cgl = compiz::opengl;
+
+namespace
+{
+    class FakeProgram
+    {
+	public:
+
+	    FakeProgram ()
+	    {
+		locations["projection"] = 0;
+		locations["modelview"] = 1;
+		locations["paintAttrib"] = 2;
+	    }
+
+	    int lookup (const char *name)
+	    {
+		++lookups[name];
+
+		std::map <std::string, int>::iterator it = locations.find (name);
+		return it == locations.end () ? -1 : it->second;
+	    }
+
+	    std::map <std::string, int> locations;
+	    std::map <std::string, unsigned int> lookups;
+    };
+}
+
+class OpenGLLocationCache :
+    public ::testing::Test
+{
+    public:
+
+	OpenGLLocationCache () :
+	    cache (boost::bind (&FakeProgram::lookup, &program, _1))
+	{
+	}
+
+	FakeProgram        program;
+	cgl::LocationCache cache;
+};
+
+TEST_F (OpenGLLocationCache, ReturnsDriverLocation)
+{
+    EXPECT_EQ (0, cache.location ("projection"));
+    EXPECT_EQ (1, cache.location ("modelview"));
+    EXPECT_EQ (2, cache.location ("paintAttrib"));
+}
+
+TEST_F (OpenGLLocationCache, LooksUpEachNameOnce)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+	cache.location ("projection");
+	cache.location ("modelview");
+    }
+
+    EXPECT_EQ (1, program.lookups["projection"]);
+    EXPECT_EQ (1, program.lookups["modelview"]);
+    EXPECT_EQ (2, cache.size ());
+}
+
+TEST_F (OpenGLLocationCache, RemembersInactiveNames)
+{
+    EXPECT_EQ (-1, cache.location ("singleNormal"));
+    EXPECT_EQ (-1, cache.location ("singleNormal"));
+    EXPECT_EQ (1, program.lookups["singleNormal"]);
+}
+
+TEST_F (OpenGLLocationCache, ClearForcesNewLookup)
+{
+    cache.location ("projection");
+    cache.clear ();
+    cache.location ("projection");
+
+    EXPECT_EQ (2, program.lookups["projection"]);
+}
+
+TEST (OpenGLUniformShadow, FirstUploadIsNeeded)
+{
+    cgl::UniformShadow shadow;
+    float value[3] = { 1.0f, 0.5f, 0.25f };
+
+    EXPECT_TRUE (shadow.update (2, cgl::UniformShadow::Float, 3, value));
+}
+
+TEST (OpenGLUniformShadow, SameValueIsSkipped)
+{
+    cgl::UniformShadow shadow;
+    float value[3] = { 1.0f, 0.5f, 0.25f };
+    float same[3] = { 1.0f, 0.5f, 0.25f };
+
+    shadow.update (2, cgl::UniformShadow::Float, 3, value);
+    EXPECT_FALSE (shadow.update (2, cgl::UniformShadow::Float, 3, same));
+}
+
+TEST (OpenGLUniformShadow, ChangedValueIsUploaded)
+{
+    cgl::UniformShadow shadow;
+    float value[3] = { 1.0f, 0.5f, 0.25f };
+    float changed[3] = { 1.0f, 0.5f, 0.75f };
+
+    shadow.update (2, cgl::UniformShadow::Float, 3, value);
+    EXPECT_TRUE (shadow.update (2, cgl::UniformShadow::Float, 3, changed));
+    EXPECT_FALSE (shadow.update (2, cgl::UniformShadow::Float, 3, changed));
+}
+
+TEST (OpenGLUniformShadow, LocationsAreIndependent)
+{
+    cgl::UniformShadow shadow;
+    int unit = 0;
+
+    EXPECT_TRUE (shadow.update (3, cgl::UniformShadow::Int, 1, &unit));
+    EXPECT_TRUE (shadow.update (4, cgl::UniformShadow::Int, 1, &unit));
+    EXPECT_FALSE (shadow.update (3, cgl::UniformShadow::Int, 1, &unit));
+}
+
+TEST (OpenGLUniformShadow, TypeChangeIsUploaded)
+{
+    cgl::UniformShadow shadow;
+    int   i = 0;
+    float f = 0.0f;
+
+    shadow.update (1, cgl::UniformShadow::Int, 1, &i);
+    EXPECT_TRUE (shadow.update (1, cgl::UniformShadow::Float, 1, &f));
+}
+
+TEST (OpenGLUniformShadow, ComponentCountChangeIsUploaded)
+{
+    cgl::UniformShadow shadow;
+    float value[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    shadow.update (1, cgl::UniformShadow::Float, 3, value);
+    EXPECT_TRUE (shadow.update (1, cgl::UniformShadow::Float, 4, value));
+}
+
+TEST (OpenGLUniformShadow, MatrixIsShadowed)
+{
+    cgl::UniformShadow shadow;
+    float matrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+    EXPECT_TRUE (shadow.update (0, cgl::UniformShadow::Float, 16, matrix));
+    EXPECT_FALSE (shadow.update (0, cgl::UniformShadow::Float, 16, matrix));
+
+    matrix[15] = 2;
+    EXPECT_TRUE (shadow.update (0, cgl::UniformShadow::Float, 16, matrix));
+}
+
+TEST (OpenGLUniformShadow, InactiveLocationIsNeverUploaded)
+{
+    cgl::UniformShadow shadow;
+    float f = 1.0f;
+
+    EXPECT_FALSE (shadow.update (-1, cgl::UniformShadow::Float, 1, &f));
+}
+
+TEST (OpenGLUniformShadow, InvalidateForcesUpload)
+{
+    cgl::UniformShadow shadow;
+    float f = 1.0f;
+
+    shadow.update (1, cgl::UniformShadow::Float, 1, &f);
+    shadow.invalidate (1);
+    EXPECT_TRUE (shadow.update (1, cgl::UniformShadow::Float, 1, &f));
+
+    shadow.clear ();
+    EXPECT_TRUE (shadow.update (1, cgl::UniformShadow::Float, 1, &f));
+}
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
 
 #ifdef USE_GLES
 #include <GLES2/gl2.h>
@@ -41,6 +42,14 @@
 
 GLVertexBuffer *PrivateVertexBuffer::streamingBuffer = NULL;
 
+GLuint PrivateVertexBuffer::streamBuffer = 0;
+compiz::opengl::StreamRing PrivateVertexBuffer::streamRing (1024 * 1024);
+
+bool PrivateVertexBuffer::batching = false;
+GLProgram *PrivateVertexBuffer::batchProgram = NULL;
+unsigned int PrivateVertexBuffer::drawCalls = 0;
+unsigned int PrivateVertexBuffer::programBinds = 0;
+
 bool GLVertexBuffer::enabled ()
 {
     // FIXME: GL::shaders shouldn't be a requirement here. But for now,
@@ -103,6 +112,26 @@ bool GLVertexBuffer::end ()
     if (!enabled ())
 	return true;
 
+    if (!priv->colorData.size ())
+    {
+	priv->colorData.resize (4);
+	priv->colorData[0] = priv->color[0];
+	priv->colorData[1] = priv->color[1];
+	priv->colorData[2] = priv->color[2];
+	priv->colorData[3] = priv->color[3];
+    }
+
+    // Streamed geometry is usually drawn once and thrown away, so put
+    // all of its arrays into the shared ring with a single upload
+    priv->interleaved = priv->usage == GL::STREAM_DRAW &&
+			priv->canInterleave ();
+
+    if (priv->interleaved)
+    {
+	priv->uploadInterleaved ();
+	return true;
+    }
+
     GL::bindBuffer (GL_ARRAY_BUFFER, priv->vertexBuffer);
     GL::bufferData (GL_ARRAY_BUFFER,
                     sizeof(GLfloat) * priv->vertexData.size (),
@@ -116,15 +145,6 @@ bool GLVertexBuffer::end ()
 	                &priv->normalData[0], priv->usage);
     }
 
-    if (!priv->colorData.size ())
-    {
-	priv->colorData.resize (4);
-	priv->colorData[0] = priv->color[0];
-	priv->colorData[1] = priv->color[1];
-	priv->colorData[2] = priv->color[2];
-	priv->colorData[3] = priv->color[3];
-    }
-
     if (priv->colorData.size ())
     {
 	GL::bindBuffer (GL_ARRAY_BUFFER, priv->colorBuffer);
@@ -234,6 +254,14 @@ void GLVertexBuffer::addTexCoords (GLuint texture,
 	data.push_back (texcoords[i]);
 }
 
+GLfloat *GLVertexBuffer::getTexCoords (GLuint texture) const
+{
+    if (texture >= priv->nTextures || priv->textureData[texture].empty ())
+	return NULL;
+
+    return &priv->textureData[texture][0];
+}
+
 void GLVertexBuffer::addUniform (const char *name, GLfloat value)
 {
     // we're casting to double here to make our template va_arg happy
@@ -388,8 +416,17 @@ PrivateVertexBuffer::PrivateVertexBuffer () :
     vertexOffset (0),
     maxVertices (-1),
     program (NULL),
-    autoProgram (0)
+    autoProgram (0),
+    interleaved (false),
+    interleavedGeneration (0),
+    stride (0),
+    vertexPointer (0),
+    normalPointer (0),
+    colorPointer (0)
 {
+    for (int i = 0; i < MAX_TEXTURES; i++)
+	texCoordPointer[i] = 0;
+
     if (!GL::genBuffers)
 	return;
 
@@ -414,6 +451,129 @@ PrivateVertexBuffer::~PrivateVertexBuffer ()
 	GL::deleteBuffers (4, &textureBuffers[0]);
 }
 
+bool PrivateVertexBuffer::canInterleave () const
+{
+    size_t nVertices = vertexData.size () / 3;
+
+    // Every per-vertex array must have exactly one entry per vertex
+    if (normalData.size () > 3 && normalData.size () != nVertices * 3)
+	return false;
+
+    if (colorData.size () > 4 && colorData.size () != nVertices * 4)
+	return false;
+
+    for (GLuint i = 0; i < nTextures; i++)
+	if (textureData[i].size () != nVertices * 2)
+	    return false;
+
+    return true;
+}
+
+void PrivateVertexBuffer::uploadInterleaved ()
+{
+    size_t  nVertices = vertexData.size () / 3;
+    bool    normals = normalData.size () > 3;
+    bool    colors = colorData.size () > 4;
+    GLuint  components = 3 + (normals ? 3 : 0) + (colors ? 4 : 0) +
+			 2 * nTextures;
+
+    interleavedData.resize (nVertices * components);
+
+    GLfloat *out = &interleavedData[0];
+
+    for (size_t v = 0; v < nVertices; v++)
+    {
+	out = std::copy (&vertexData[v * 3], &vertexData[v * 3] + 3, out);
+
+	if (normals)
+	    out = std::copy (&normalData[v * 3], &normalData[v * 3] + 3, out);
+
+	if (colors)
+	    out = std::copy (&colorData[v * 4], &colorData[v * 4] + 4, out);
+
+	for (GLuint i = 0; i < nTextures; i++)
+	    out = std::copy (&textureData[i][v * 2],
+			     &textureData[i][v * 2] + 2, out);
+    }
+
+    size_t bytes = sizeof (GLfloat) * interleavedData.size ();
+    bool   orphan;
+    size_t offset = streamRing.reserve (bytes, orphan);
+
+    if (!streamBuffer)
+    {
+	GL::genBuffers (1, &streamBuffer);
+	orphan = true;
+    }
+
+    GL::bindBuffer (GL_ARRAY_BUFFER, streamBuffer);
+
+    // Let the driver keep the old storage for any draws still using
+    // it rather than waiting for them
+    if (orphan)
+	GL::bufferData (GL_ARRAY_BUFFER, streamRing.capacity (), NULL,
+			GL::STREAM_DRAW);
+
+    GL::bufferSubData (GL_ARRAY_BUFFER, offset, bytes, &interleavedData[0]);
+    GL::bindBuffer (GL_ARRAY_BUFFER, 0);
+
+    interleavedGeneration = streamRing.generation ();
+    stride = components * sizeof (GLfloat);
+
+    vertexPointer = offset;
+    offset += 3 * sizeof (GLfloat);
+
+    normalPointer = offset;
+    if (normals)
+	offset += 3 * sizeof (GLfloat);
+
+    colorPointer = offset;
+    if (colors)
+	offset += 4 * sizeof (GLfloat);
+
+    for (GLuint i = 0; i < nTextures; i++)
+    {
+	texCoordPointer[i] = offset;
+	offset += 2 * sizeof (GLfloat);
+    }
+}
+
+void PrivateVertexBuffer::beginBatch ()
+{
+    batching = true;
+}
+
+void PrivateVertexBuffer::endBatch ()
+{
+    if (batchProgram)
+	batchProgram->unbind ();
+
+    batchProgram = NULL;
+    batching = false;
+}
+
+void PrivateVertexBuffer::forgetProgram (GLProgram *program)
+{
+    // Another program could be created at the same address
+    if (batchProgram == program)
+	batchProgram = NULL;
+}
+
+void PrivateVertexBuffer::releaseStreamBuffer ()
+{
+    if (streamBuffer)
+	GL::deleteBuffers (1, &streamBuffer);
+
+    streamBuffer = 0;
+    streamRing.reset ();
+}
+
+static inline const GLvoid *
+bufferOffset (size_t offset)
+{
+    return reinterpret_cast <const GLvoid *> (offset);
+}
+
 int PrivateVertexBuffer::render (const GLMatrix            *projection,
                                  const GLMatrix            *modelview,
                                  const GLWindowPaintAttrib *attrib)
@@ -451,7 +611,13 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
 	return -1;
     }
 
-    tmpProgram->bind ();
+    if (!batching || batchProgram != tmpProgram)
+    {
+	tmpProgram->bind ();
+	batchProgram = batching ? tmpProgram : NULL;
+	programBinds++;
+    }
+
     if (!tmpProgram->valid ())
     {
 	return -1;
@@ -463,11 +629,19 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
     if (modelview)
 	tmpProgram->setUniform ("modelview", *modelview);
 
+    // Another buffer wrapped the ring since we were uploaded, so our
+    // data is gone from the current storage
+    if (interleaved && interleavedGeneration != streamRing.generation ())
+	uploadInterleaved ();
+
     positionIndex = tmpProgram->attributeLocation ("position");
     (*GL::enableVertexAttribArray) (positionIndex);
-    (*GL::bindBuffer) (GL::ARRAY_BUFFER, vertexBuffer);
-    (*GL::vertexAttribPointer) (positionIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    (*GL::bindBuffer) (GL::ARRAY_BUFFER, 0);
+    (*GL::bindBuffer) (GL::ARRAY_BUFFER, interleaved ? streamBuffer : vertexBuffer);
+    if (interleaved)
+	(*GL::vertexAttribPointer) (positionIndex, 3, GL_FLOAT, GL_FALSE,
+				    stride, bufferOffset (vertexPointer));
+    else
+	(*GL::vertexAttribPointer) (positionIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
     //use default normal
     if (normalData.empty ())
@@ -484,9 +658,14 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
     {
 	normalIndex = tmpProgram->attributeLocation ("normal");
 	(*GL::enableVertexAttribArray) (normalIndex);
-	(*GL::bindBuffer) (GL::ARRAY_BUFFER, normalBuffer);
-	(*GL::vertexAttribPointer) (normalIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	(*GL::bindBuffer) (GL::ARRAY_BUFFER, 0);
+	if (interleaved)
+	    (*GL::vertexAttribPointer) (normalIndex, 3, GL_FLOAT, GL_FALSE,
+					stride, bufferOffset (normalPointer));
+	else
+	{
+	    (*GL::bindBuffer) (GL::ARRAY_BUFFER, normalBuffer);
+	    (*GL::vertexAttribPointer) (normalIndex, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	}
     }
 
     // special case a single color and apply it to the entire operation
@@ -499,9 +678,14 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
     {
 	colorIndex = tmpProgram->attributeLocation ("color");
 	(*GL::enableVertexAttribArray) (colorIndex);
-	(*GL::bindBuffer) (GL::ARRAY_BUFFER, colorBuffer);
-	(*GL::vertexAttribPointer) (colorIndex, 4, GL_FLOAT, GL_FALSE, 0, 0);
-	(*GL::bindBuffer) (GL::ARRAY_BUFFER, 0);
+	if (interleaved)
+	    (*GL::vertexAttribPointer) (colorIndex, 4, GL_FLOAT, GL_FALSE,
+					stride, bufferOffset (colorPointer));
+	else
+	{
+	    (*GL::bindBuffer) (GL::ARRAY_BUFFER, colorBuffer);
+	    (*GL::vertexAttribPointer) (colorIndex, 4, GL_FLOAT, GL_FALSE, 0, 0);
+	}
     }
 
     for (int i = nTextures - 1; i >= 0; i--)
@@ -512,14 +696,21 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
 	texCoordIndex[i] = tmpProgram->attributeLocation (name);
 
 	(*GL::enableVertexAttribArray) (texCoordIndex[i]);
-	(*GL::bindBuffer) (GL::ARRAY_BUFFER, textureBuffers[i]);
-	(*GL::vertexAttribPointer) (texCoordIndex[i], 2, GL_FLOAT, GL_FALSE, 0, 0);
-	(*GL::bindBuffer) (GL::ARRAY_BUFFER, 0);
+	if (interleaved)
+	    (*GL::vertexAttribPointer) (texCoordIndex[i], 2, GL_FLOAT, GL_FALSE,
+					stride, bufferOffset (texCoordPointer[i]));
+	else
+	{
+	    (*GL::bindBuffer) (GL::ARRAY_BUFFER, textureBuffers[i]);
+	    (*GL::vertexAttribPointer) (texCoordIndex[i], 2, GL_FLOAT, GL_FALSE, 0, 0);
+	}
 
 	snprintf (name, 9, "texture%d", i);
 	tmpProgram->setUniform (name, i);
     }
 
+    (*GL::bindBuffer) (GL::ARRAY_BUFFER, 0);
+
     // set per-plugin uniforms
     for (unsigned int i = 0; i < uniforms.size (); i++)
     {
@@ -536,6 +727,7 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
     }
 
 
+    drawCalls++;
     glDrawArrays (primitiveType, vertexOffset, maxVertices > 0 ?
 				    std::min (static_cast <int> (vertexData.size () / 3),
 					      maxVertices) :
@@ -554,7 +746,8 @@ int PrivateVertexBuffer::render (const GLMatrix            *projection,
 
     (*GL::disableVertexAttribArray) (positionIndex);
 
-    tmpProgram->unbind ();
+    if (!batching)
+	tmpProgram->unbind ();
 
     return 0;
 }
@@ -609,6 +802,7 @@ int PrivateVertexBuffer::legacyRender (const GLMatrix            &projection,
 	glTexCoordPointer (2, GL_FLOAT, 0, &textureData[i][0]);
     }
 
+    drawCalls++;
     glDrawArrays (primitiveType, vertexOffset, vertexData.size () / 3);
 
     glDisableClientState (GL_VERTEX_ARRAY);
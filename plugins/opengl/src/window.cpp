@@ -43,6 +43,9 @@ GLWindow::GLWindow (CompWindow *w) :
 
     priv->lastPaint = priv->paint;
 
+    /* The cached occlusion pass only knows windows by address,
+     * and this one may have taken the place of an old one */
+    GLScreen::get (screen)->priv->occlusionValid = false;
 }
 
 GLWindow::~GLWindow ()
@@ -353,6 +356,33 @@ GLWindow::addShaders (std::string name,
     priv->shaders.push_back(data);
 }
 
+void
+GLWindow::setDrawBatchable (GLWindowInterface *iface, bool batchable)
+{
+    std::vector<GLWindowInterface *> &ifaces = priv->batchableInterfaces;
+    std::vector<GLWindowInterface *>::iterator it =
+	std::find (ifaces.begin (), ifaces.end (), iface);
+
+    if (batchable && it == ifaces.end ())
+	ifaces.push_back (iface);
+    else if (!batchable && it != ifaces.end ())
+	ifaces.erase (it);
+}
+
+bool
+PrivateGLWindow::drawBatchable () const
+{
+    return
+	!gWindow->functionWrappedBesides (GLWindow::glPaintIndex,
+					  batchableInterfaces) &&
+	!gWindow->functionWrappedBesides (GLWindow::glDrawIndex,
+					  batchableInterfaces) &&
+	!gWindow->functionWrappedBesides (GLWindow::glAddGeometryIndex,
+					  batchableInterfaces) &&
+	!gWindow->functionWrappedBesides (GLWindow::glDrawTextureIndex,
+					  batchableInterfaces);
+}
+
 void
 PrivateGLWindow::updateFrameRegion (CompRegion &region)
 {
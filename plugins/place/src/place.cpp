@@ -251,9 +251,9 @@ compareLeftmost (compiz::place::Placeable *a,
     int ax, bx;
 
     ax = a->geometry ().x () - a->extents ().left;
-    bx = b->geometry ().x () - a->extents ().left;
+    bx = b->geometry ().x () - b->extents ().left;
 
-    return (ax <= bx);
+    return (ax < bx);
 }
 
 static bool
@@ -263,9 +263,9 @@ compareTopmost (compiz::place::Placeable *a,
     int ay, by;
 
     ay = a->geometry ().y () - a->extents ().top;
-    by = b->geometry ().y () - a->extents ().top;
+    by = b->geometry ().y () - b->extents ().top;
 
-    return (ay <= by);
+    return (ay < by);
 }
 
 static bool
@@ -835,18 +835,17 @@ PlaceWindow::cascadeFindFirstFit (const Placeable::Vector &placeables,
      * of each existing window, aligned with the left/top of the
      * existing window in each of those cases.
      */
-    bool           retval = false;
     Placeable::Vector belowSorted, rightSorted;
 
-    /* Below each window */
+    /* Below each window, topmost first, then leftmost */
     belowSorted = placeables;
-    std::sort (belowSorted.begin (), belowSorted.end (), compareLeftmost);
-    std::sort (belowSorted.begin (), belowSorted.end (), compareTopmost);
+    std::stable_sort (belowSorted.begin (), belowSorted.end (), compareLeftmost);
+    std::stable_sort (belowSorted.begin (), belowSorted.end (), compareTopmost);
 
-    /* To the right of each window */
+    /* To the right of each window, leftmost first, then topmost */
     rightSorted = placeables;
-    std::sort (belowSorted.begin (), belowSorted.end (), compareTopmost);
-    std::sort (belowSorted.begin (), belowSorted.end (), compareLeftmost);
+    std::stable_sort (rightSorted.begin (), rightSorted.end (), compareTopmost);
+    std::stable_sort (rightSorted.begin (), rightSorted.end (), compareLeftmost);
 
     CompRect rect = this->geometry ();
 
@@ -861,70 +860,44 @@ PlaceWindow::cascadeFindFirstFit (const Placeable::Vector &placeables,
     {
 	pos.setX (rect.x () + this->extents ().left);
 	pos.setY (rect.y () + this->extents ().top);
-	retval = true;
+	return true;
     }
 
-    if (!retval)
+    /* try below each window */
+    foreach (Placeable *p, belowSorted)
     {
-	/* try below each window */
-	foreach (Placeable *p, belowSorted)
-	{
-	    CompRect outerRect;
-
-	    if (retval)
-		break;
+	CompRect outerRect (rect);
 
-	    outerRect = p->geometry ();
+	outerRect.setX (p->geometry ().x () - p->extents ().left);
+	outerRect.setY (p->geometry ().y2 () + p->extents ().bottom);
 
-	    outerRect.setLeft (rect.left () - this->extents ().left);
-	    outerRect.setRight (rect.right () + this->extents ().right);
-	    outerRect.setTop (rect.top () - this->extents ().top);
-	    outerRect.setBottom (rect.bottom () - this->extents ().bottom);
-
-	    outerRect.setX (outerRect.x ());
-	    outerRect.setY (outerRect.bottom ());
-
-	    if (workArea.contains (rect) &&
-		!rectOverlapsWindow (rect, belowSorted))
-	    {
-		pos.setX (rect.x () + this->extents ().left);
-		pos.setY (rect.y () + this->extents ().top);
-		retval = true;
-	    }
+	if (workArea.contains (outerRect) &&
+	    !rectOverlapsWindow (outerRect, placeables))
+	{
+	    pos.setX (outerRect.x () + this->extents ().left);
+	    pos.setY (outerRect.y () + this->extents ().top);
+	    return true;
 	}
     }
 
-    if (!retval)
+    /* try to the right of each window */
+    foreach (Placeable *p, rightSorted)
     {
-	/* try to the right of each window */
-	foreach (Placeable *p, rightSorted)
-	{
-	    CompRect outerRect;
-
-	    if (retval)
-		break;
-
-	    outerRect = p->geometry ();
-
-	    outerRect.setLeft (rect.left () - this->extents ().left);
-	    outerRect.setRight (rect.right () + this->extents ().right);
-	    outerRect.setTop (rect.top () - this->extents ().top);
-	    outerRect.setBottom (rect.bottom () - this->extents ().bottom);
+	CompRect outerRect (rect);
 
-	    outerRect.setX (outerRect.right ());
-	    outerRect.setY (outerRect.y ());
+	outerRect.setX (p->geometry ().x2 () + p->extents ().right);
+	outerRect.setY (p->geometry ().y () - p->extents ().top);
 
-	    if (workArea.contains (rect) &&
-		!rectOverlapsWindow (rect, rightSorted))
-	    {
-		pos.setX (rect.x () + this->extents ().left);
-		pos.setY (rect.y () + this->extents ().top);
-		retval = true;
-	    }
+	if (workArea.contains (outerRect) &&
+	    !rectOverlapsWindow (outerRect, placeables))
+	{
+	    pos.setX (outerRect.x () + this->extents ().left);
+	    pos.setY (outerRect.y () + this->extents ().top);
+	    return true;
 	}
     }
 
-    return retval;
+    return false;
 }
 
 void
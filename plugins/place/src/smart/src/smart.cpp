@@ -1,4 +1,6 @@
 #include "smart.h"
+#include <algorithm>
+#include <climits>
 #include <boost/foreach.hpp>
 
 #ifndef foreach
@@ -10,6 +12,318 @@ static const unsigned short NONE = 0;
 static const short H_WRONG = -1;
 static const short W_WRONG = -2;
 
+namespace
+{
+    /* The frame of a placeable, with its extents and border applied */
+    struct Frame
+    {
+	int xl, yt, xr, yb;
+	int weight; /* how much overlapping this frame counts */
+    };
+
+    /*
+     * Uniform grid over the frames of the placeables, so that the
+     * candidate search only looks at the frames near each candidate
+     * position instead of at every window on the workspace.
+     */
+    class FrameIndex
+    {
+	public:
+
+	    FrameIndex (const compiz::place::Placeable::Vector &placeables);
+
+	    /*
+	     * Weighted area of the frames overlapping the rectangle. Stops
+	     * adding up once it is over limit, since the caller only needs
+	     * to know that the position is worse than the best one so far.
+	     */
+	    int overlap (int xl, int yt, int xr, int yb, int limit);
+
+	    /*
+	     * Leftmost x past xTmp where a window of width cw might fit
+	     * between the frames in the band yTmp to yTmp + ch
+	     */
+	    int nextX (int xTmp, int yTmp, int cw, int ch, int possible);
+
+	    /* Topmost y past yTmp where a window of height ch might fit */
+	    int nextY (int yTmp, int ch, int possible) const;
+
+	private:
+
+	    /*
+	     * Calls visit for each frame in cells touched by the rect,
+	     * until visit.done ()
+	     */
+	    template <typename Visitor>
+	    void query (int xl, int yt, int xr, int yb, Visitor &visit);
+
+	    std::vector <Frame>        mFrames;
+	    std::vector <int>          mBottoms;
+	    std::vector <int>          mTops;
+
+	    int                        mX, mY;
+	    int                        mCellWidth, mCellHeight;
+	    int                        mColumns, mRows;
+	    std::vector < std::vector <unsigned int> > mCells;
+
+	    std::vector <unsigned int> mStamps;
+	    unsigned int               mStamp;
+    };
+
+    class OverlapVisitor
+    {
+	public:
+
+	    OverlapVisitor (int xl, int yt, int xr, int yb, int limit) :
+		overlap (0), cxl (xl), cyt (yt), cxr (xr), cyb (yb), limit (limit) {}
+
+	    bool done () const { return overlap > limit; }
+
+	    void operator () (const Frame &f)
+	    {
+		/* if windows overlap, calc the overall overlapping */
+		if (cxl < f.xr && cxr > f.xl && cyt < f.yb && cyb > f.yt)
+		    overlap += f.weight *
+			       (MIN (cxr, f.xr) - MAX (cxl, f.xl)) *
+			       (MIN (cyb, f.yb) - MAX (cyt, f.yt));
+	    }
+
+	    int overlap;
+
+	private:
+
+	    int cxl, cyt, cxr, cyb;
+	    int limit;
+    };
+
+    class NextXVisitor
+    {
+	public:
+
+	    NextXVisitor (int xTmp, int yTmp, int cw, int ch, int possible) :
+		possible (possible), xTmp (xTmp), yTmp (yTmp), cw (cw), ch (ch) {}
+
+	    void operator () (const Frame &f)
+	    {
+		/* if not enough room above or under the current
+		 * client determine the first non-overlapped x position
+		 */
+		if (yTmp < f.yb && f.yt < ch + yTmp)
+		{
+		    if (f.xr > xTmp && possible > f.xr)
+			possible = f.xr;
+
+		    int basket = f.xl - cw;
+		    if (basket > xTmp && possible > basket)
+			possible = basket;
+		}
+	    }
+
+	    int possible;
+
+	private:
+
+	    int xTmp, yTmp, cw, ch;
+    };
+
+    FrameIndex::FrameIndex (const compiz::place::Placeable::Vector &placeables) :
+	mX (0),
+	mY (0),
+	mCellWidth (1),
+	mCellHeight (1),
+	mColumns (0),
+	mRows (0),
+	mStamp (0)
+    {
+	mFrames.reserve (placeables.size ());
+
+	foreach (compiz::place::Placeable *p, placeables)
+	{
+	    const compiz::window::Geometry &otherGeometry = p->geometry ();
+	    const compiz::window::extents::Extents &otherExtents = p->extents ();
+	    Frame f;
+
+	    f.xl = otherGeometry.x () - otherExtents.left;
+	    f.yt = otherGeometry.y () - otherExtents.top;
+	    f.xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
+	    f.yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+
+	    if (p->state () & compiz::place::WindowAbove)
+		f.weight = 16;
+	    else if (p->state () & compiz::place::WindowBelow)
+		f.weight = 0;
+	    else
+		f.weight = 1;
+
+	    mFrames.push_back (f);
+	    mBottoms.push_back (f.yb);
+	    mTops.push_back (f.yt);
+	}
+
+	std::sort (mBottoms.begin (), mBottoms.end ());
+	std::sort (mTops.begin (), mTops.end ());
+
+	if (mFrames.empty ())
+	    return;
+
+	int x2 = mFrames[0].xr, y2 = mFrames[0].yb;
+
+	mX = mFrames[0].xl;
+	mY = mFrames[0].yt;
+
+	foreach (const Frame &f, mFrames)
+	{
+	    mX = MIN (mX, f.xl);
+	    mY = MIN (mY, f.yt);
+	    x2 = MAX (x2, f.xr);
+	    y2 = MAX (y2, f.yb);
+	}
+
+	/*
+	 * Cells the size of an average frame, so that most frames are
+	 * in at most four cells. Smaller cells mostly add to the cost
+	 * of skipping frames that were already visited.
+	 */
+	double width = 0.0, height = 0.0;
+
+	foreach (const Frame &f, mFrames)
+	{
+	    width += f.xr - f.xl;
+	    height += f.yb - f.yt;
+	}
+
+	mCellWidth = MAX (1, (int) (width / mFrames.size ()));
+	mCellHeight = MAX (1, (int) (height / mFrames.size ()));
+	mColumns = (x2 - mX) / mCellWidth + 1;
+	mRows = (y2 - mY) / mCellHeight + 1;
+
+	mCells.resize (mColumns * mRows);
+	mStamps.resize (mFrames.size (), 0);
+
+	for (unsigned int i = 0; i < mFrames.size (); i++)
+	{
+	    const Frame &f = mFrames[i];
+
+	    for (int r = (f.yt - mY) / mCellHeight; r <= (f.yb - mY) / mCellHeight; r++)
+		for (int c = (f.xl - mX) / mCellWidth; c <= (f.xr - mX) / mCellWidth; c++)
+		    mCells[r * mColumns + c].push_back (i);
+	}
+    }
+
+    template <typename Visitor>
+    void
+    FrameIndex::query (int xl, int yt, int xr, int yb, Visitor &visit)
+    {
+	if (mCells.empty ())
+	    return;
+
+	int c1 = MAX (0, (xl - mX) / mCellWidth);
+	int r1 = MAX (0, (yt - mY) / mCellHeight);
+	int c2 = MIN (mColumns - 1, (xr - mX) / mCellWidth);
+	int r2 = MIN (mRows - 1, (yb - mY) / mCellHeight);
+
+	if (xr < mX || yb < mY)
+	    return;
+
+	/* A frame in several cells must only be visited once */
+	if (++mStamp == 0)
+	{
+	    std::fill (mStamps.begin (), mStamps.end (), 0);
+	    mStamp = 1;
+	}
+
+	for (int r = r1; r <= r2; r++)
+	{
+	    for (int c = c1; c <= c2; c++)
+	    {
+		foreach (unsigned int i, mCells[r * mColumns + c])
+		{
+		    if (mStamps[i] == mStamp)
+			continue;
+
+		    mStamps[i] = mStamp;
+		    visit (mFrames[i]);
+
+		    if (visit.done ())
+			return;
+		}
+	    }
+	}
+    }
+
+    int
+    FrameIndex::overlap (int xl, int yt, int xr, int yb, int limit)
+    {
+	OverlapVisitor visit (xl, yt, xr, yb, limit);
+
+	query (xl, yt, xr, yb, visit);
+	return visit.overlap;
+    }
+
+    int
+    FrameIndex::nextX (int xTmp, int yTmp, int cw, int ch, int possible)
+    {
+	NextXVisitor visit (xTmp, yTmp, cw, ch, possible);
+
+	if (mCells.empty () || yTmp + ch < mY || xTmp + cw < mX)
+	    return possible;
+
+	int c1 = MAX (0, (xTmp - mX) / mCellWidth);
+	int r1 = MAX (0, (yTmp - mY) / mCellHeight);
+	int r2 = MIN (mRows - 1, (yTmp + ch - mY) / mCellHeight);
+
+	if (++mStamp == 0)
+	{
+	    std::fill (mStamps.begin (), mStamps.end (), 0);
+	    mStamp = 1;
+	}
+
+	/*
+	 * Walk the band from left to right. Only frames that start
+	 * before possible + cw can still lower possible, so stop at
+	 * the first column past that.
+	 */
+	for (int c = c1; c < mColumns; c++)
+	{
+	    if (mX + c * mCellWidth > visit.possible + cw)
+		break;
+
+	    for (int r = r1; r <= r2; r++)
+	    {
+		foreach (unsigned int i, mCells[r * mColumns + c])
+		{
+		    if (mStamps[i] == mStamp)
+			continue;
+
+		    mStamps[i] = mStamp;
+		    visit (mFrames[i]);
+		}
+	    }
+	}
+
+	return visit.possible;
+    }
+
+    int
+    FrameIndex::nextY (int yTmp, int ch, int possible) const
+    {
+	/* the first frame bottom below yTmp */
+	std::vector <int>::const_iterator it =
+	    std::upper_bound (mBottoms.begin (), mBottoms.end (), yTmp);
+
+	if (it != mBottoms.end () && possible > *it)
+	    possible = *it;
+
+	/* the first frame top far enough below yTmp to fit above it */
+	it = std::upper_bound (mTops.begin (), mTops.end (), yTmp + ch);
+
+	if (it != mTops.end () && possible > *it - ch)
+	    possible = *it - ch;
+
+	return possible;
+    }
+}
+
 namespace compiz
 {
     namespace place
@@ -40,8 +354,6 @@ namespace compiz
 	     */
 	    int overlap = 0, minOverlap = 0;
 
-	    /* temp holder */
-	    int basket = 0;
 	    /* CT lame flag. Don't like it. What else would do? */
 	    bool firstPass = true;
 
@@ -56,6 +368,8 @@ namespace compiz
 	    int xOptimal = xTmp;
 	    int yOptimal = yTmp;
 
+	    FrameIndex frames (placeables);
+
 	    /* loop over possible positions */
 	    do
 	    {
@@ -66,39 +380,8 @@ namespace compiz
 		    overlap = W_WRONG;
 		else
 		{
-		    overlap = NONE; /* initialize */
-
-		    int cxl = xTmp;
-		    int cxr = xTmp + cw;
-		    int cyt = yTmp;
-		    int cyb = yTmp + ch;
-
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int xl = otherGeometry.x () - otherExtents.left;
-			int yt = otherGeometry.y () - otherExtents.top;
-			int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if windows overlap, calc the overall overlapping */
-			if (cxl < xr && cxr > xl && cyt < yb && cyb > yt)
-			{
-			    xl = MAX (cxl, xl);
-			    xr = MIN (cxr, xr);
-			    yt = MAX (cyt, yt);
-			    yb = MIN (cyb, yb);
-
-			    if (p->state () & compiz::place::WindowAbove)
-				overlap += 16 * (xr - xl) * (yb - yt);
-			    else if (p->state () & compiz::place::WindowBelow)
-				overlap += 0;
-			    else
-				overlap += (xr - xl) * (yb - yt);
-			}
-		    }
+		    overlap = frames.overlap (xTmp, yTmp, xTmp + cw, yTmp + ch,
+					      firstPass ? INT_MAX : minOverlap);
 		}
 
 		/* CT first time we get no overlap we stop */
@@ -131,29 +414,7 @@ namespace compiz
 			possible -= cw;
 
 		    /* compare to the position of each client on the same desk */
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int xl = otherGeometry.x () - otherExtents.left;
-			int yt = otherGeometry.y () - otherExtents.top;
-			int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if not enough room above or under the current
-			 * client determine the first non-overlapped x position
-			 */
-			if (yTmp < yb && yt < ch + yTmp)
-			{
-			    if (xr > xTmp && possible > xr)
-				possible = xr;
-
-			    basket = xl - cw;
-			    if (basket > xTmp && possible > basket)
-				possible = basket;
-			}
-		    }
+		    possible = frames.nextX (xTmp, yTmp, cw, ch, possible);
 		    xTmp = possible;
 		}
 		/* else ==> not enough x dimension (overlap was wrong on horizontal) */
@@ -166,24 +427,7 @@ namespace compiz
 			possible -= ch;
 
 		    /* test the position of each window on the desk */
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int yt = otherGeometry.y () - otherExtents.top;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if not enough room to the left or right of the current
-			 * client determine the first non-overlapped y position
-			 */
-			if (yb > yTmp && possible > yb)
-			    possible = yb;
-
-			basket = yt - ch;
-			if (basket > yTmp && possible > basket)
-			    possible = basket;
-		    }
+		    possible = frames.nextY (yTmp, ch, possible);
 		    yTmp = possible;
 		}
 	    }
@@ -0,0 +1,120 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Prints how long smart placement takes to place a new window on
+ * workspaces crowded with randomly placed windows.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+#include "smart.h"
+
+class PlaceableObject :
+    public compiz::place::Placeable
+{
+    public:
+
+	PlaceableObject (const compiz::window::Geometry &geometry,
+			 const CompRect                 &workArea) :
+	    mGeometry (geometry),
+	    mWorkarea (workArea)
+	{
+	    mExtents.left = 2;
+	    mExtents.right = 2;
+	    mExtents.top = 24;
+	    mExtents.bottom = 2;
+	}
+
+	const compiz::window::Geometry & getGeometry () const { return mGeometry; }
+	const CompRect                 & getWorkarea () const { return mWorkarea; }
+	const compiz::window::extents::Extents & getExtents () const { return mExtents; }
+	unsigned int getState () const { return 0; }
+
+    private:
+
+	compiz::window::Geometry mGeometry;
+	CompRect                 mWorkarea;
+	compiz::window::extents::Extents mExtents;
+};
+
+static double
+now ()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+int
+main (int argc, char **argv)
+{
+    const int      counts[] = { 25, 50, 100, 200, 400 };
+    const int      rounds = 20;
+    const CompRect workArea (0, 24, 1920, 1056);
+
+    srand (1);
+
+    for (unsigned int c = 0; c < sizeof (counts) / sizeof (counts[0]); c++)
+    {
+	double total = 0.0, worst = 0.0;
+
+	for (int r = 0; r < rounds; r++)
+	{
+	    std::vector <PlaceableObject *>  windows;
+	    compiz::place::Placeable::Vector placeables;
+
+	    for (int i = 0; i < counts[c]; i++)
+	    {
+		compiz::window::Geometry g (rand () % 1700, 24 + rand () % 900,
+					    100 + rand () % 700,
+					    100 + rand () % 500, 0);
+
+		windows.push_back (new PlaceableObject (g, workArea));
+		placeables.push_back (windows.back ());
+	    }
+
+	    compiz::window::Geometry g (0, 0, 640, 480, 0);
+	    PlaceableObject          placeable (g, workArea);
+	    CompPoint                pos;
+
+	    double start = now ();
+	    compiz::place::smart (&placeable, pos, placeables);
+	    double elapsed = now () - start;
+
+	    total += elapsed;
+	    if (elapsed > worst)
+		worst = elapsed;
+
+	    for (unsigned int i = 0; i < windows.size (); i++)
+		delete windows[i];
+	}
+
+	printf ("%3d windows: %7.3f ms average, %7.3f ms worst\n",
+		counts[c], total / rounds, worst);
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include "smart.h"
+
+#include <boost/foreach.hpp>
+
+#ifndef foreach
+#define foreach BOOST_FOREACH
+#endif
+
+class PlaceableObject :
+    public compiz::place::Placeable
+{
+    public:
+
+	PlaceableObject (const compiz::window::Geometry &geometry,
+			 const CompRect                 &workArea,
+			 unsigned int                   state = 0);
+
+	const compiz::window::Geometry & getGeometry () const { return mGeometry; }
+	const CompRect                 & getWorkarea () const { return mWorkarea; }
+	const compiz::window::extents::Extents & getExtents () const { return mExtents; }
+	unsigned int getState () const { return mState; }
+
+    private:
+
+	compiz::window::Geometry mGeometry;
+	CompRect                 mWorkarea;
+	compiz::window::extents::Extents mExtents;
+	unsigned int             mState;
+};
+
+PlaceableObject::PlaceableObject (const compiz::window::Geometry &geometry,
+				  const CompRect                 &workArea,
+				  unsigned int                   state) :
+    compiz::place::Placeable::Placeable (),
+    mGeometry (geometry),
+    mWorkarea (workArea),
+    mState (state)
+{
+    mExtents.left = 0;
+    mExtents.right = 0;
+    mExtents.top = 0;
+    mExtents.bottom = 0;
+}
+
+class CompPlaceSmartCrowdedTest :
+    public ::testing::Test
+{
+    public:
+
+	CompPlaceSmartCrowdedTest () :
+	    workArea (0, 0, 1000, 1000)
+	{
+	}
+
+	~CompPlaceSmartCrowdedTest ()
+	{
+	    foreach (compiz::place::Placeable *p, placeables)
+		delete p;
+	}
+
+	void addWindow (int x, int y, int width, int height,
+			unsigned int state = 0)
+	{
+	    compiz::window::Geometry g (x, y, width, height, 0);
+
+	    placeables.push_back (new PlaceableObject (g, workArea, state));
+	}
+
+	CompPoint place (int width, int height)
+	{
+	    compiz::window::Geometry g (0, 0, width, height, 0);
+	    PlaceableObject          p (g, workArea);
+	    CompPoint                pos;
+
+	    compiz::place::smart (&p, pos, placeables);
+	    return pos;
+	}
+
+	CompRect                         workArea;
+	compiz::place::Placeable::Vector placeables;
+};
+
+TEST_F (CompPlaceSmartCrowdedTest, TestGapBetweenTiledWindows)
+{
+    /* A 10x10 grid of 100x100 windows with one missing */
+    for (int y = 0; y < 10; y++)
+	for (int x = 0; x < 10; x++)
+	    if (x != 6 || y != 7)
+		addWindow (x * 100, y * 100, 100, 100);
+
+    EXPECT_EQ (CompPoint (600, 700), place (100, 100));
+}
+
+TEST_F (CompPlaceSmartCrowdedTest, TestFullWorkspaceLeastOverlap)
+{
+    /* Everything is covered, but the bottom right less so */
+    addWindow (0, 0, 1000, 1000);
+    addWindow (0, 0, 700, 1000);
+    addWindow (0, 0, 1000, 700);
+
+    EXPECT_EQ (CompPoint (700, 700), place (300, 300));
+}
+
+TEST_F (CompPlaceSmartCrowdedTest, TestAvoidsAboveWindows)
+{
+    /* Overlapping the always on top window costs more */
+    addWindow (0, 0, 500, 1000, compiz::place::WindowAbove);
+    addWindow (500, 0, 500, 1000);
+    addWindow (0, 0, 400, 1000);
+
+    EXPECT_EQ (CompPoint (500, 0), place (400, 400));
+}
+
+TEST_F (CompPlaceSmartCrowdedTest, TestIgnoresBelowWindows)
+{
+    addWindow (0, 0, 1000, 1000, compiz::place::WindowBelow);
+    addWindow (0, 0, 200, 200);
+
+    EXPECT_EQ (CompPoint (200, 0), place (300, 300));
+}
+
+TEST_F (CompPlaceSmartCrowdedTest, TestManyWindowsInARow)
+{
+    /* A column of gaps that only fits the new window at the bottom */
+    for (int y = 0; y < 900; y += 10)
+	addWindow (0, y, 1000, 10);
+
+    EXPECT_EQ (CompPoint (0, 900), place (1000, 100));
+}
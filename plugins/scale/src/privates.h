@@ -28,6 +28,7 @@
 
 #include <scale/scale.h>
 #include "scale_options.h"
+#include "slot-solver.h"
 
 class SlotArea {
     public:
@@ -132,6 +133,8 @@ class PrivateScaleScreen :
 	std::vector<ScaleSlot> slots;
 	int                  nSlots;
 
+	compiz::scale::SlotSolver slotSolver;
+
 	ScaleScreen::WindowList windows;
 
 	GLushort opacity;
@@ -526,9 +526,12 @@ PrivateScaleScreen::layoutSlots ()
 void
 PrivateScaleScreen::findBestSlots ()
 {
-    CompWindow *w;
-    int        i, d, d0 = 0;
-    float      sx, sy, cx, cy;
+    CompWindow                 *w;
+    std::vector<ScaleWindow *> unplaced;
+    std::vector<int>           freeSlots;
+    float                      cx, cy;
+
+    slotSolver.clear ();
 
     foreach (ScaleWindow *sw, windows)
     {
@@ -540,29 +543,31 @@ PrivateScaleScreen::findBestSlots ()
 	sw->priv->sid      = 0;
 	sw->priv->distance = MAXSHORT;
 
-	for (i = 0; i < nSlots; i++)
-	{
-	    if (!slots[i].filled)
-	    {
-		sx = (slots[i].x2 () + slots[i].x1 ()) / 2;
-		sy = (slots[i].y2 () + slots[i].y1 ()) / 2;
-
-		cx = (w->serverX () - (w->defaultViewport ().x () - screen->vp ().x ()) * screen->width ()) + w->width () / 2;
-		cy = (w->serverY () - (w->defaultViewport ().y () - screen->vp ().y ()) * screen->height ()) + w->height () / 2;
+	cx = (w->serverX () - (w->defaultViewport ().x () - screen->vp ().x ()) * screen->width ()) + w->width () / 2;
+	cy = (w->serverY () - (w->defaultViewport ().y () - screen->vp ().y ()) * screen->height ()) + w->height () / 2;
 
-		cx -= sx;
-		cy -= sy;
+	slotSolver.addWindow (cx, cy);
+	unplaced.push_back (sw);
+    }
 
-		d = sqrt (cx * cx + cy * cy);
-		if (d0 + d < sw->priv->distance)
-		{
-		    sw->priv->sid      = i;
-		    sw->priv->distance = d0 + d;
-		}
-	    }
+    for (int i = 0; i < nSlots; i++)
+    {
+	if (!slots[i].filled)
+	{
+	    slotSolver.addSlot ((slots[i].x2 () + slots[i].x1 ()) / 2,
+				(slots[i].y2 () + slots[i].y1 ()) / 2);
+	    freeSlots.push_back (i);
 	}
+    }
+
+    /* windows that don't fit keep sid 0 and are retried by the caller */
+    if (!slotSolver.solve ())
+	return;
 
-	d0 += sw->priv->distance;
+    for (unsigned int i = 0; i < unplaced.size (); i++)
+    {
+	unplaced[i]->priv->sid      = freeSlots[slotSolver.slot (i)];
+	unplaced[i]->priv->distance = slotSolver.distance (i);
     }
 }
 
@@ -0,0 +1,104 @@
+/*
+ * Compiz, scale plugin, slot assignment solver
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_SCALE_SLOT_SOLVER_H
+#define _COMPIZ_SCALE_SLOT_SOLVER_H
+
+#include <vector>
+
+namespace compiz
+{
+    namespace scale
+    {
+	/*
+	 * Assigns windows to slots so that the sum of the distances
+	 * between the centers of the windows and the centers of their
+	 * slots is as small as possible. This uses the shortest
+	 * augmenting path form of the Hungarian method, which takes
+	 * O(windows * windows * slots) time in the worst case.
+	 *
+	 * The solver keeps its buffers between solves, so relayouts
+	 * of a similar number of windows do not allocate.
+	 */
+	class SlotSolver
+	{
+	    public:
+
+		static const int NoSlot = -1;
+
+		SlotSolver ();
+
+		/* Forgets all windows and slots */
+		void clear ();
+
+		/* Adds a window or slot center, indices count up from 0 */
+		void addWindow (float x, float y);
+		void addSlot (float x, float y);
+
+		unsigned int windowCount () const;
+		unsigned int slotCount () const;
+
+		/*
+		 * Finds the best assignment. Returns false and assigns
+		 * nothing if there are more windows than slots.
+		 */
+		bool solve ();
+
+		/* Slot of a window after solve (), or NoSlot */
+		int slot (unsigned int window) const;
+
+		/* Distance between a window and its slot after solve () */
+		float distance (unsigned int window) const;
+
+	    private:
+
+		struct Center
+		{
+		    Center (float x, float y) : x (x), y (y) {}
+
+		    float x;
+		    float y;
+		};
+
+		std::vector<Center> mWindows;
+		std::vector<Center> mSlots;
+
+		/* Row-major windows x slots matrix of distances */
+		std::vector<float>  mCost;
+
+		std::vector<double> mWindowPotential;
+		std::vector<double> mSlotPotential;
+		std::vector<double> mMinSlack;
+		std::vector<int>    mSlotOwner;
+		std::vector<int>    mPath;
+		std::vector<int>    mRemaining;
+		std::vector<int>    mPending;
+		std::vector<char>   mVisitedWindows;
+		std::vector<char>   mVisitedSlots;
+
+		std::vector<int>    mAssignment;
+	};
+    }
+}
+
+#endif
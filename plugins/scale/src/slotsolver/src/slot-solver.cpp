@@ -0,0 +1,249 @@
+/*
+ * Compiz, scale plugin, slot assignment solver
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "slot-solver.h"
+
+namespace cs = compiz::scale;
+
+const int cs::SlotSolver::NoSlot;
+
+cs::SlotSolver::SlotSolver ()
+{
+}
+
+void
+cs::SlotSolver::clear ()
+{
+    mWindows.clear ();
+    mSlots.clear ();
+    mAssignment.clear ();
+}
+
+void
+cs::SlotSolver::addWindow (float x, float y)
+{
+    mWindows.push_back (Center (x, y));
+}
+
+void
+cs::SlotSolver::addSlot (float x, float y)
+{
+    mSlots.push_back (Center (x, y));
+}
+
+unsigned int
+cs::SlotSolver::windowCount () const
+{
+    return mWindows.size ();
+}
+
+unsigned int
+cs::SlotSolver::slotCount () const
+{
+    return mSlots.size ();
+}
+
+bool
+cs::SlotSolver::solve ()
+{
+    const unsigned int n = mWindows.size ();
+    const unsigned int m = mSlots.size ();
+    const double       inf = std::numeric_limits<double>::infinity ();
+
+    mAssignment.assign (n, NoSlot);
+
+    if (n > m)
+	return false;
+
+    if (!n)
+	return true;
+
+    mCost.resize (n * m);
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+	float *row = &mCost[i * m];
+
+	for (unsigned int j = 0; j < m; j++)
+	{
+	    float dx = mWindows[i].x - mSlots[j].x;
+	    float dy = mWindows[i].y - mSlots[j].y;
+
+	    row[j] = sqrtf (dx * dx + dy * dy);
+	}
+    }
+
+    mWindowPotential.assign (n, 0.0);
+    mSlotPotential.assign (m, 0.0);
+    mSlotOwner.assign (m, NoSlot);
+    mPending.clear ();
+
+    /*
+     * Start each window off at the distance to its nearest slot and
+     * give it that slot if it is still free. Most windows in a scale
+     * layout end up there, leaving few to search paths for.
+     */
+    for (unsigned int i = 0; i < n; i++)
+    {
+	const float  *row = &mCost[i * m];
+	unsigned int nearest = 0;
+
+	for (unsigned int j = 1; j < m; j++)
+	    if (row[j] < row[nearest])
+		nearest = j;
+
+	mWindowPotential[i] = row[nearest];
+
+	if (mSlotOwner[nearest] == NoSlot)
+	{
+	    mSlotOwner[nearest] = i;
+	    mAssignment[i] = nearest;
+	}
+	else
+	    mPending.push_back (i);
+    }
+
+    /*
+     * Give each remaining window a slot along the shortest path of
+     * reassignments (in reduced costs) that ends at a free slot,
+     * then update the potentials so that all assignments stay tight.
+     */
+    mPath.resize (m);
+    mMinSlack.resize (m);
+    mRemaining.resize (m);
+    mVisitedWindows.resize (n);
+    mVisitedSlots.resize (m);
+
+    for (unsigned int k = 0; k < mPending.size (); k++)
+    {
+	unsigned int start = mPending[k];
+	unsigned int i = start;
+	unsigned int remaining = m;
+	int          sink = NoSlot;
+	double       minSlack = 0.0;
+
+	for (unsigned int j = 0; j < m; j++)
+	    mRemaining[j] = j;
+
+	mMinSlack.assign (m, inf);
+	mVisitedWindows.assign (n, 0);
+	mVisitedSlots.assign (m, 0);
+
+	while (sink == NoSlot)
+	{
+	    const float  *row = &mCost[i * m];
+	    unsigned int lowestIndex = 0;
+	    double       lowest = inf;
+	    double       base = minSlack - mWindowPotential[i];
+
+	    mVisitedWindows[i] = 1;
+
+	    for (unsigned int r = 0; r < remaining; r++)
+	    {
+		unsigned int j = mRemaining[r];
+		double       slack = base + row[j] - mSlotPotential[j];
+
+		if (slack < mMinSlack[j])
+		{
+		    mPath[j] = i;
+		    mMinSlack[j] = slack;
+		}
+
+		/* On ties prefer free slots, they end the search */
+		if (mMinSlack[j] < lowest ||
+		    (mMinSlack[j] == lowest && mSlotOwner[j] == NoSlot))
+		{
+		    lowest = mMinSlack[j];
+		    lowestIndex = r;
+		}
+	    }
+
+	    unsigned int j = mRemaining[lowestIndex];
+
+	    minSlack = lowest;
+	    mVisitedSlots[j] = 1;
+	    mRemaining[lowestIndex] = mRemaining[--remaining];
+
+	    if (mSlotOwner[j] == NoSlot)
+		sink = j;
+	    else
+		i = mSlotOwner[j];
+	}
+
+	mWindowPotential[start] += minSlack;
+
+	for (unsigned int w = 0; w < n; w++)
+	    if (mVisitedWindows[w] && w != start)
+		mWindowPotential[w] += minSlack - mMinSlack[mAssignment[w]];
+
+	for (unsigned int s = 0; s < m; s++)
+	    if (mVisitedSlots[s])
+		mSlotPotential[s] -= minSlack - mMinSlack[s];
+
+	/* Flip the assignments along the path back to the new window */
+	int j = sink;
+
+	for (;;)
+	{
+	    unsigned int owner = mPath[j];
+	    int          previous = mAssignment[owner];
+
+	    mSlotOwner[j] = owner;
+	    mAssignment[owner] = j;
+
+	    if (owner == start)
+		break;
+
+	    j = previous;
+	}
+    }
+
+    return true;
+}
+
+int
+cs::SlotSolver::slot (unsigned int window) const
+{
+    if (window >= mAssignment.size ())
+	return NoSlot;
+
+    return mAssignment[window];
+}
+
+float
+cs::SlotSolver::distance (unsigned int window) const
+{
+    int s = slot (window);
+
+    if (s == NoSlot)
+	return 0.0f;
+
+    float dx = mWindows[window].x - mSlots[s].x;
+    float dy = mWindows[window].y - mSlots[s].y;
+
+    return sqrtf (dx * dx + dy * dy);
+}
@@ -0,0 +1,106 @@
+/*
+ * Compiz, scale plugin, slot assignment solver
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Times one slot assignment for window counts that a busy scale can
+ * realistically show, with the slots laid out as scale lays them out.
+ * It should stay well within a 16ms frame.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/time.h>
+
+#include "slot-solver.h"
+
+namespace cs = compiz::scale;
+
+static double
+now ()
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void
+fillProblem (cs::SlotSolver &solver, int nWindows)
+{
+    const int width = 1920, height = 1080;
+    int       lines = sqrt (nWindows + 1);
+    int       nSlots = 0;
+
+    solver.clear ();
+
+    for (int i = 0; i < nWindows; i++)
+	solver.addWindow (rand () % width, rand () % height);
+
+    for (int i = 0; i < lines; i++)
+    {
+	int n = ceilf ((float) nWindows / lines);
+
+	if (n > nWindows - nSlots)
+	    n = nWindows - nSlots;
+
+	for (int j = 0; j < n; j++, nSlots++)
+	    solver.addSlot ((j + 0.5f) * width / n,
+			    (i + 0.5f) * height / lines);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    const int counts[] = { 50, 100, 200, 300 };
+    const int rounds = 20;
+
+    cs::SlotSolver solver;
+
+    srand (1);
+
+    for (unsigned int c = 0; c < sizeof (counts) / sizeof (counts[0]); c++)
+    {
+	double total = 0.0, worst = 0.0;
+
+	for (int r = 0; r < rounds; r++)
+	{
+	    fillProblem (solver, counts[c]);
+
+	    double start = now ();
+	    solver.solve ();
+	    double elapsed = now () - start;
+
+	    total += elapsed;
+	    if (elapsed > worst)
+		worst = elapsed;
+	}
+
+	printf ("%3d windows: %7.3f ms average, %7.3f ms worst\n",
+		counts[c], total / rounds, worst);
+    }
+
+    return 0;
+}
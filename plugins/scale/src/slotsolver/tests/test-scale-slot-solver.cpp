@@ -0,0 +1,211 @@
+/*
+ * Compiz, scale plugin, slot assignment solver
+ *
+ * Copyright (c) 2012 Canonical Ltd.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "slot-solver.h"
+
+namespace cs = compiz::scale;
+
+namespace
+{
+    float
+    assignedDistance (const cs::SlotSolver &solver)
+    {
+	float sum = 0.0f;
+
+	for (unsigned int i = 0; i < solver.windowCount (); i++)
+	    sum += solver.distance (i);
+
+	return sum;
+    }
+
+    /* Tries every way of giving each window its own slot */
+    float
+    bruteForceDistance (const std::vector<float> &windows,
+			const std::vector<float> &slots)
+    {
+	unsigned int      n = windows.size () / 2;
+	unsigned int      m = slots.size () / 2;
+	std::vector<int>  order (m);
+	float             best = HUGE_VALF;
+
+	for (unsigned int j = 0; j < m; j++)
+	    order[j] = j;
+
+	do
+	{
+	    float sum = 0.0f;
+
+	    for (unsigned int i = 0; i < n; i++)
+	    {
+		float dx = windows[i * 2] - slots[order[i] * 2];
+		float dy = windows[i * 2 + 1] - slots[order[i] * 2 + 1];
+
+		sum += sqrtf (dx * dx + dy * dy);
+	    }
+
+	    best = std::min (best, sum);
+	} while (std::next_permutation (order.begin (), order.end ()));
+
+	return best;
+    }
+}
+
+TEST (ScaleSlotSolver, TestNoWindows)
+{
+    cs::SlotSolver solver;
+
+    solver.addSlot (10, 10);
+
+    EXPECT_TRUE (solver.solve ());
+    EXPECT_EQ (cs::SlotSolver::NoSlot, solver.slot (0));
+}
+
+TEST (ScaleSlotSolver, TestMoreWindowsThanSlots)
+{
+    cs::SlotSolver solver;
+
+    solver.addWindow (0, 0);
+    solver.addWindow (5, 5);
+    solver.addSlot (10, 10);
+
+    EXPECT_FALSE (solver.solve ());
+    EXPECT_EQ (cs::SlotSolver::NoSlot, solver.slot (0));
+    EXPECT_EQ (cs::SlotSolver::NoSlot, solver.slot (1));
+}
+
+TEST (ScaleSlotSolver, TestSingleWindow)
+{
+    cs::SlotSolver solver;
+
+    solver.addWindow (100, 100);
+    solver.addSlot (0, 0);
+    solver.addSlot (90, 100);
+    solver.addSlot (300, 300);
+
+    ASSERT_TRUE (solver.solve ());
+    EXPECT_EQ (1, solver.slot (0));
+    EXPECT_FLOAT_EQ (10.0f, solver.distance (0));
+}
+
+TEST (ScaleSlotSolver, TestNotGreedy)
+{
+    cs::SlotSolver solver;
+
+    /*
+     * Giving the first window its nearest slot (the one at 1, 0)
+     * pushes the second window to the far slot; swapping them is
+     * better overall.
+     */
+    solver.addWindow (0, 0);
+    solver.addWindow (3, 0);
+    solver.addSlot (1, 0);
+    solver.addSlot (-2, 0);
+
+    ASSERT_TRUE (solver.solve ());
+    EXPECT_EQ (1, solver.slot (0));
+    EXPECT_EQ (0, solver.slot (1));
+    EXPECT_FLOAT_EQ (4.0f, assignedDistance (solver));
+}
+
+TEST (ScaleSlotSolver, TestEachSlotUsedOnce)
+{
+    cs::SlotSolver solver;
+
+    for (unsigned int i = 0; i < 20; i++)
+    {
+	solver.addWindow (50, 50);
+	solver.addSlot (i * 10, i * 20);
+    }
+
+    ASSERT_TRUE (solver.solve ());
+
+    std::vector<bool> used (20, false);
+
+    for (unsigned int i = 0; i < 20; i++)
+    {
+	int s = solver.slot (i);
+
+	ASSERT_NE (cs::SlotSolver::NoSlot, s);
+	EXPECT_FALSE (used[s]);
+	used[s] = true;
+    }
+}
+
+TEST (ScaleSlotSolver, TestMatchesBruteForce)
+{
+    srand (1);
+
+    for (unsigned int round = 0; round < 50; round++)
+    {
+	cs::SlotSolver     solver;
+	std::vector<float> windows, slots;
+	unsigned int       n = 1 + round % 6;
+	unsigned int       m = n + round % 2;
+
+	for (unsigned int i = 0; i < n * 2; i++)
+	    windows.push_back (rand () % 1000);
+
+	for (unsigned int j = 0; j < m * 2; j++)
+	    slots.push_back (rand () % 1000);
+
+	for (unsigned int i = 0; i < n; i++)
+	    solver.addWindow (windows[i * 2], windows[i * 2 + 1]);
+
+	for (unsigned int j = 0; j < m; j++)
+	    solver.addSlot (slots[j * 2], slots[j * 2 + 1]);
+
+	ASSERT_TRUE (solver.solve ());
+	EXPECT_NEAR (bruteForceDistance (windows, slots),
+		     assignedDistance (solver), 0.01f);
+    }
+}
+
+TEST (ScaleSlotSolver, TestClearAndReuse)
+{
+    cs::SlotSolver solver;
+
+    solver.addWindow (0, 0);
+    solver.addWindow (10, 10);
+    solver.addSlot (0, 0);
+    solver.addSlot (10, 10);
+    ASSERT_TRUE (solver.solve ());
+
+    solver.clear ();
+    EXPECT_EQ (0, solver.windowCount ());
+    EXPECT_EQ (0, solver.slotCount ());
+    EXPECT_EQ (cs::SlotSolver::NoSlot, solver.slot (0));
+
+    solver.addWindow (10, 10);
+    solver.addSlot (0, 0);
+    solver.addSlot (10, 10);
+    ASSERT_TRUE (solver.solve ());
+    EXPECT_EQ (1, solver.slot (0));
+}
@@ -233,6 +233,57 @@ ce::setEventWindowInButtonPressArguments (ce::EventArguments &arguments,
     arguments[1].value ().set ((int) eventWindow);
 }
 
+namespace
+{
+    /* Whether next, queued directly behind event, makes it redundant */
+    bool supersedesXEvent (const XEvent &event,
+			   const XEvent &next)
+    {
+	if (next.type != event.type)
+	    return false;
+
+	switch (event.type) {
+	    case MotionNotify:
+		return true;
+	    /* A ConfigureNotify carries the complete geometry
+	     * and stacking of the window */
+	    case ConfigureNotify:
+		return next.xconfigure.event  == event.xconfigure.event &&
+		       next.xconfigure.window == event.xconfigure.window;
+	    /* Handlers read the property back from the server, so of a
+	     * run of new values only the last one counts. A deletion
+	     * ends the run */
+	    case PropertyNotify:
+		return event.xproperty.state == PropertyNewValue       &&
+		       next.xproperty.state  == PropertyNewValue       &&
+		       next.xproperty.window == event.xproperty.window &&
+		       next.xproperty.atom   == event.xproperty.atom;
+	    default:
+		return false;
+	}
+    }
+}
+
+unsigned int
+ce::coalesceXEvent (XEvent                     &event,
+		    ce::QueuedXEventsInterface &queue,
+		    bool                       keepConfigureNotify)
+{
+    unsigned int dropped = 0;
+    XEvent       next;
+
+    if (event.type == ConfigureNotify && keepConfigureNotify)
+	return dropped;
+
+    while (queue.peekXEvent (next) && supersedesXEvent (event, next))
+    {
+	queue.nextXEvent (event);
+	dropped++;
+    }
+
+    return dropped;
+}
+
 namespace
 {
     bool buttonActionModifiersMatchEventState (unsigned int actionModifiers,
@@ -44,6 +44,26 @@ namespace cps = compiz::private_screen;
 typedef std::vector <CompOption> EventArguments;
 typedef boost::function <bool (unsigned int, unsigned int)> ActionModsMatchesEventStateFunc;
 
+class QueuedXEventsInterface
+{
+    public:
+
+	virtual ~QueuedXEventsInterface () {}
+
+	/* Copies the next queued event, false if there is none */
+	virtual bool peekXEvent (XEvent &event) = 0;
+	/* Removes the next queued event and copies it */
+	virtual void nextXEvent (XEvent &event) = 0;
+};
+
+/* Replaces event with the last of the events queued directly behind
+ * it that make it redundant, and returns how many were dropped.
+ * ConfigureNotify events are left alone if keepConfigureNotify is set */
+unsigned int
+coalesceXEvent (XEvent                 &event,
+		QueuedXEventsInterface &queue,
+		bool                   keepConfigureNotify);
+
 int
 processButtonPressOnEdgeWindow (Window               edgeWindow,
 				Window               root,
@@ -39,6 +39,16 @@
 
 const CompMatch CompMatch::emptyMatch;
 
+namespace
+{
+    /* Cache slots handed out to matches evaluated with evaluateCached */
+    std::vector<int> freeCacheSlots;
+    int              nextCacheSlot = 0;
+
+    /* Bumped whenever cached results of all windows become invalid */
+    unsigned int     cacheGeneration = 1;
+}
+
 class CoreExp : public CompMatch::Expression {
     public:
 	virtual ~CoreExp () {};
@@ -149,6 +159,8 @@ matchUpdateMatchOptions (CompOption::Vector& options)
 void
 CompScreen::matchExpHandlerChanged ()
 {
+    PrivateMatch::invalidateCache ();
+
     WRAPABLE_HND_FUNCTN (matchExpHandlerChanged);
     _matchExpHandlerChanged ();
 }
@@ -166,6 +178,9 @@ CompScreenImpl::_matchExpHandlerChanged ()
 void
 CompScreen::matchPropertyChanged (CompWindow *w)
 {
+    /* Before any plugin gets to re-evaluate its matches for w */
+    PrivateMatch::invalidateCache (w);
+
     WRAPABLE_HND_FUNCTN (matchPropertyChanged, w);
     _matchPropertyChanged (w);
 }
@@ -462,58 +477,198 @@ matchUpdateOps (MatchOp::List &list)
     }
 }
 
-static bool
-matchEvalOps (MatchOp::List &list,
-	      const CompWindow *w)
+static unsigned int
+matchEmit (std::vector<MatchInstruction> &program,
+	   const MatchInstruction           &instruction)
 {
-    bool       value, result = false;
-    MatchExpOp *exp;
+    program.push_back (instruction);
+    return program.size () - 1;
+}
+
+static void
+matchCompileExp (std::vector<MatchInstruction> &program,
+		 MatchExpOp                    *exp,
+		 bool                          negate)
+{
+    const CompMatch::Expression *e = exp->e.get ();
+    const CoreExp               *core = dynamic_cast <const CoreExp *> (e);
+
+    if (!e)
+    {
+	/* no handler for this expression, it always matches */
+	matchEmit (program, MatchInstruction (MatchInstruction::OpTrue,
+					      negate));
+	return;
+    }
+
+    if (!core)
+    {
+	MatchInstruction instruction (MatchInstruction::OpExp, negate);
+
+	instruction.exp = e;
+	matchEmit (program, instruction);
+	return;
+    }
+
+    MatchInstruction instruction (MatchInstruction::OpTrue, negate);
+
+    switch (core->mType)
+    {
+	case CoreExp::TypeXid:
+	    instruction.op  = MatchInstruction::OpXid;
+	    instruction.val = core->priv.val;
+	    break;
+	case CoreExp::TypeState:
+	    instruction.op   = MatchInstruction::OpState;
+	    instruction.mask = core->priv.uval;
+	    break;
+	case CoreExp::TypeOverride:
+	    instruction.op  = MatchInstruction::OpOverride;
+	    instruction.val = core->priv.val;
+	    break;
+	case CoreExp::TypeRGBA:
+	    instruction.op  = MatchInstruction::OpRGBA;
+	    instruction.val = core->priv.val;
+	    break;
+	case CoreExp::TypeType:
+	    instruction.op   = MatchInstruction::OpType;
+	    instruction.mask = core->priv.uval;
+	    break;
+    }
+
+    matchEmit (program, instruction);
+}
+
+/*
+ * Appends code leaving the value of list in the result register. This
+ * mirrors the short-circuit rules of the tree: before an & operand a
+ * false result ends the list, before an | operand a true one does.
+ */
+static void
+matchCompileOps (std::vector<MatchInstruction> &program,
+		 MatchOp::List                 &list)
+{
+    std::vector<unsigned int> exits;
+    bool                      first = true;
+
+    if (list.empty ())
+	matchEmit (program, MatchInstruction (MatchInstruction::OpSetFalse));
 
     foreach (MatchOp *op, list)
     {
-	/* fast evaluation */
+	bool negate = (op->flags & MATCH_OP_NOT_MASK);
+
 	if (op->flags & MATCH_OP_AND_MASK)
 	{
-	    /* result will never be true */
-	    if (!result)
-		return false;
+	    /* the result of an empty list so far is false */
+	    if (first)
+		matchEmit (program,
+			   MatchInstruction (MatchInstruction::OpSetFalse));
+
+	    exits.push_back (matchEmit (program,
+	        MatchInstruction (MatchInstruction::OpJumpIfFalse)));
 	}
-	else
+	else if (!first)
 	{
-	    /* result will always be true */
-	    if (result)
-		return true;
+	    exits.push_back (matchEmit (program,
+	        MatchInstruction (MatchInstruction::OpJumpIfTrue)));
 	}
 
+	first = false;
+
 	switch (op->type ()) {
 	    case MatchOp::TypeGroup:
-		value =
-		    matchEvalOps (dynamic_cast <MatchGroupOp *> (op)->op, w);
+		matchCompileOps (program,
+				 dynamic_cast <MatchGroupOp *> (op)->op);
+		if (negate)
+		    matchEmit (program,
+			       MatchInstruction (MatchInstruction::OpNot));
 		break;
 	    case MatchOp::TypeExp:
-		exp = dynamic_cast <MatchExpOp *> (op);
-		if (exp->e.get ())
-		    value = exp->e->evaluate (w);
-		else
-		    value = true;
+		matchCompileExp (program, dynamic_cast <MatchExpOp *> (op),
+				 negate);
 		break;
 	    default:
-		value = true;
+		matchEmit (program, MatchInstruction (MatchInstruction::OpTrue,
+						      negate));
 		break;
 	}
+    }
 
-	if (op->flags & MATCH_OP_NOT_MASK)
-	    value = !value;
+    foreach (unsigned int jump, exits)
+	program[jump].target = program.size ();
+}
 
-	if (op->flags & MATCH_OP_AND_MASK)
-	    result = (result && value);
-	else
-	    result = (result || value);
+static bool
+matchRunProgram (const std::vector<MatchInstruction> &program,
+		 const CompWindow                    *w)
+{
+    bool         result = false;
+    unsigned int pc = 0, size = program.size ();
+
+    while (pc < size)
+    {
+	const MatchInstruction &i = program[pc++];
+
+	switch (i.op) {
+	    case MatchInstruction::OpTrue:
+		result = !i.negate;
+		break;
+	    case MatchInstruction::OpXid:
+		result = (((unsigned int) i.val == w->id ()) != i.negate);
+		break;
+	    case MatchInstruction::OpState:
+		result = (((i.mask & w->state ()) != 0) != i.negate);
+		break;
+	    case MatchInstruction::OpOverride:
+	    {
+		bool overrideRedirect = w->overrideRedirect ();
+		result = (((i.val == 1 && overrideRedirect) ||
+			   (i.val == 0 && !overrideRedirect)) != i.negate);
+		break;
+	    }
+	    case MatchInstruction::OpRGBA:
+	    {
+		bool alpha = w->alpha ();
+		result = (((i.val && alpha) || (!i.val && !alpha)) != i.negate);
+		break;
+	    }
+	    case MatchInstruction::OpType:
+		result = (((i.mask & w->wmType ()) != 0) != i.negate);
+		break;
+	    case MatchInstruction::OpExp:
+		result = (i.exp->evaluate (w) != i.negate);
+		break;
+	    case MatchInstruction::OpNot:
+		result = !result;
+		break;
+	    case MatchInstruction::OpSetFalse:
+		result = false;
+		break;
+	    case MatchInstruction::OpJumpIfTrue:
+		if (result)
+		    pc = i.target;
+		break;
+	    case MatchInstruction::OpJumpIfFalse:
+		if (!result)
+		    pc = i.target;
+		break;
+	}
     }
 
     return result;
 }
 
+MatchInstruction::MatchInstruction (Op op, bool negate) :
+    op (op),
+    negate (negate),
+    val (0),
+    mask (0),
+    target (0),
+    exp (NULL)
+{
+}
+
 MatchOp::MatchOp () :
     flags (0)
 {
@@ -585,9 +740,130 @@ MatchGroupOp::operator= (const MatchGroupOp &gr)
     return *this;
 }
 
+MatchResultCache::MatchResultCache () :
+    generation (0),
+    known (),
+    value ()
+{
+}
+
+void
+MatchResultCache::invalidate ()
+{
+    known.clear ();
+    value.clear ();
+}
+
 PrivateMatch::PrivateMatch () :
-    op ()
+    op (),
+    cacheSlot (-1),
+    program ()
+{
+}
+
+PrivateMatch::~PrivateMatch ()
 {
+    releaseCacheSlot ();
+}
+
+void
+PrivateMatch::releaseCacheSlot ()
+{
+    if (cacheSlot < 0)
+	return;
+
+    /* The slot may be handed to another match, so nothing
+     * stored for it so far can be trusted anymore */
+    freeCacheSlots.push_back (cacheSlot);
+    cacheSlot = -1;
+
+    invalidateCache ();
+}
+
+MatchResultCache &
+PrivateMatch::windowCache (const CompWindow *w)
+{
+    return w->priv->matchCache;
+}
+
+void
+PrivateMatch::invalidateCache ()
+{
+    cacheGeneration++;
+}
+
+void
+PrivateMatch::invalidateCache (const CompWindow *w)
+{
+    windowCache (w).invalidate ();
+}
+
+void
+PrivateMatch::update ()
+{
+    releaseCacheSlot ();
+    matchResetOps (op.op);
+    matchUpdateOps (op.op);
+
+    compile ();
+}
+
+void
+PrivateMatch::compile ()
+{
+    program.clear ();
+    matchCompileOps (program, op.op);
+}
+
+bool
+PrivateMatch::evaluate (const CompWindow *window) const
+{
+    return matchRunProgram (program, window);
+}
+
+bool
+PrivateMatch::evaluateCached (MatchResultCache &cache,
+			      const CompWindow *window)
+{
+    if (cacheSlot < 0)
+    {
+	if (freeCacheSlots.empty ())
+	    cacheSlot = nextCacheSlot++;
+	else
+	{
+	    cacheSlot = freeCacheSlots.back ();
+	    freeCacheSlots.pop_back ();
+	}
+    }
+
+    if (cache.generation != cacheGeneration)
+    {
+	cache.invalidate ();
+	cache.generation = cacheGeneration;
+    }
+
+    unsigned int slot = cacheSlot;
+
+    if (slot < cache.known.size () && cache.known[slot])
+	return cache.value[slot];
+
+    unsigned int generation = cacheGeneration;
+    bool         result = evaluate (window);
+
+    /* Don't store anything if evaluating invalidated the cache */
+    if (generation != cacheGeneration || cacheSlot < 0)
+	return result;
+
+    if (slot >= cache.known.size ())
+    {
+	cache.known.resize (slot + 1, false);
+	cache.value.resize (slot + 1, false);
+    }
+
+    cache.known[slot] = true;
+    cache.value[slot] = result;
+
+    return result;
 }
 
 
@@ -618,14 +894,19 @@ CompMatch::~CompMatch ()
 void
 CompMatch::update ()
 {
-    matchResetOps (priv->op.op);
-    matchUpdateOps (priv->op.op);
+    priv->update ();
 }
 
 bool
 CompMatch::evaluate (const CompWindow *window) const
 {
-    return matchEvalOps (priv->op.op, window);
+    return priv->evaluate (window);
+}
+
+bool
+CompMatch::evaluateCached (const CompWindow *window) const
+{
+    return priv->evaluateCached (PrivateMatch::windowCache (window), window);
 }
 
 CompString
@@ -30,6 +30,7 @@
 
 #include <core/match.h>
 #include <boost/shared_ptr.hpp>
+#include <vector>
 
 #define MATCH_OP_AND_MASK (1 << 0)
 #define MATCH_OP_NOT_MASK (1 << 1)
@@ -77,12 +78,77 @@ class MatchGroupOp : public MatchOp {
 	MatchOp::List op;
 };
 
+/*
+ * One step of the flat program CompMatch::update builds from the
+ * expression tree. Core expressions are inlined as compares against
+ * the window, anything provided by plugins goes through
+ * CompMatch::Expression::evaluate. Jumps implement the short-circuit
+ * evaluation of & and |.
+ */
+class MatchInstruction {
+    public:
+	typedef enum {
+	    OpTrue,
+	    OpXid,
+	    OpState,
+	    OpOverride,
+	    OpRGBA,
+	    OpType,
+	    OpExp,
+	    OpNot,
+	    OpSetFalse,
+	    OpJumpIfTrue,
+	    OpJumpIfFalse
+	} Op;
+
+	MatchInstruction (Op op, bool negate = false);
+
+	Op            op;
+	bool          negate;
+	long          val;
+	unsigned long mask;
+	unsigned int  target;
+
+	const CompMatch::Expression *exp;
+};
+
+/*
+ * Results of CompMatch::evaluateCached for one window, indexed by the
+ * cache slot of the match. Only valid while generation is the current
+ * cache generation.
+ */
+class MatchResultCache {
+    public:
+	MatchResultCache ();
+
+	void invalidate ();
+
+	unsigned int      generation;
+	std::vector<bool> known;
+	std::vector<bool> value;
+};
+
 class PrivateMatch {
     public:
 	PrivateMatch ();
+	~PrivateMatch ();
+
+	void update ();
+	void compile ();
+	void releaseCacheSlot ();
+
+	bool evaluate (const CompWindow *) const;
+	bool evaluateCached (MatchResultCache &, const CompWindow *);
+
+	static MatchResultCache & windowCache (const CompWindow *);
+	static void invalidateCache ();
+	static void invalidateCache (const CompWindow *);
 
     public:
 	MatchGroupOp op;
+	int          cacheSlot;
+
+	std::vector<MatchInstruction> program;
 };
 
 #endif
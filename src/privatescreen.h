@@ -139,6 +139,7 @@ class WindowManager : boost::noncopyable
 	    { return clientListStacking; }
 
 	CompWindow * findWindow (Window id) const;
+	CompWindow * findWindowWithServerFrame (Window frame) const;
 	CompWindow * getTopWindow() const;
 	CompWindow * getTopServerWindow() const;
 
@@ -189,12 +190,21 @@ class WindowManager : boost::noncopyable
 	}
 
     private:
+	CompWindow * findStackSibling (Window aboveId) const;
+	CompWindow * findServerStackSibling (Window aboveId) const;
+	void forgetFrames (CompWindow *w) const;
+
 	CompWindowList windows;
 	CompWindowList serverWindows;
 	CompWindowList destroyedWindows;
 	bool           stackIsFresh;
 
 	CompWindow::Map windowsMap;
+
+	/* Frame to window caches for stack lookups, every entry is
+	 * checked against the window before being used */
+	mutable CompWindow::Map frameWindows;
+	mutable CompWindow::Map serverFrameWindows;
 	std::list<CompGroup *> groups;
 
 	CompWindowVector clientList;            /* clients in mapping order */
@@ -612,6 +622,9 @@ class PrivateScreen :
 	bool getNextXEvent (XEvent &);
 	void processEvents ();
 
+	/* Events dropped by getNextXEvent so far, of that type */
+	unsigned int coalescedEvents (int type) const;
+
 	bool triggerButtonPressBindings (CompOption::Vector &options,
 					 XButtonEvent       *event,
 					 CompOption::Vector &arguments);
@@ -781,6 +794,10 @@ private:
     CompTimer edgeDelayTimer;
     CompDelayedEdgeSettings edgeDelaySettings;
     Window xdndWindow;
+
+    /* Events dropped by getNextXEvent, by type */
+    unsigned int coalesced[LASTEvent];
+
     compiz::private_screen::PluginManager pluginManager;
     compiz::private_screen::WindowManager& windowManager;
 };
@@ -1034,6 +1051,7 @@ class CompScreenImpl : public CompScreen,
 	virtual void addToDestroyedWindows(CompWindow * cw);
 	virtual void processEvents ();
 	virtual void alwaysHandleEvent (XEvent *event);
+	virtual unsigned int coalescedEvents (int type) const;
 
 	virtual ServerGrabInterface * serverGrabInterface ();
 
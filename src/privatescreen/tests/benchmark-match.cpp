@@ -0,0 +1,138 @@
+/*
+ * Times CompMatch evaluation over random expression trees, once with the
+ * compiled MatchInstruction program and once with the recursive walk
+ * over the MatchOp tree it replaced.
+ *
+ * Core expressions (xid, state, type...) need a real CompWindow, so all
+ * leaves are stand-ins for plugin expressions that read a bit of a
+ * global input. This measures the cost of the evaluation loop itself,
+ * core expressions only get cheaper in the program as they are inlined.
+ */
+
+#include "privatematch.h"
+#include "match-tree-walk.h"
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+    const unsigned int numInputs   = 6;
+    const unsigned int numMatches  = 200;
+    const unsigned int repetitions = 5000;
+
+    unsigned int inputs = 0;
+
+    class InputExpression :
+	public CompMatch::Expression
+    {
+	public:
+
+	    InputExpression (unsigned int bit) :
+		mBit (bit)
+	    {
+	    }
+
+	    bool evaluate (const CompWindow *) const
+	    {
+		return inputs & (1 << mBit);
+	    }
+
+	private:
+
+	    unsigned int mBit;
+    };
+
+    double
+    elapsedMs (const struct timeval &start)
+    {
+	struct timeval now;
+	gettimeofday (&now, NULL);
+
+	return (now.tv_sec - start.tv_sec) * 1000.0 +
+	       (now.tv_usec - start.tv_usec) / 1000.0;
+    }
+
+    void
+    randomOps (MatchOp::List &list,
+	       unsigned int  depth,
+	       unsigned int  *seed)
+    {
+	unsigned int n = 1 + rand_r (seed) % 4;
+
+	for (unsigned int i = 0; i < n; i++)
+	{
+	    unsigned int flags = rand_r (seed) % 4;
+
+	    if (depth && rand_r (seed) % 3 == 0)
+	    {
+		MatchGroupOp *group = new MatchGroupOp ();
+
+		group->flags = flags;
+		randomOps (group->op, depth - 1, seed);
+		list.push_back (group);
+	    }
+	    else
+	    {
+		MatchExpOp *exp = new MatchExpOp ();
+
+		exp->flags = flags;
+		exp->e.reset (new InputExpression (rand_r (seed) % numInputs));
+		list.push_back (exp);
+	    }
+	}
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    std::vector <PrivateMatch *> matches;
+    unsigned int                 seed = 1;
+    const CompWindow             *window = NULL;
+
+    for (unsigned int i = 0; i < numMatches; i++)
+    {
+	PrivateMatch *match = new PrivateMatch ();
+
+	randomOps (match->op.op, 3, &seed);
+	match->compile ();
+	matches.push_back (match);
+    }
+
+    unsigned int   walked = 0, run = 0, evaluations = 0;
+    struct timeval start;
+
+    gettimeofday (&start, NULL);
+    for (unsigned int r = 0; r < repetitions; r++)
+    {
+	inputs = r;
+	for (unsigned int i = 0; i < numMatches; i++)
+	    walked += matchTreeWalk (matches[i]->op.op, window);
+    }
+    double walkMs = elapsedMs (start);
+
+    gettimeofday (&start, NULL);
+    for (unsigned int r = 0; r < repetitions; r++)
+    {
+	inputs = r;
+	for (unsigned int i = 0; i < numMatches; i++)
+	    run += matches[i]->evaluate (window);
+    }
+    double programMs = elapsedMs (start);
+
+    evaluations = repetitions * numMatches;
+
+    printf ("%u evaluations of %u random matches\n", evaluations, numMatches);
+    printf ("tree walk: %8.2f ms, %6.1f ns each (%u true)\n",
+	    walkMs, walkMs * 1e6 / evaluations, walked);
+    printf ("program:   %8.2f ms, %6.1f ns each (%u true)\n",
+	    programMs, programMs * 1e6 / evaluations, run);
+
+    for (unsigned int i = 0; i < numMatches; i++)
+	delete matches[i];
+
+    return walked == run ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#ifndef _COMPIZ_TEST_MATCH_TREE_WALK_H
+#define _COMPIZ_TEST_MATCH_TREE_WALK_H
+
+#include "privatematch.h"
+
+/*
+ * The recursive walk over the MatchOp tree that CompMatch::evaluate
+ * used before matches were compiled into a MatchInstruction program.
+ * Kept as the reference the program is checked and timed against.
+ */
+inline bool
+matchTreeWalk (const MatchOp::List &list,
+	       const CompWindow    *w)
+{
+    bool result = false;
+
+    for (MatchOp::List::const_iterator it = list.begin ();
+	 it != list.end (); ++it)
+    {
+	MatchOp *op = *it;
+	bool    value;
+
+	/* fast evaluation */
+	if (op->flags & MATCH_OP_AND_MASK)
+	{
+	    /* result will never be true */
+	    if (!result)
+		return false;
+	}
+	else
+	{
+	    /* result will always be true */
+	    if (result)
+		return true;
+	}
+
+	switch (op->type ()) {
+	    case MatchOp::TypeGroup:
+		value = matchTreeWalk (dynamic_cast <MatchGroupOp *> (op)->op,
+				       w);
+		break;
+	    case MatchOp::TypeExp:
+	    {
+		MatchExpOp *exp = dynamic_cast <MatchExpOp *> (op);
+
+		if (exp->e.get ())
+		    value = exp->e->evaluate (w);
+		else
+		    value = true;
+		break;
+	    }
+	    default:
+		value = true;
+		break;
+	}
+
+	if (op->flags & MATCH_OP_NOT_MASK)
+	    value = !value;
+
+	if (op->flags & MATCH_OP_AND_MASK)
+	    result = (result && value);
+	else
+	    result = (result || value);
+    }
+
+    return result;
+}
+
+#endif
@@ -1,5 +1,8 @@
 #include "privatescreen.h"
+#include "privatewindow.h"
 #include "privateaction.h"
+#include "privatematch.h"
+#include "match-tree-walk.h"
 #include "eventmanagement.h"
 
 // Get rid of stupid macro from X.h
@@ -10,6 +13,7 @@
 #include <gmock/gmock.h>
 
 #include <stdlib.h>
+#include <deque>
 
 using ::testing::Return;
 using ::testing::ReturnRef;
@@ -166,12 +170,15 @@ public:
     MOCK_METHOD2(outputDeviceForPoint, int (int x, int y));
     MOCK_METHOD0(xkbEvent, int ());
     MOCK_METHOD2(warpPointer, void (int dx, int dy));
+    MOCK_METHOD2(viewportsForGeometry, void (const CompWindow::Geometry &gm,
+					     CompPoint::vector &viewports));
     MOCK_METHOD2(updateGrab, void (GrabHandle handle, Cursor cursor));
     MOCK_METHOD0(shapeEvent, int ());
     MOCK_METHOD0(syncEvent, int ());
     MOCK_METHOD0(autoRaiseWindow, Window  ());
     MOCK_METHOD0(processEvents, void ());
     MOCK_METHOD1(alwaysHandleEvent, void (XEvent *event));
+    MOCK_CONST_METHOD1(coalescedEvents, unsigned int (int type));
     MOCK_METHOD0(displayString, const char * ());
     MOCK_METHOD0(getCurrentOutputExtents, CompRect ());
     MOCK_METHOD0(normalCursor, Cursor ());
@@ -1415,3 +1422,642 @@ TEST (privatescreen_ActionActiveTest, TestMakeActionActive)
     ca::setActionActiveState (action, false);
     ASSERT_EQ (action.active (), false);
 }
+
+namespace
+{
+class CountedExpression :
+    public CompMatch::Expression
+{
+    public:
+
+	CountedExpression (const bool &value, unsigned int &count) :
+	    mValue (value),
+	    mCount (count)
+	{
+	}
+
+	bool evaluate (const CompWindow *) const
+	{
+	    ++mCount;
+	    return mValue;
+	}
+
+    private:
+
+	const bool   &mValue;
+	unsigned int &mCount;
+};
+
+class privatescreen_MatchCacheTest :
+    public ::testing::Test
+{
+    public:
+
+	privatescreen_MatchCacheTest () :
+	    value (true),
+	    count (0)
+	{
+	    EXPECT_CALL (screen, _matchInitExp (_))
+		.WillRepeatedly (Invoke (this,
+					 &privatescreen_MatchCacheTest::createExpression));
+	}
+
+	CompMatch::Expression * createExpression (const CompString &)
+	{
+	    return new CountedExpression (value, count);
+	}
+
+	void setExpression (PrivateMatch &match)
+	{
+	    MatchExpOp *exp = new MatchExpOp ();
+
+	    exp->value = "counted";
+	    match.op.op.push_back (exp);
+	    match.update ();
+	}
+
+    protected:
+
+	MockCompScreen screen;
+
+	/* CompWindow can't be created here, the counted expression
+	 * never looks at the window */
+	static const CompWindow * const window;
+
+	bool         value;
+	unsigned int count;
+};
+
+const CompWindow * const privatescreen_MatchCacheTest::window = NULL;
+}
+
+TEST_F (privatescreen_MatchCacheTest, SecondEvaluationIsCached)
+{
+    PrivateMatch     match;
+    MatchResultCache cache;
+
+    setExpression (match);
+
+    EXPECT_TRUE (match.evaluateCached (cache, window));
+
+    value = false;
+
+    EXPECT_TRUE (match.evaluateCached (cache, window));
+    EXPECT_EQ (1u, count);
+}
+
+TEST_F (privatescreen_MatchCacheTest, InvalidatingOneWindowKeepsTheOthers)
+{
+    PrivateMatch     match;
+    MatchResultCache invalidated, kept;
+
+    setExpression (match);
+
+    match.evaluateCached (invalidated, window);
+    match.evaluateCached (kept, window);
+    ASSERT_EQ (2u, count);
+
+    value = false;
+    invalidated.invalidate ();
+
+    EXPECT_FALSE (match.evaluateCached (invalidated, window));
+    EXPECT_TRUE (match.evaluateCached (kept, window));
+    EXPECT_EQ (3u, count);
+}
+
+TEST_F (privatescreen_MatchCacheTest, NewGenerationInvalidatesAllWindows)
+{
+    PrivateMatch     match;
+    MatchResultCache first, second;
+
+    setExpression (match);
+
+    match.evaluateCached (first, window);
+    match.evaluateCached (second, window);
+    ASSERT_EQ (2u, count);
+
+    value = false;
+    PrivateMatch::invalidateCache ();
+
+    EXPECT_FALSE (match.evaluateCached (first, window));
+    EXPECT_FALSE (match.evaluateCached (second, window));
+    EXPECT_EQ (4u, count);
+}
+
+TEST_F (privatescreen_MatchCacheTest, UpdatingTheMatchInvalidatesItsResult)
+{
+    PrivateMatch     match;
+    MatchResultCache cache;
+
+    setExpression (match);
+
+    EXPECT_TRUE (match.evaluateCached (cache, window));
+
+    value = false;
+    match.update ();
+
+    EXPECT_FALSE (match.evaluateCached (cache, window));
+    EXPECT_EQ (2u, count);
+}
+
+TEST_F (privatescreen_MatchCacheTest, ReusedSlotDoesNotSeeResultOfDestroyedMatch)
+{
+    MatchResultCache cache;
+    PrivateMatch     *destroyed = new PrivateMatch ();
+
+    setExpression (*destroyed);
+
+    EXPECT_TRUE (destroyed->evaluateCached (cache, window));
+
+    int slot = destroyed->cacheSlot;
+
+    ASSERT_GE (slot, 0);
+    delete destroyed;
+
+    PrivateMatch reusing;
+
+    setExpression (reusing);
+    value = false;
+
+    EXPECT_FALSE (reusing.evaluateCached (cache, window));
+    EXPECT_EQ (slot, reusing.cacheSlot);
+    EXPECT_EQ (2u, count);
+}
+
+namespace
+{
+/* "a" is true if bit 0 of inputs is set, "b" if bit 1 is and so on.
+ * Evaluations are appended to trace, so the tests can check that the
+ * short-circuit rules are kept too */
+class InputExpression :
+    public CompMatch::Expression
+{
+    public:
+
+	InputExpression (unsigned int        bit,
+			 const unsigned int &inputs,
+			 std::string        &trace) :
+	    mBit (bit),
+	    mInputs (inputs),
+	    mTrace (trace)
+	{
+	}
+
+	bool evaluate (const CompWindow *) const
+	{
+	    mTrace += 'a' + mBit;
+	    return mInputs & (1 << mBit);
+	}
+
+    private:
+
+	unsigned int       mBit;
+	const unsigned int &mInputs;
+	std::string        &mTrace;
+};
+
+class privatescreen_MatchProgramTest :
+    public ::testing::Test
+{
+    public:
+
+	static const unsigned int numInputs = 4;
+
+	privatescreen_MatchProgramTest () :
+	    inputs (0)
+	{
+	    EXPECT_CALL (screen, _matchInitExp (_))
+		.WillRepeatedly (Invoke (this,
+			&privatescreen_MatchProgramTest::createExpression));
+	}
+
+	/* "z" has no handler, like expressions of unloaded plugins */
+	CompMatch::Expression * createExpression (const CompString &value)
+	{
+	    if (value == "z")
+		return NULL;
+
+	    return new InputExpression (value[0] - 'a', inputs, trace);
+	}
+
+	static MatchOp * exp (char name, unsigned int flags = 0)
+	{
+	    MatchExpOp *exp = new MatchExpOp ();
+
+	    exp->value = CompString (1, name);
+	    exp->flags = flags;
+
+	    return exp;
+	}
+
+	static MatchGroupOp * group (unsigned int flags = 0)
+	{
+	    MatchGroupOp *group = new MatchGroupOp ();
+
+	    group->flags = flags;
+
+	    return group;
+	}
+
+	static void randomOps (MatchOp::List &list,
+			       unsigned int  depth,
+			       unsigned int  *seed)
+	{
+	    unsigned int n = rand_r (seed) % 5;
+
+	    for (unsigned int i = 0; i < n; i++)
+	    {
+		unsigned int flags = rand_r (seed) % 4;
+
+		if (depth && rand_r (seed) % 3 == 0)
+		{
+		    MatchGroupOp *g = group (flags);
+
+		    randomOps (g->op, depth - 1, seed);
+		    list.push_back (g);
+		}
+		else if (rand_r (seed) % 10 == 0)
+		    list.push_back (exp ('z', flags));
+		else
+		    list.push_back (exp ('a' + rand_r (seed) % numInputs,
+					 flags));
+	    }
+	}
+
+	void expectProgramMatchesTreeWalk (PrivateMatch &match)
+	{
+	    match.update ();
+
+	    for (inputs = 0; inputs < (1u << numInputs); inputs++)
+	    {
+		trace.clear ();
+		bool        walked = matchTreeWalk (match.op.op, window);
+		std::string walkedTrace = trace;
+
+		trace.clear ();
+		EXPECT_EQ (walked, match.evaluate (window))
+		    << "inputs " << inputs;
+		EXPECT_EQ (walkedTrace, trace) << "inputs " << inputs;
+	    }
+	}
+
+    protected:
+
+	MockCompScreen screen;
+
+	static const CompWindow * const window;
+
+	unsigned int inputs;
+	std::string  trace;
+};
+
+const CompWindow * const privatescreen_MatchProgramTest::window = NULL;
+}
+
+/* a | b & c | d, evaluated from left to right */
+TEST_F (privatescreen_MatchProgramTest, FlatList)
+{
+    PrivateMatch match;
+
+    match.op.op.push_back (exp ('a'));
+    match.op.op.push_back (exp ('b'));
+    match.op.op.push_back (exp ('c', MATCH_OP_AND_MASK));
+    match.op.op.push_back (exp ('d'));
+
+    expectProgramMatchesTreeWalk (match);
+}
+
+/* !a & !b | c */
+TEST_F (privatescreen_MatchProgramTest, Negation)
+{
+    PrivateMatch match;
+
+    match.op.op.push_back (exp ('a', MATCH_OP_NOT_MASK));
+    match.op.op.push_back (exp ('b', MATCH_OP_AND_MASK | MATCH_OP_NOT_MASK));
+    match.op.op.push_back (exp ('c'));
+
+    expectProgramMatchesTreeWalk (match);
+}
+
+/* a & (b | !(c & d)) | !(a | d) */
+TEST_F (privatescreen_MatchProgramTest, NestedGroups)
+{
+    PrivateMatch match;
+    MatchGroupOp *outer = group (MATCH_OP_AND_MASK);
+    MatchGroupOp *inner = group (MATCH_OP_NOT_MASK);
+    MatchGroupOp *last = group (MATCH_OP_NOT_MASK);
+
+    inner->op.push_back (exp ('c'));
+    inner->op.push_back (exp ('d', MATCH_OP_AND_MASK));
+
+    outer->op.push_back (exp ('b'));
+    outer->op.push_back (inner);
+
+    last->op.push_back (exp ('a'));
+    last->op.push_back (exp ('d'));
+
+    match.op.op.push_back (exp ('a'));
+    match.op.op.push_back (outer);
+    match.op.op.push_back (last);
+
+    expectProgramMatchesTreeWalk (match);
+}
+
+/* & a | () & !() */
+TEST_F (privatescreen_MatchProgramTest, LeadingAndAndEmptyGroups)
+{
+    PrivateMatch match;
+
+    match.op.op.push_back (exp ('a', MATCH_OP_AND_MASK));
+    match.op.op.push_back (group ());
+    match.op.op.push_back (group (MATCH_OP_AND_MASK | MATCH_OP_NOT_MASK));
+
+    expectProgramMatchesTreeWalk (match);
+}
+
+/* z & a | !z */
+TEST_F (privatescreen_MatchProgramTest, ExpressionWithoutHandler)
+{
+    PrivateMatch match;
+
+    match.op.op.push_back (exp ('z'));
+    match.op.op.push_back (exp ('a', MATCH_OP_AND_MASK));
+    match.op.op.push_back (exp ('z', MATCH_OP_NOT_MASK));
+
+    expectProgramMatchesTreeWalk (match);
+}
+
+TEST_F (privatescreen_MatchProgramTest, RandomTrees)
+{
+    unsigned int seed = 1;
+
+    for (unsigned int i = 0; i < 500; i++)
+    {
+	PrivateMatch match;
+
+	randomOps (match.op.op, 3, &seed);
+	expectProgramMatchesTreeWalk (match);
+    }
+}
+
+namespace
+{
+class privatescreen_WindowManagerTest :
+    public ::testing::Test
+{
+    public:
+
+	privatescreen_WindowManagerTest ()
+	{
+	    TimeoutHandler::SetDefault (new TimeoutHandler ());
+
+	    EXPECT_CALL (screen, destroyedWindows ())
+		.WillRepeatedly (ReturnRef (destroyed));
+	}
+
+	~privatescreen_WindowManagerTest ()
+	{
+	    for (unsigned int i = 0; i < windows.size (); i++)
+	    {
+		/* Skip the unreparenting and the X calls on the way out */
+		privs[i]->serverFrame = None;
+		privs[i]->destroyed = true;
+		delete windows[i];
+	    }
+
+	    TimeoutHandler::SetDefault (NULL);
+	}
+
+	CompWindow * createWindow (Window id, Window serverFrame)
+	{
+	    PrivateWindow *priv = new PrivateWindow ();
+
+	    priv->id = priv->serverId = id;
+	    priv->serverFrame = serverFrame;
+	    memset (&priv->attrib, 0, sizeof (priv->attrib));
+
+	    privs.push_back (priv);
+	    windows.push_back (PrivateWindow::createStandIn (priv));
+
+	    return windows.back ();
+	}
+
+    protected:
+
+	MockCompScreen               screen;
+	cps::WindowManager           windowManager;
+	CompWindowList               destroyed;
+	std::vector<CompWindow *>    windows;
+	std::vector<PrivateWindow *> privs;
+};
+}
+
+TEST_F (privatescreen_WindowManagerTest, ForgetsFrameOfWindowOnlyInServerStack)
+{
+    const Window frame = 0x201;
+
+    CompWindow *bottom = createWindow (0x100, 0x200);
+    CompWindow *serverOnly = createWindow (0x101, frame);
+    PrivateWindow *serverOnlyPriv = privs.back ();
+    CompWindow *top = createWindow (0x102, 0x202);
+
+    windowManager.insertWindow (bottom, 0);
+    windowManager.insertServerWindow (bottom, 0);
+
+    /* Nothing it could go above in the client stack */
+    windowManager.insertWindow (serverOnly, 0xdead);
+    windowManager.insertServerWindow (serverOnly, 0x200);
+    ASSERT_FALSE (serverOnlyPriv->inStack);
+
+    /* Looking up its frame caches it */
+    windowManager.insertServerWindow (top, frame);
+    ASSERT_EQ (serverOnly, top->serverPrev);
+
+    windowManager.unhookServerWindow (top);
+    windowManager.unhookWindow (serverOnly);
+    windowManager.unhookServerWindow (serverOnly);
+
+    /* As if it was deleted and its memory reused by
+     * something that looks like a stacked window */
+    serverOnlyPriv->inStack = true;
+    serverOnlyPriv->inServerStack = true;
+
+    EXPECT_EQ (static_cast <CompWindow *> (NULL),
+	       windowManager.findWindowWithServerFrame (frame));
+
+    serverOnlyPriv->inStack = false;
+    serverOnlyPriv->inServerStack = false;
+}
+
+namespace
+{
+class FakeXEventQueue :
+    public ce::QueuedXEventsInterface
+{
+    public:
+
+	bool peekXEvent (XEvent &event)
+	{
+	    if (events.empty ())
+		return false;
+
+	    event = events.front ();
+	    return true;
+	}
+
+	void nextXEvent (XEvent &event)
+	{
+	    event = events.front ();
+	    events.pop_front ();
+	}
+
+	std::deque <XEvent> events;
+};
+
+class privatescreen_CoalesceXEventTest :
+    public ::testing::Test
+{
+    public:
+
+	XEvent motion (Time time)
+	{
+	    XEvent event;
+
+	    memset (&event, 0, sizeof (event));
+	    event.xmotion.type = MotionNotify;
+	    event.xmotion.time = time;
+
+	    return event;
+	}
+
+	XEvent configure (Window window, int x)
+	{
+	    XEvent event;
+
+	    memset (&event, 0, sizeof (event));
+	    event.xconfigure.type = ConfigureNotify;
+	    event.xconfigure.event = event.xconfigure.window = window;
+	    event.xconfigure.x = x;
+
+	    return event;
+	}
+
+	XEvent property (Window window, Atom atom, int state, Time time)
+	{
+	    XEvent event;
+
+	    memset (&event, 0, sizeof (event));
+	    event.xproperty.type = PropertyNotify;
+	    event.xproperty.window = window;
+	    event.xproperty.atom = atom;
+	    event.xproperty.state = state;
+	    event.xproperty.time = time;
+
+	    return event;
+	}
+
+	unsigned int coalesce (XEvent &event, bool keepConfigureNotify = false)
+	{
+	    return ce::coalesceXEvent (event, queue, keepConfigureNotify);
+	}
+
+    protected:
+
+	FakeXEventQueue queue;
+};
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, MotionNotifyRunKeepsTheLast)
+{
+    XEvent event = motion (1);
+
+    queue.events.push_back (motion (2));
+    queue.events.push_back (motion (3));
+    queue.events.push_back (configure (0x100, 0));
+
+    EXPECT_EQ (2u, coalesce (event));
+    EXPECT_EQ (3, event.xmotion.time);
+    EXPECT_EQ (1u, queue.events.size ());
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, ConfigureNotifyRunForOneWindowKeepsTheLast)
+{
+    XEvent event = configure (0x100, 1);
+
+    queue.events.push_back (configure (0x100, 2));
+    queue.events.push_back (configure (0x101, 3));
+    queue.events.push_back (configure (0x100, 4));
+
+    EXPECT_EQ (1u, coalesce (event));
+    EXPECT_EQ (2, event.xconfigure.x);
+    EXPECT_EQ (2u, queue.events.size ());
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, KeepsConfigureNotifyWhenAsked)
+{
+    XEvent event = configure (0x100, 1);
+
+    queue.events.push_back (configure (0x100, 2));
+
+    EXPECT_EQ (0u, coalesce (event, true));
+    EXPECT_EQ (1, event.xconfigure.x);
+    EXPECT_EQ (1u, queue.events.size ());
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, PropertyNotifyRunKeepsTheLast)
+{
+    XEvent event = property (0x100, 1, PropertyNewValue, 1);
+
+    queue.events.push_back (property (0x100, 1, PropertyNewValue, 2));
+    queue.events.push_back (property (0x100, 1, PropertyNewValue, 3));
+
+    EXPECT_EQ (2u, coalesce (event));
+    EXPECT_EQ (3, event.xproperty.time);
+    EXPECT_TRUE (queue.events.empty ());
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, PropertyNotifyStopsAtOtherEvents)
+{
+    XEvent event = property (0x100, 1, PropertyNewValue, 1);
+
+    /* Something handled in between may depend on the value
+     * the property had at that point */
+    queue.events.push_back (configure (0x100, 0));
+    queue.events.push_back (property (0x100, 1, PropertyNewValue, 2));
+
+    EXPECT_EQ (0u, coalesce (event));
+    EXPECT_EQ (1, event.xproperty.time);
+    EXPECT_EQ (2u, queue.events.size ());
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, PropertyNotifyStopsAtOtherProperties)
+{
+    XEvent event = property (0x100, 1, PropertyNewValue, 1);
+
+    queue.events.push_back (property (0x100, 2, PropertyNewValue, 2));
+    queue.events.push_back (property (0x101, 1, PropertyNewValue, 3));
+    queue.events.push_back (property (0x100, 1, PropertyNewValue, 4));
+
+    EXPECT_EQ (0u, coalesce (event));
+    EXPECT_EQ (1, event.xproperty.time);
+    EXPECT_EQ (3u, queue.events.size ());
+}
+
+TEST_F (privatescreen_CoalesceXEventTest, PropertyNotifyStopsAtDeletion)
+{
+    XEvent event = property (0x100, 1, PropertyNewValue, 1);
+
+    queue.events.push_back (property (0x100, 1, PropertyNewValue, 2));
+    queue.events.push_back (property (0x100, 1, PropertyDelete, 3));
+    queue.events.push_back (property (0x100, 1, PropertyNewValue, 4));
+
+    EXPECT_EQ (1u, coalesce (event));
+    EXPECT_EQ (2, event.xproperty.time);
+    EXPECT_EQ (2u, queue.events.size ());
+
+    event = property (0x100, 1, PropertyDelete, 3);
+    queue.events.pop_front ();
+
+    EXPECT_EQ (0u, coalesce (event));
+    EXPECT_EQ (1u, queue.events.size ());
+}
@@ -33,6 +33,8 @@
 #include <core/point.h>
 #include <core/timer.h>
 
+#include "privatematch.h"
+
 #include <boost/shared_ptr.hpp>
 
 #define XWINDOWCHANGES_INIT {0, 0, 0, 0, 0, None, 0}
@@ -230,6 +232,8 @@ class PrivateWindow {
 
 	char * getStartupId ();
 
+	std::vector<Atom> initialProperties ();
+
 	CompRegion
 	rectsToRegion (unsigned int, XRectangle *);
 
@@ -285,6 +289,10 @@ class PrivateWindow {
 	bool checkClear ();
 
 	static CompWindow* createCompWindow (Window aboveId, Window aboveServerId, XWindowAttributes &wa, Window id);
+
+	/* Only attaches priv, without inserting the window into the
+	 * stacks or touching the X window. For stand-ins in tests */
+	static CompWindow* createStandIn (PrivateWindow *priv);
     public:
 
 	PrivateWindow *priv;
@@ -397,7 +405,20 @@ class PrivateWindow {
 	int closeRequests;
 	Time lastCloseRequestTime;
 
+	/* Where this window is in the stacking lists of the window
+	 * manager, only valid while inStack / inServerStack are set */
+	CompWindowList::iterator stackPosition;
+	CompWindowList::iterator serverStackPosition;
+	bool                     inStack;
+	bool                     inServerStack;
+
+	/* Frames this window is cached under for stack lookups */
+	Window cachedFrame;
+	Window cachedServerFrame;
+
 	bool nextMoveImmediate;
+
+	MatchResultCache matchCache;
 };
 
 #endif
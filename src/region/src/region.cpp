@@ -31,6 +31,8 @@
 #include <X11/Xregion.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <cassert>
 
 #include <boost/foreach.hpp>
@@ -42,13 +44,291 @@ const CompRegion infiniteRegion (CompRect (MINSHORT, MINSHORT,
 				           MAXSHORT * 2, MAXSHORT * 2));
 const CompRegion emptyRegion;
 
-/* Alternate emptyRegion, mostly just required to construct infiniteRegion
-   when emptyRegion may still be uninitialized */
-static const CompRegion &
-_emptyRegion ()
+/*
+ * Fast paths that work directly on the box storage of an Xlib region.
+ *
+ * The storage layout is the one Xlib uses (y-x banded, coalesced boxes
+ * allocated with malloc), so the results can be handed back to any
+ * X*Region function and callers of CompRegion::handle () see no
+ * difference. Only the trivial cases (copies, single boxes) are handled
+ * here, everything else still goes through the Xlib band engine.
+ */
+namespace
 {
-    static const CompRegion r;
-    return r;
+    /* Make sure a region can hold at least n boxes */
+    inline bool
+    reserveBoxes (Region r, long n)
+    {
+	if (r->size >= n)
+	    return true;
+
+	BOX *rects = static_cast <BOX *> (realloc (r->rects, n * sizeof (BOX)));
+
+	if (!rects)
+	    return false;
+
+	r->rects = rects;
+	r->size  = n;
+
+	return true;
+    }
+
+    inline void
+    setEmpty (Region r)
+    {
+	r->numRects = 0;
+	r->extents.x1 = r->extents.y1 = 0;
+	r->extents.x2 = r->extents.y2 = 0;
+    }
+
+    inline void
+    setBox (Region r, short x1, short y1, short x2, short y2)
+    {
+	if (x1 >= x2 || y1 >= y2 || !reserveBoxes (r, 1))
+	{
+	    setEmpty (r);
+	    return;
+	}
+
+	r->numRects   = 1;
+	r->extents.x1 = x1;
+	r->extents.y1 = y1;
+	r->extents.x2 = x2;
+	r->extents.y2 = y2;
+	r->rects[0]   = r->extents;
+    }
+
+    /* Same conversion that XUnionRectWithRegion does for an XRectangle */
+    inline void
+    setRect (Region r, int x, int y, int width, int height)
+    {
+	XRectangle rect;
+
+	rect.x      = x;
+	rect.y      = y;
+	rect.width  = width;
+	rect.height = height;
+
+	if (!rect.width || !rect.height)
+	{
+	    setEmpty (r);
+	    return;
+	}
+
+	setBox (r, rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+    }
+
+    /* CompRect::region () always has one box, also when the rect has
+     * no area, and such a box must not be taken for a real one */
+    inline bool
+    hasNoArea (Region r)
+    {
+	return !r->numRects ||
+	       (r->numRects == 1 &&
+		(r->rects[0].x1 >= r->rects[0].x2 ||
+		 r->rects[0].y1 >= r->rects[0].y2));
+    }
+
+    inline void
+    copyRegion (Region dst, Region src)
+    {
+	if (dst == src)
+	    return;
+
+	if (hasNoArea (src))
+	{
+	    setEmpty (dst);
+	    return;
+	}
+
+	if (!reserveBoxes (dst, src->numRects))
+	    return;
+
+	memcpy (dst->rects, src->rects, src->numRects * sizeof (BOX));
+	dst->numRects = src->numRects;
+	dst->extents  = src->extents;
+    }
+
+    inline bool
+    extentsOverlap (Region a, Region b)
+    {
+	return a->extents.x1 < b->extents.x2 &&
+	       a->extents.x2 > b->extents.x1 &&
+	       a->extents.y1 < b->extents.y2 &&
+	       a->extents.y2 > b->extents.y1;
+    }
+
+    inline bool
+    boxContains (const BOX &outer, const BOX &inner)
+    {
+	return outer.x1 <= inner.x1 && outer.y1 <= inner.y1 &&
+	       outer.x2 >= inner.x2 && outer.y2 >= inner.y2;
+    }
+
+    /* dst = a & b, returns false if the Xlib engine has to do it */
+    inline bool
+    fastIntersect (Region a, Region b, Region dst)
+    {
+	if (hasNoArea (a) || hasNoArea (b) || !extentsOverlap (a, b))
+	{
+	    setEmpty (dst);
+	    return true;
+	}
+
+	if (a->numRects == 1 && b->numRects == 1)
+	{
+	    setBox (dst,
+		    MAX (a->rects[0].x1, b->rects[0].x1),
+		    MAX (a->rects[0].y1, b->rects[0].y1),
+		    MIN (a->rects[0].x2, b->rects[0].x2),
+		    MIN (a->rects[0].y2, b->rects[0].y2));
+	    return true;
+	}
+
+	if (a->numRects == 1 && boxContains (a->rects[0], b->extents))
+	{
+	    copyRegion (dst, b);
+	    return true;
+	}
+
+	if (b->numRects == 1 && boxContains (b->rects[0], a->extents))
+	{
+	    copyRegion (dst, a);
+	    return true;
+	}
+
+	return false;
+    }
+
+    /* dst = a - b, returns false if the Xlib engine has to do it */
+    inline bool
+    fastSubtract (Region a, Region b, Region dst)
+    {
+	if (hasNoArea (a) || hasNoArea (b) || !extentsOverlap (a, b))
+	{
+	    copyRegion (dst, a);
+	    return true;
+	}
+
+	if (b->numRects == 1 && boxContains (b->rects[0], a->extents))
+	{
+	    setEmpty (dst);
+	    return true;
+	}
+
+	if (a->numRects != 1 || b->numRects != 1)
+	    return false;
+
+	/* Box minus box: at most one band above, one band with a left
+	 * and/or a right piece and one band below, which is already the
+	 * canonical banded form */
+	const BOX ra = a->rects[0];
+	const BOX rb = b->rects[0];
+	const short my1 = MAX (ra.y1, rb.y1);
+	const short my2 = MIN (ra.y2, rb.y2);
+	BOX  boxes[4];
+	long n = 0;
+
+	if (rb.y1 > ra.y1)
+	{
+	    boxes[n].x1 = ra.x1; boxes[n].y1 = ra.y1;
+	    boxes[n].x2 = ra.x2; boxes[n].y2 = rb.y1;
+	    n++;
+	}
+
+	if (rb.x1 > ra.x1)
+	{
+	    boxes[n].x1 = ra.x1; boxes[n].y1 = my1;
+	    boxes[n].x2 = rb.x1; boxes[n].y2 = my2;
+	    n++;
+	}
+
+	if (rb.x2 < ra.x2)
+	{
+	    boxes[n].x1 = rb.x2; boxes[n].y1 = my1;
+	    boxes[n].x2 = ra.x2; boxes[n].y2 = my2;
+	    n++;
+	}
+
+	if (rb.y2 < ra.y2)
+	{
+	    boxes[n].x1 = ra.x1; boxes[n].y1 = rb.y2;
+	    boxes[n].x2 = ra.x2; boxes[n].y2 = ra.y2;
+	    n++;
+	}
+
+	if (!reserveBoxes (dst, n))
+	    return false;
+
+	memcpy (dst->rects, boxes, n * sizeof (BOX));
+	dst->numRects = n;
+	dst->extents.x1 = ra.x1;
+	dst->extents.x2 = ra.x2;
+	dst->extents.y1 = boxes[0].y1;
+	dst->extents.y2 = boxes[n - 1].y2;
+
+	/* Only the middle band is missing a side, the outer x extents
+	 * shrink if there are no full-width bands at all */
+	if (rb.y1 <= ra.y1 && rb.y2 >= ra.y2)
+	{
+	    dst->extents.x1 = boxes[0].x1;
+	    dst->extents.x2 = boxes[n - 1].x2;
+	}
+
+	return true;
+    }
+
+    /* dst = a + b, returns false if the Xlib engine has to do it */
+    inline bool
+    fastUnion (Region a, Region b, Region dst)
+    {
+	if (a == b || hasNoArea (b))
+	{
+	    copyRegion (dst, a);
+	    return true;
+	}
+
+	if (hasNoArea (a))
+	{
+	    copyRegion (dst, b);
+	    return true;
+	}
+
+	if (a->numRects == 1 && boxContains (a->rects[0], b->extents))
+	{
+	    copyRegion (dst, a);
+	    return true;
+	}
+
+	if (b->numRects == 1 && boxContains (b->rects[0], a->extents))
+	{
+	    copyRegion (dst, b);
+	    return true;
+	}
+
+	return false;
+    }
+
+    inline void
+    intersectRegion (Region a, Region b, Region dst)
+    {
+	if (!fastIntersect (a, b, dst))
+	    XIntersectRegion (a, b, dst);
+    }
+
+    inline void
+    subtractRegion (Region a, Region b, Region dst)
+    {
+	if (!fastSubtract (a, b, dst))
+	    XSubtractRegion (a, b, dst);
+    }
+
+    inline void
+    unionRegion (Region a, Region b, Region dst)
+    {
+	if (!fastUnion (a, b, dst))
+	    XUnionRegion (a, b, dst);
+    }
 }
 
 CompRegion::CompRegion ()
@@ -59,35 +339,19 @@ CompRegion::CompRegion ()
 CompRegion::CompRegion (const CompRegion &c)
 {
     init ();
-    XUnionRegion (_emptyRegion ().handle (), c.handle (), handle ());
+    copyRegion (handle (), c.handle ());
 }
 
 CompRegion::CompRegion ( int x, int y, int w, int h)
 {
     init ();
-    
-    XRectangle rect;
-    
-    rect.x = x;
-    rect.y = y;
-    rect.width = w;
-    rect.height = h;
-    
-    XUnionRectWithRegion (&rect, _emptyRegion ().handle (), handle ());
+    setRect (handle (), x, y, w, h);
 }
 
 CompRegion::CompRegion (const CompRect &r)
 {
     init ();
-    
-    XRectangle rect;
-    
-    rect.x = r.x ();
-    rect.y = r.y ();
-    rect.width = r.width ();
-    rect.height = r.height ();
-    
-    XUnionRectWithRegion (&rect, _emptyRegion ().handle (), handle ());
+    setRect (handle (), r.x (), r.y (), r.width (), r.height ());
 }
 
 CompRegion::CompRegion (Region external)
@@ -129,7 +393,7 @@ CompRegion::handle () const
 CompRegion &
 CompRegion::operator= (const CompRegion &c)
 {
-    XUnionRegion (emptyRegion.handle (), c.handle (), handle ());
+    copyRegion (handle (), c.handle ());
     return *this;
 }
 
@@ -181,22 +445,25 @@ CompRegion::contains (int x, int y, int width, int height) const
 CompRegion
 CompRegion::intersected (const CompRegion &r) const
 {
-    CompRegion reg (r);
-    XIntersectRegion (reg.handle (), handle (), reg.handle ());
+    CompRegion reg;
+    intersectRegion (r.handle (), handle (), reg.handle ());
     return reg;
 }
 
 CompRegion
 CompRegion::intersected (const CompRect &r) const
 {
-    CompRegion reg (r);
-    XIntersectRegion (reg.handle (), handle (), reg.handle ());
+    CompRegion reg;
+    intersectRegion (r.region (), handle (), reg.handle ());
     return reg;
 }
 
 bool
 CompRegion::intersects (const CompRegion &r) const
 {
+    if (!extentsOverlap (handle (), r.handle ()))
+	return false;
+
     return !intersected (r).isEmpty ();
 }
 
@@ -241,7 +508,7 @@ CompRegion
 CompRegion::subtracted (const CompRegion &r) const
 {
     CompRegion rv;
-    XSubtractRegion (handle (), r.handle (), rv.handle ());
+    subtractRegion (handle (), r.handle (), rv.handle ());
     return rv;
 }
 
@@ -249,7 +516,7 @@ CompRegion
 CompRegion::subtracted (const CompRect &r) const
 {
     CompRegion rv;
-    XSubtractRegion (handle (), r.region (), rv.handle ());
+    subtractRegion (handle (), r.region (), rv.handle ());
     return rv;
 }
 
@@ -313,7 +580,7 @@ CompRegion
 CompRegion::united (const CompRegion &r) const
 {
     CompRegion rv;
-    XUnionRegion (handle (), r.handle (), rv.handle ());
+    unionRegion (handle (), r.handle (), rv.handle ());
     return rv;
 }
 
@@ -321,7 +588,7 @@ CompRegion
 CompRegion::united (const CompRect &r) const
 {
     CompRegion rv;
-    XUnionRegion (handle (), r.region (), rv.handle ());
+    unionRegion (handle (), r.region (), rv.handle ());
     return rv;
 }
 
@@ -348,15 +615,14 @@ CompRegion::operator& (const CompRect &r) const
 CompRegion &
 CompRegion::operator&= (const CompRegion &r)
 {
-    XIntersectRegion (r.handle (), handle (), handle ());
+    intersectRegion (r.handle (), handle (), handle ());
     return *this;
 }
 
 CompRegion &
 CompRegion::operator&= (const CompRect &r)
 {
-    CompRegionRef ref (r.region ());
-    XIntersectRegion (ref.handle (), handle (), handle ());
+    intersectRegion (r.region (), handle (), handle ());
     return *this;
 }
 
@@ -375,15 +641,14 @@ CompRegion::operator+ (const CompRect &r) const
 CompRegion &
 CompRegion::operator+= (const CompRegion &r)
 {
-    XUnionRegion (handle (), r.handle (), handle ());
+    unionRegion (handle (), r.handle (), handle ());
     return *this;
 }
 
 CompRegion &
 CompRegion::operator+= (const CompRect &r)
 {
-    CompRegionRef ref (r.region ());
-    XUnionRegion (handle (), ref.handle (), handle ());
+    unionRegion (handle (), r.region (), handle ());
     return *this;
 }
 
@@ -402,15 +667,14 @@ CompRegion::operator- (const CompRect &r) const
 CompRegion &
 CompRegion::operator-= (const CompRegion &r)
 {
-    XSubtractRegion (handle (), r.handle (), handle ());
+    subtractRegion (handle (), r.handle (), handle ());
     return *this;
 }
 
 CompRegion &
 CompRegion::operator-= (const CompRect &r)
 {
-    CompRegionRef ref (r.region ());
-    XSubtractRegion (handle (), ref.handle (), handle ());
+    subtractRegion (handle (), r.region (), handle ());
     return *this;
 }
 
@@ -436,7 +700,7 @@ CompRegion::operator| (const CompRegion &r) const
 CompRegion &
 CompRegion::operator|= (const CompRegion &r)
 {
-    XUnionRegion (handle (), r.handle (), handle ());
+    unionRegion (handle (), r.handle (), handle ());
     return *this;
 }
 
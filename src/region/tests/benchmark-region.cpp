@@ -0,0 +1,168 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Simulates the occlusion detection pass of PrivateGLScreen::paintOutputRegion
+ * (copy the remaining region into each window's clip, then subtract the
+ * window region) over a stack of windows, once with CompRegion and once
+ * with the equivalent plain Xlib calls.
+ */
+
+#include "core/region.h"
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+    const int screenWidth  = 1920;
+    const int screenHeight = 1080;
+    const int frames       = 200;
+
+    double
+    elapsedMs (const struct timeval &start)
+    {
+	struct timeval now;
+	gettimeofday (&now, NULL);
+
+	return (now.tv_sec - start.tv_sec) * 1000.0 +
+	       (now.tv_usec - start.tv_usec) / 1000.0;
+    }
+
+    std::vector <CompRect>
+    makeWindows (unsigned int count)
+    {
+	std::vector <CompRect> windows;
+
+	srand (count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+	    int w = 50 + rand () % (screenWidth / 2);
+	    int h = 50 + rand () % (screenHeight / 2);
+	    int x = rand () % (screenWidth - w);
+	    int y = rand () % (screenHeight - h);
+
+	    windows.push_back (CompRect (x, y, w, h));
+	}
+
+	return windows;
+    }
+
+    double
+    occlusionCompRegion (const std::vector <CompRect> &windows)
+    {
+	const CompRegion  screenRegion (0, 0, screenWidth, screenHeight);
+	std::vector <CompRegion> clips (windows.size ());
+	std::vector <CompRegion> regions;
+	struct timeval start;
+
+	for (unsigned int i = 0; i < windows.size (); i++)
+	    regions.push_back (CompRegion (windows[i]));
+
+	gettimeofday (&start, NULL);
+
+	for (int f = 0; f < frames; f++)
+	{
+	    CompRegion tmpRegion (screenRegion);
+
+	    for (unsigned int i = 0; i < windows.size (); i++)
+	    {
+		clips[i] = tmpRegion;
+		tmpRegion -= regions[i];
+	    }
+	}
+
+	return elapsedMs (start) / frames;
+    }
+
+    double
+    occlusionXlib (const std::vector <CompRect> &windows)
+    {
+	Region screenRegion = XCreateRegion ();
+	Region empty = XCreateRegion ();
+	std::vector <Region> clips;
+	std::vector <Region> regions;
+	struct timeval start;
+
+	XUnionRegion (empty, CompRect (0, 0, screenWidth, screenHeight).region (),
+		      screenRegion);
+
+	for (unsigned int i = 0; i < windows.size (); i++)
+	{
+	    Region r = XCreateRegion ();
+	    XUnionRegion (empty, windows[i].region (), r);
+	    regions.push_back (r);
+	    clips.push_back (XCreateRegion ());
+	}
+
+	gettimeofday (&start, NULL);
+
+	for (int f = 0; f < frames; f++)
+	{
+	    Region tmpRegion = XCreateRegion ();
+	    XUnionRegion (empty, screenRegion, tmpRegion);
+
+	    for (unsigned int i = 0; i < windows.size (); i++)
+	    {
+		XUnionRegion (empty, tmpRegion, clips[i]);
+		XSubtractRegion (tmpRegion, regions[i], tmpRegion);
+	    }
+
+	    XDestroyRegion (tmpRegion);
+	}
+
+	double ms = elapsedMs (start) / frames;
+
+	for (unsigned int i = 0; i < windows.size (); i++)
+	{
+	    XDestroyRegion (regions[i]);
+	    XDestroyRegion (clips[i]);
+	}
+
+	XDestroyRegion (screenRegion);
+	XDestroyRegion (empty);
+
+	return ms;
+    }
+}
+
+int
+main ()
+{
+    const unsigned int counts[] = { 10, 50, 200, 400 };
+
+    printf ("%8s %16s %16s\n", "windows", "CompRegion (ms)", "Xlib (ms)");
+
+    for (unsigned int i = 0; i < sizeof (counts) / sizeof (counts[0]); i++)
+    {
+	std::vector <CompRect> windows (makeWindows (counts[i]));
+
+	printf ("%8u %16.4f %16.4f\n", counts[i],
+		occlusionCompRegion (windows),
+		occlusionXlib (windows));
+    }
+
+    return 0;
+}
@@ -58,10 +58,12 @@
 #include <core/screen.h>
 #include <core/icon.h>
 #include <core/atoms.h>
+#include <core/windowproperties.h>
 #include "privatescreen.h"
 #include "privatewindow.h"
 #include "privateaction.h"
 #include "privatestackdebugger.h"
+#include "eventmanagement.h"
 
 template class WrapableInterface<CompScreen, ScreenInterface>;
 
@@ -92,6 +94,8 @@ typedef struct {
 } MwmHints;
 
 namespace cps = compiz::private_screen;
+namespace ce = compiz::events;
+namespace cwp = compiz::window::properties;
 namespace ca = compiz::actions;
 
 
@@ -119,6 +123,12 @@ void CompScreenImpl::addToDestroyedWindows(CompWindow * cw)
 
 void CompScreenImpl::processEvents () { privateScreen.processEvents (); }
 
+unsigned int
+CompScreenImpl::coalescedEvents (int type) const
+{
+    return privateScreen.coalescedEvents (type);
+}
+
 unsigned int
 CompScreen::allocPluginClassIndex ()
 {
@@ -758,6 +768,39 @@ PrivateScreen::setOption (const CompString  &name,
     return rv;
 }
 
+namespace
+{
+/* The events Xlib has already read from the server */
+class XlibEventQueue :
+    public ce::QueuedXEventsInterface
+{
+    public:
+
+	XlibEventQueue (Display *dpy) :
+	    mDpy (dpy)
+	{
+	}
+
+	bool peekXEvent (XEvent &event)
+	{
+	    if (!XPending (mDpy))
+		return false;
+
+	    XPeekEvent (mDpy, &event);
+	    return true;
+	}
+
+	void nextXEvent (XEvent &event)
+	{
+	    XNextEvent (mDpy, &event);
+	}
+
+    private:
+
+	Display *mDpy;
+};
+}
+
 bool
 PrivateScreen::getNextXEvent (XEvent &ev)
 {
@@ -765,25 +808,35 @@ PrivateScreen::getNextXEvent (XEvent &ev)
 	return false;
     XNextEvent (dpy, &ev);
 
-    /* Skip to the last MotionNotify
-     * event in this sequence */
-    if (ev.type == MotionNotify)
-    {
-	XEvent peekEvent;
-	while (XPending (dpy))
-	{
-	    XPeekEvent (dpy, &peekEvent);
+    /* Every ConfigureNotify on a frame is matched against a configure
+     * request we sent, so those must all be seen */
+    bool keepConfigureNotify = false;
 
-	    if (peekEvent.type != MotionNotify)
-		break;
+    if (ev.type == ConfigureNotify)
+    {
+	CompWindow *w = screen->findTopLevelWindow (ev.xconfigure.window, true);
 
-	    XNextEvent (dpy, &peekEvent);
-	}
+	keepConfigureNotify = w && w->priv->serverFrame == ev.xconfigure.window;
     }
 
+    XlibEventQueue queue (dpy);
+    unsigned int   dropped = ce::coalesceXEvent (ev, queue, keepConfigureNotify);
+
+    if (dropped)
+	coalesced[ev.type] += dropped;
+
     return true;
 }
 
+unsigned int
+PrivateScreen::coalescedEvents (int type) const
+{
+    if (type < 0 || type >= LASTEvent)
+	return 0;
+
+    return coalesced[type];
+}
+
 bool
 PrivateScreen::getNextEvent (XEvent &ev)
 {
@@ -915,13 +968,24 @@ cps::WindowManager::validateServerWindows()
      * the server */
     if (stackIsFresh)
     {
+	foreach (CompWindow *sw, serverWindows)
+	{
+	    sw->priv->inServerStack = false;
+
+	    /* Won't be put back below, so nothing unhooks it anymore */
+	    if (!sw->priv->inStack)
+		forgetFrames (sw);
+	}
+
 	serverWindows.clear ();
 
 	foreach (CompWindow *sw, windows)
 	{
 	    sw->serverPrev = sw->prev;
 	    sw->serverNext = sw->next;
-	    serverWindows.push_back (sw);
+	    sw->priv->serverStackPosition =
+		serverWindows.insert (serverWindows.end (), sw);
+	    sw->priv->inServerStack = true;
 	}
     }
 }
@@ -1526,10 +1590,10 @@ cps::XWindowInfo::getWindowState (Window id)
     unsigned char *data;
     unsigned int  state = 0;
 
-    result = XGetWindowProperty (dpy, id,
-				 Atoms::winState,
-				 0L, 1024L, false, XA_ATOM, &actual, &format,
-				 &n, &left, &data);
+    result = cwp::getWindowProperty (dpy, id,
+				      Atoms::winState,
+				      0L, 1024L, false, XA_ATOM, &actual, &format,
+				      &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1601,10 +1665,10 @@ cps::XWindowInfo::getWindowType (Window id)
     unsigned long n, left;
     unsigned char *data;
 
-    result = XGetWindowProperty (dpy , id,
-				 Atoms::winType,
-				 0L, 1L, false, XA_ATOM, &actual, &format,
-				 &n, &left, &data);
+    result = cwp::getWindowProperty (dpy, id,
+				      Atoms::winType,
+				      0L, 1L, false, XA_ATOM, &actual, &format,
+				      &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1661,10 +1725,10 @@ cps::XWindowInfo::getMwmHints (Window       id,
     *func  = MwmFuncAll;
     *decor = MwmDecorAll;
 
-    result = XGetWindowProperty (dpy, id,
-				 Atoms::mwmHints,
-				 0L, 20L, false, Atoms::mwmHints,
-				 &actual, &format, &n, &left, &data);
+    result = cwp::getWindowProperty (dpy, id,
+				      Atoms::mwmHints,
+				      0L, 20L, false, Atoms::mwmHints,
+				      &actual, &format, &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1690,7 +1754,7 @@ cps::XWindowInfo::getProtocols (Window id)
     int          count;
     unsigned int protocols = 0;
 
-    if (XGetWMProtocols (dpy, id, &protocol, &count))
+    if (cwp::getWMProtocols (dpy, id, Atoms::wmProtocols, &protocol, &count))
     {
 	for (int i = 0; i < count; i++)
 	{
@@ -1721,9 +1785,9 @@ CompScreenImpl::getWindowProp (Window       id,
     unsigned char *data;
     unsigned int  retval = defaultValue;
 
-    result = XGetWindowProperty (privateScreen.dpy, id, property,
-				 0L, 1L, false, XA_CARDINAL, &actual, &format,
-				 &n, &left, &data);
+    result = cwp::getWindowProperty (privateScreen.dpy, id, property,
+				      0L, 1L, false, XA_CARDINAL, &actual, &format,
+				      &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -2817,21 +2881,147 @@ CompScreenImpl::findTopLevelWindow (Window id, bool override_redirect)
 	    return w;
     }
 
-    for (cps::WindowManager::iterator i = windowManager.begin(); i != windowManager.end(); ++i)
+    w = windowManager.findWindowWithServerFrame (id);
+
+    if (w && w->overrideRedirect () && !override_redirect)
+	return NULL;
+
+    return w;
+}
+
+namespace
+{
+    /* Remembers that w has the given frame, dropping whatever
+     * it was remembered under before */
+    void cacheFrame (CompWindow::Map &cache,
+		     Window          &cachedKey,
+		     Window          frame,
+		     CompWindow      *w)
     {
-	CompWindow* const w(*i);
-	if (w->priv->serverFrame == id)
+	if (cachedKey == frame)
+	    return;
+
+	if (cachedKey)
 	{
-	    if (w->overrideRedirect () && !override_redirect)
-		return NULL;
-	    else
-		return w;
+	    CompWindow::Map::iterator it = cache.find (cachedKey);
+
+	    if (it != cache.end () && it->second == w)
+		cache.erase (it);
+	}
+
+	cache[frame] = w;
+	cachedKey = frame;
+    }
+
+    void uncacheFrame (CompWindow::Map &cache,
+		       Window          &cachedKey,
+		       CompWindow      *w)
+    {
+	if (!cachedKey)
+	    return;
+
+	CompWindow::Map::iterator it = cache.find (cachedKey);
+
+	if (it != cache.end () && it->second == w)
+	    cache.erase (it);
+
+	cachedKey = None;
+    }
+
+    CompWindow * lookupFrame (CompWindow::Map &cache, Window frame)
+    {
+	CompWindow::Map::iterator it = cache.find (frame);
+
+	return it != cache.end () ? it->second : NULL;
+    }
+}
+
+CompWindow *
+cps::WindowManager::findWindowWithServerFrame (Window frame) const
+{
+    /* Entries are dropped when their window leaves the stack,
+     * so the pointer is safe to look at */
+    CompWindow *w = frame ? lookupFrame (serverFrameWindows, frame) : NULL;
+
+    if (w && w->priv->inStack && w->priv->serverFrame == frame)
+	return w;
+
+    foreach (CompWindow *sw, windows)
+    {
+	if (sw->priv->serverFrame == frame)
+	{
+	    if (frame)
+		cacheFrame (serverFrameWindows, sw->priv->cachedServerFrame,
+			    frame, sw);
+	    return sw;
+	}
+    }
+
+    return NULL;
+}
+
+/* The window in the stack aboveId is the id or the frame of */
+CompWindow *
+cps::WindowManager::findStackSibling (Window aboveId) const
+{
+    CompWindow *w = findWindow (aboveId);
+
+    if (w && w->priv->inStack)
+	return w;
+
+    w = lookupFrame (frameWindows, aboveId);
+
+    if (w && w->priv->inStack && w->priv->frame == aboveId)
+	return w;
+
+    foreach (CompWindow *sw, windows)
+    {
+	if (sw->priv->frame && sw->priv->frame == aboveId)
+	{
+	    cacheFrame (frameWindows, sw->priv->cachedFrame, aboveId, sw);
+	    return sw;
+	}
+    }
+
+    return NULL;
+}
+
+/* Same for the server side stack */
+CompWindow *
+cps::WindowManager::findServerStackSibling (Window aboveId) const
+{
+    CompWindow *w = findWindow (aboveId);
+
+    if (w && w->priv->inServerStack && w->priv->serverId == aboveId)
+	return w;
+
+    w = lookupFrame (serverFrameWindows, aboveId);
+
+    if (w && w->priv->inServerStack && w->priv->serverFrame == aboveId)
+	return w;
+
+    foreach (CompWindow *sw, serverWindows)
+    {
+	if (sw->priv->serverId == aboveId ||
+	    (sw->priv->serverFrame && sw->priv->serverFrame == aboveId))
+	{
+	    if (sw->priv->serverFrame == aboveId)
+		cacheFrame (serverFrameWindows, sw->priv->cachedServerFrame,
+			    aboveId, sw);
+	    return sw;
 	}
     }
 
     return NULL;
 }
 
+void
+cps::WindowManager::forgetFrames (CompWindow *w) const
+{
+    uncacheFrame (frameWindows, w->priv->cachedFrame, w);
+    uncacheFrame (serverFrameWindows, w->priv->cachedServerFrame, w);
+}
+
 void
 CompScreenImpl::insertWindow (CompWindow *w, Window	aboveId)
 {
@@ -2858,25 +3048,17 @@ cps::WindowManager::insertWindow (CompWindow* w, Window aboveId)
 	    w->next = windows.front ();
 	}
 	windows.push_front (w);
+	w->priv->stackPosition = windows.begin ();
+	w->priv->inStack = true;
 
 	addWindowToMap(w);
 
 	return;
     }
 
-    CompWindowList::iterator it = windows.begin ();
-
-    while (it != windows.end ())
-    {
-	if ((*it)->id () == aboveId ||
-	    ((*it)->priv->frame && (*it)->priv->frame == aboveId))
-	{
-	    break;
-	}
-	++it;
-    }
+    CompWindow *above = findStackSibling (aboveId);
 
-    if (it == windows.end ())
+    if (!above)
     {
 	compLogMessage ("core", CompLogLevelDebug, "could not insert 0x%x above 0x%x",
 			(unsigned int) w->priv->serverId, aboveId);
@@ -2886,16 +3068,19 @@ cps::WindowManager::insertWindow (CompWindow* w, Window aboveId)
 	return;
     }
 
-    w->next = (*it)->next;
-    w->prev = (*it);
-    (*it)->next = w;
+    CompWindowList::iterator it = above->priv->stackPosition;
+
+    w->next = above->next;
+    w->prev = above;
+    above->next = w;
 
     if (w->next)
     {
 	w->next->prev = w;
     }
 
-    windows.insert (++it, w);
+    w->priv->stackPosition = windows.insert (++it, w);
+    w->priv->inStack = true;
     addWindowToMap(w);
 }
 
@@ -2924,23 +3109,15 @@ cps::WindowManager::insertServerWindow(CompWindow* w, Window aboveId)
 	    w->serverNext = serverWindows.front ();
 	}
 	serverWindows.push_front (w);
+	w->priv->serverStackPosition = serverWindows.begin ();
+	w->priv->inServerStack = true;
 
 	return;
     }
 
-    CompWindowList::iterator it = serverWindows.begin ();
-
-    while (it != serverWindows.end ())
-    {
-	if ((*it)->priv->serverId == aboveId ||
-	    ((*it)->priv->serverFrame && (*it)->priv->serverFrame == aboveId))
-	{
-	    break;
-	}
-	++it;
-    }
+    CompWindow *above = findServerStackSibling (aboveId);
 
-    if (it == serverWindows.end ())
+    if (!above)
     {
 	compLogMessage ("core", CompLogLevelWarn, "could not insert 0x%x above 0x%x",
 			(unsigned int) w->priv->serverId, aboveId);
@@ -2950,16 +3127,19 @@ cps::WindowManager::insertServerWindow(CompWindow* w, Window aboveId)
 	return;
     }
 
-    w->serverNext = (*it)->serverNext;
-    w->serverPrev = (*it);
-    (*it)->serverNext = w;
+    CompWindowList::iterator it = above->priv->serverStackPosition;
+
+    w->serverNext = above->serverNext;
+    w->serverPrev = above;
+    above->serverNext = w;
 
     if (w->serverNext)
     {
 	w->serverNext->serverPrev = w;
     }
 
-    serverWindows.insert (++it, w);
+    w->priv->serverStackPosition = serverWindows.insert (++it, w);
+    w->priv->inServerStack = true;
 }
 
 void
@@ -2983,16 +3163,18 @@ cps::WindowManager::unhookWindow(CompWindow* w)
     if (dbg)
 	dbg->windowsChanged (true);
 
-    CompWindowList::iterator it =
-	std::find (windows.begin(), windows.end(), w);
+    /* Also when it is not in the stack, it may still be cached
+     * from the server stack and is about to be deleted */
+    forgetFrames (w);
 
-    if (it == windows.end())
+    if (!w->priv->inStack)
     {
 	compLogMessage ("core", CompLogLevelWarn, "a broken plugin tried to remove a window twice, we won't allow that!");
 	return;
     }
 
-    windows.erase (it);
+    windows.erase (w->priv->stackPosition);
+    w->priv->inStack = false;
     eraseWindowFromMap (w->id ());
 
     if (w->next)
@@ -3021,16 +3203,16 @@ cps::WindowManager::unhookServerWindow (CompWindow *w)
     if (dbg)
 	dbg->serverWindowsChanged (true);
 
-    CompWindowList::iterator it =
-	std::find (serverWindows.begin (), serverWindows.end (), w);
+    forgetFrames (w);
 
-    if (it == serverWindows.end ())
+    if (!w->priv->inServerStack)
     {
 	compLogMessage ("core", CompLogLevelWarn, "a broken plugin tried to remove a window twice, we won't allow that!");
 	return;
     }
 
-    serverWindows.erase (it);
+    serverWindows.erase (w->priv->serverStackPosition);
+    w->priv->inServerStack = false;
 
     if (w->serverNext)
 	w->serverNext->serverPrev = w->serverPrev;
@@ -3587,16 +3769,6 @@ isClientListWindow (CompWindow *w)
     return true;
 }
 
-static void
-countClientListWindow (CompWindow *w,
-		       int        *n)
-{
-    if (isClientListWindow (w))
-    {
-	*n = *n + 1;
-    }
-}
-
 static bool
 compareMappingOrder (const CompWindow *w1,
 		     const CompWindow *w2)
@@ -3604,21 +3776,63 @@ compareMappingOrder (const CompWindow *w1,
     return w1->mapNum () < w2->mapNum ();
 }
 
+/*
+ * Sets a window list property of the root window to the ids of
+ * windows, where ids holds what it was set to last time. Mapping a
+ * window only adds it to the end of both client lists, in that
+ * case just the new ids are appended to the property.
+ */
+static void
+updateWindowListProperty (Display                *dpy,
+			  Window                 root,
+			  Atom                   property,
+			  std::vector<Window>    &ids,
+			  const CompWindowVector &windows)
+{
+    unsigned int n = windows.size ();
+    unsigned int same = 0;
+
+    while (same < n && same < ids.size () &&
+	   ids[same] == windows[same]->id ())
+	same++;
+
+    if (same == n && n == ids.size ())
+	return;
+
+    bool append = same && same == ids.size ();
+
+    ids.resize (n);
+
+    for (unsigned int i = same; i < n; i++)
+	ids[i] = windows[i]->id ();
+
+    if (append)
+	XChangeProperty (dpy, root, property,
+			 XA_WINDOW, 32, PropModeAppend,
+			 (unsigned char *) &ids[same], n - same);
+    else
+	XChangeProperty (dpy, root, property,
+			 XA_WINDOW, 32, PropModeReplace,
+			 (unsigned char *) &ids[0], n);
+}
+
 void
 cps::WindowManager::updateClientList (PrivateScreen& ps)
 {
-    bool   updateClientList = false;
-    bool   updateClientListStacking = false;
-    int	   n = 0;
+    clientListStacking.clear ();
 
-    screen->forEachWindow (boost::bind (countClientListWindow, _1, &n));
+    for (iterator i = begin(); i != end(); ++i)
+    {
+	CompWindow* const w(*i);
+	if (isClientListWindow (w))
+	    clientListStacking.push_back (w);
+    }
 
-    if (n == 0)
+    if (clientListStacking.empty ())
     {
-	if ((unsigned int) n != clientList.size ())
+	if (!clientList.empty ())
 	{
 	    clientList.clear ();
-	    clientListStacking.clear ();
 	    clientIdList.clear ();
 	    clientIdListStacking.clear ();
 
@@ -3635,23 +3849,6 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
 	return;
     }
 
-    if ((unsigned int) n != clientList.size ())
-    {
-	clientIdList.resize (n);
-	clientIdListStacking.resize (n);
-
-	updateClientList = updateClientListStacking = true;
-    }
-
-    clientListStacking.clear ();
-
-    for (iterator i = begin(); i != end(); ++i)
-    {
-	CompWindow* const w(*i);
-	if (isClientListWindow (w))
-	    clientListStacking.push_back (w);
-    }
-
     /* clear clientList and copy clientListStacking into clientList */
     clientList = clientListStacking;
 
@@ -3659,40 +3856,11 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
     sort (clientList.begin (), clientList.end (),
 	  compareMappingOrder);
 
-    /* make sure client id lists are up-to-date */
-    for (int i = 0; i < n; i++)
-    {
-	if (!updateClientList &&
-	    clientIdList[i] != clientList[i]->id ())
-	{
-	    updateClientList = true;
-	}
-
-	clientIdList[i] = clientList[i]->id ();
-    }
-    for (int i = 0; i < n; i++)
-    {
-	if (!updateClientListStacking &&
-	    clientIdListStacking[i] != clientListStacking[i]->id ())
-	{
-	    updateClientListStacking = true;
-	}
-
-	clientIdListStacking[i] = clientListStacking[i]->id ();
-    }
-
-    if (updateClientList)
-	XChangeProperty (ps.dpy, ps.rootWindow(),
-			 Atoms::clientList,
-			 XA_WINDOW, 32, PropModeReplace,
-			 (unsigned char *) &clientIdList.at (0), n);
-
-    if (updateClientListStacking)
-	XChangeProperty (ps.dpy, ps.rootWindow(),
-			 Atoms::clientListStacking,
-			 XA_WINDOW, 32, PropModeReplace,
-			 (unsigned char *) &clientIdListStacking.at (0),
-			 n);
+    updateWindowListProperty (ps.dpy, ps.rootWindow (), Atoms::clientList,
+			      clientIdList, clientList);
+    updateWindowListProperty (ps.dpy, ps.rootWindow (),
+			      Atoms::clientListStacking,
+			      clientIdListStacking, clientListStacking);
 }
 
 const CompWindowVector &
@@ -5323,6 +5491,7 @@ PrivateScreen::PrivateScreen (CompScreen *screen, cps::WindowManager& windowMana
 	screenEdge[i].count = 0;
     }
 
+    memset (coalesced, 0, sizeof coalesced);
 }
 
 cps::History::History() :
@@ -5337,6 +5506,8 @@ cps::WindowManager::WindowManager() :
     serverWindows (),
     destroyedWindows (),
     stackIsFresh (false),
+    frameWindows (),
+    serverFrameWindows (),
     groups (0),
     pendingDestroys (0),
     lastFoundWindow(0)
@@ -27,7 +27,8 @@
 #define _COMPIZ_TIMEOUTHANDLER_H
 
 #include <boost/noncopyable.hpp>
-#include <list>
+#include <glib.h>
+#include <map>
 
 class PrivateTimeoutHandler;
 class CompTimer;
@@ -36,13 +37,29 @@ class TimeoutHandler : boost::noncopyable
 {
     public:
 
+	/**
+	 * Active timers keyed and ordered by their minimum deadline in
+	 * monotonic microseconds. Timers with the same deadline keep the
+	 * order in which they were added.
+	 */
+	typedef std::multimap <gint64, CompTimer *> Timers;
+
 	TimeoutHandler ();
 	~TimeoutHandler ();
 
+	/**
+	 * Queues a timer, O(log n). If another timer already expires
+	 * inside the [min, max] window of this one, this timer's minimum
+	 * deadline is moved onto it so that both are dispatched together.
+	 */
 	void addTimer (CompTimer *timer);
+
+	/**
+	 * Removes a queued timer through the handle stored in it, O(1).
+	 */
 	void removeTimer (CompTimer *timer);
 
-	std::list <CompTimer *>  & timers ();
+	Timers & timers ();
 
 	static TimeoutHandler *
 	Default ();
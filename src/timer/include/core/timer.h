@@ -139,6 +139,7 @@ class CompTimer {
 
 	PrivateTimer *priv;
 
+    friend class TimeoutHandler;
 };
 
 #endif
@@ -31,6 +31,6 @@
 class PrivateTimeoutHandler
 {
     public:
-	std::list <CompTimer *> mTimers;
+	TimeoutHandler::Timers mTimers;
 };
 #endif
@@ -24,6 +24,7 @@
  */
 
 #include <core/timer.h>
+#include <core/timeouthandler.h>
 
 #ifndef _PRIVATETIMER_H
 #define _PRIVATETIMER_H
@@ -41,6 +42,11 @@ class PrivateTimer
 	gint64                   mMinDeadline;
 	gint64                   mMaxDeadline;
 	CompTimer::CallBack      mCallBack;
+
+	/* Position in the TimeoutHandler that queued this timer,
+	 * only valid while mQueuedIn is set */
+	TimeoutHandler           *mQueuedIn;
+	TimeoutHandler::Timers::iterator mHandle;
 };
 
 #endif
@@ -25,10 +25,10 @@
  */
 
 #include "privatetimeouthandler.h"
+#include "privatetimer.h"
 #include "core/timer.h"
 
 #include <boost/scoped_ptr.hpp>
-#include <algorithm>
 
 namespace
 {
@@ -42,44 +42,49 @@ TimeoutHandler::TimeoutHandler () :
 
 TimeoutHandler::~TimeoutHandler ()
 {
+    /* Timers outliving us must not keep handles into our map */
+    for (Timers::iterator it = priv->mTimers.begin ();
+	 it != priv->mTimers.end (); ++it)
+	it->second->priv->mQueuedIn = NULL;
+
     delete priv;
 }
 
 void
 TimeoutHandler::addTimer (CompTimer *timer)
 {
-    std::list<CompTimer *>::iterator it;
-
-    it = std::find (priv->mTimers.begin (), priv->mTimers.end (), timer);
+    PrivateTimer *t = timer->priv;
 
-    if (it != priv->mTimers.end ())
+    if (t->mQueuedIn == this)
 	return;
-
-    for (it = priv->mTimers.begin (); it != priv->mTimers.end (); ++it)
-    {
-	if (timer->minTime () < (*it)->minLeft ())
-	    break;
-    }
+    else if (t->mQueuedIn)
+	t->mQueuedIn->removeTimer (timer);
 
     timer->setExpiryTimes (timer->minTime (), timer->maxTime ());
 
-    priv->mTimers.insert (it, timer);
+    /* Coalesce with the first queued timer that is due inside our window */
+    Timers::iterator it = priv->mTimers.lower_bound (t->mMinDeadline);
+
+    if (it != priv->mTimers.end () && it->first <= t->mMaxDeadline)
+	t->mMinDeadline = it->first;
+
+    t->mHandle = priv->mTimers.insert (std::make_pair (t->mMinDeadline, timer));
+    t->mQueuedIn = this;
 }
 
 void
 TimeoutHandler::removeTimer (CompTimer *timer)
 {
-    std::list<CompTimer *>::iterator it;
-
-    it = std::find (priv->mTimers.begin (), priv->mTimers.end (), timer);
+    PrivateTimer *t = timer->priv;
 
-    if (it == priv->mTimers.end ())
+    if (t->mQueuedIn != this)
 	return;
 
-    priv->mTimers.erase (it);
+    priv->mTimers.erase (t->mHandle);
+    t->mQueuedIn = NULL;
 }
 
-std::list <CompTimer *> &
+TimeoutHandler::Timers &
 TimeoutHandler::timers ()
 {
     return priv->mTimers;
@@ -26,6 +26,7 @@
 
 #include <boost/foreach.hpp>
 #include <cmath>
+#include <list>
 
 #include "privatetimeoutsource.h"
 #include "privatetimer.h"
@@ -100,15 +101,15 @@ CompTimeoutSource::prepare (int &timeout)
 	return true;
     }
 
-    if (TimeoutHandler::Default ()->timers ().front ()->minLeft () > 0)
+    if (TimeoutHandler::Default ()->timers ().begin ()->second->minLeft () > 0)
     {
-	std::list<CompTimer *>::iterator it = TimeoutHandler::Default ()->timers ().begin ();
+	TimeoutHandler::Timers::iterator it = TimeoutHandler::Default ()->timers ().begin ();
 
-	CompTimer *t = (*it);
+	CompTimer *t = it->second;
 	timeout = t->maxLeft ();
 	while (it != TimeoutHandler::Default ()->timers ().end ())
 	{
-	    t = (*it);
+	    t = it->second;
 	    if (t->minLeft () >= (unsigned int) timeout)
 		break;
 	    if (t->maxLeft () < (unsigned int) timeout)
@@ -128,7 +129,7 @@ bool
 CompTimeoutSource::check ()
 {
     return (!TimeoutHandler::Default ()->timers ().empty () &&
-	     TimeoutHandler::Default ()->timers ().front ()->minLeft () <= 0);
+	     TimeoutHandler::Default ()->timers ().begin ()->second->minLeft () <= 0);
 }
 
 bool
@@ -142,14 +143,15 @@ bool
 CompTimeoutSource::callback ()
 {
     TimeoutHandler *handler = TimeoutHandler::Default ();
-    std::list<CompTimer*> requeue, &timers = handler->timers ();
+    TimeoutHandler::Timers &timers = handler->timers ();
+    std::list<CompTimer*> requeue;
 
     while (!timers.empty ())
     {
-	CompTimer *t = timers.front ();
+	CompTimer *t = timers.begin ()->second;
 	if (t->minLeft () > 0)
 	    break;
-	timers.pop_front ();
+	handler->removeTimer (t);
 	t->setActive (false);
 	if (t->triggerCallback ())
 	    requeue.push_back (t);
@@ -172,7 +174,8 @@ PrivateTimer::PrivateTimer () :
     mMaxTime (0),
     mMinDeadline (0),
     mMaxDeadline (0),
-    mCallBack (NULL)
+    mCallBack (NULL),
+    mQueuedIn (NULL)
 {
 }
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/*
+ * Restarts a set of queued timers with random timeouts, the way
+ * animation, ping and paint timers get restarted all the time, and
+ * prints the cost of one stop/start cycle for various queue sizes.
+ */
+
+#include <core/timer.h>
+#include <core/timeouthandler.h>
+
+#include <boost/bind.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+    const unsigned int restarts = 100000;
+
+    bool
+    callback ()
+    {
+	return false;
+    }
+}
+
+int
+main ()
+{
+    const unsigned int counts[] = { 10, 100, 1000, 10000 };
+
+    TimeoutHandler::SetDefault (new TimeoutHandler ());
+
+    printf ("%8s %20s\n", "timers", "restart (ns)");
+
+    for (unsigned int c = 0; c < sizeof (counts) / sizeof (counts[0]); c++)
+    {
+	std::vector <CompTimer *> timers;
+
+	srand (counts[c]);
+	for (unsigned int i = 0; i < counts[c]; i++)
+	{
+	    CompTimer *t = new CompTimer ();
+	    unsigned int min = rand () % 1000;
+
+	    t->start (boost::bind (callback), min, min + rand () % 50);
+	    timers.push_back (t);
+	}
+
+	gint64 start = g_get_monotonic_time ();
+
+	for (unsigned int i = 0; i < restarts; i++)
+	{
+	    CompTimer *t = timers[rand () % timers.size ()];
+	    unsigned int min = rand () % 1000;
+
+	    t->start (min, min + rand () % 50);
+	}
+
+	gint64 elapsed = g_get_monotonic_time () - start;
+
+	printf ("%8u %20.1f\n", counts[c], elapsed * 1000.0 / restarts);
+
+	for (unsigned int i = 0; i < timers.size (); i++)
+	    delete timers[i];
+    }
+
+    TimeoutHandler::SetDefault (NULL);
+
+    return 0;
+}
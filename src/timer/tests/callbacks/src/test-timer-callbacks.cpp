@@ -152,30 +152,30 @@ protected:
 	/* TimeoutHandler::timers should have the timer that
 	 * is going to trigger first at the front of the
 	 * list and the last timer at the back */
-	if (TimeoutHandler::Default ()->timers ().front () != timers.back ())
+	if (TimeoutHandler::Default ()->timers ().begin ()->second != timers.back ())
 	{
 	    RecordProperty ("TimeoutHandler::Default ().size",
 		    TimeoutHandler::Default ()->timers ().size ());
 	    RecordProperty ("TimeoutHandler::Default ().front->minLeft",
-		    TimeoutHandler::Default ()->timers ().front ()->minLeft());
+		    TimeoutHandler::Default ()->timers ().begin ()->second->minLeft());
 	    RecordProperty ("TimeoutHandler::Default ().front->maxLeft",
-		    TimeoutHandler::Default ()->timers ().front ()->maxLeft());
+		    TimeoutHandler::Default ()->timers ().begin ()->second->maxLeft());
 	    RecordProperty ("TimeoutHandler::Default ().front->minTime",
-		    TimeoutHandler::Default ()->timers ().front ()->minTime());
+		    TimeoutHandler::Default ()->timers ().begin ()->second->minTime());
 	    RecordProperty ("TimeoutHandler::Default ().front->maxTime",
-		    TimeoutHandler::Default ()->timers ().front ()->maxTime());
+		    TimeoutHandler::Default ()->timers ().begin ()->second->maxTime());
 	    RecordProperty ("TimeoutHandler::Default ().back->minLeft",
-		    TimeoutHandler::Default ()->timers ().back ()->minLeft());
+		    TimeoutHandler::Default ()->timers ().rbegin ()->second->minLeft());
 	    RecordProperty ("TimeoutHandler::Default ().back->maxLeft",
-		    TimeoutHandler::Default ()->timers ().back ()->maxLeft());
+		    TimeoutHandler::Default ()->timers ().rbegin ()->second->maxLeft());
 	    RecordProperty ("TimeoutHandler::Default ().back->minTime",
-		    TimeoutHandler::Default ()->timers ().back ()->minTime());
+		    TimeoutHandler::Default ()->timers ().rbegin ()->second->minTime());
 	    RecordProperty ("TimeoutHandler::Default ().back->maxTime",
-		    TimeoutHandler::Default ()->timers ().back ()->maxTime());
+		    TimeoutHandler::Default ()->timers ().rbegin ()->second->maxTime());
 	    FAIL () << "timer with the least time is not at the front";
 	}
 
-	if (TimeoutHandler::Default ()->timers ().back () != timers.front ())
+	if (TimeoutHandler::Default ()->timers ().rbegin ()->second != timers.front ())
 	{
 	    FAIL () << "timer with the most time is not at the back";
 	}
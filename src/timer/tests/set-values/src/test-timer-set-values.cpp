@@ -47,3 +47,55 @@ TEST_F(CompTimerTest, TimerSetValues)
 
     delete t1;
 }
+
+namespace
+{
+    bool dummyCallback ()
+    {
+	return false;
+    }
+}
+
+TEST_F(CompTimerTest, TimerCoalescesInsideWindow)
+{
+    CompTimer *t1 = new CompTimer ();
+    CompTimer *t2 = new CompTimer ();
+    CompTimer *t3 = new CompTimer ();
+
+    timers.push_back (t1);
+    timers.push_back (t2);
+    timers.push_back (t3);
+
+    t1->start (boost::bind (dummyCallback), 100, 100);
+
+    /* Due at 100ms at the latest, so it fires together with t1 */
+    t2->start (boost::bind (dummyCallback), 50, 200);
+
+    /* t1 is outside of this one's window */
+    t3->start (boost::bind (dummyCallback), 10, 20);
+
+    TimeoutHandler::Timers &queued = TimeoutHandler::Default ()->timers ();
+    ASSERT_EQ (3, queued.size ());
+
+    TimeoutHandler::Timers::iterator it = queued.begin ();
+    EXPECT_EQ (t3, it->second);
+    ++it;
+    EXPECT_EQ (t1, it->second);
+    gint64 t1Deadline = it->first;
+    ++it;
+    EXPECT_EQ (t2, it->second);
+    EXPECT_EQ (t1Deadline, it->first);
+
+    EXPECT_GE (t2->minLeft (), 50);
+    EXPECT_LE (t2->minLeft (), 100);
+
+    t2->stop ();
+    EXPECT_FALSE (t2->active ());
+    EXPECT_EQ (2, queued.size ());
+    EXPECT_EQ (t3, queued.begin ()->second);
+    EXPECT_EQ (t1, queued.rbegin ()->second);
+
+    /* Stopping twice is harmless */
+    t2->stop ();
+    EXPECT_EQ (2, queued.size ());
+}
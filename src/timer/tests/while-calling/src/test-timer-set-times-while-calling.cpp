@@ -48,11 +48,11 @@ protected:
 
     void recordTimers ()
     {
-	for (std::list<CompTimer *>::iterator it =
+	for (TimeoutHandler::Timers::iterator it =
 		TimeoutHandler::Default()->timers().begin();
         	it != TimeoutHandler::Default()->timers().end(); ++it)
 	{
-	    CompTimer *t = (*it);
+	    CompTimer *t = it->second;
 	    RecordProperty("minLeft", t->minLeft());
 	    RecordProperty("maxLeft", t->maxLeft());
 	    RecordProperty("minTime", t->minTime());
@@ -75,7 +75,7 @@ protected:
 	    recordTimers();
 
 	    /* Check if it is now at the back of the timeout list */
-	    ASSERT_EQ( TimeoutHandler::Default()->timers().back(), t2 );
+	    ASSERT_EQ( TimeoutHandler::Default()->timers().rbegin()->second, t2 );
 	}
 	else if (mlastTimerTriggered == 1 && timernum == 2)
 	{
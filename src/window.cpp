@@ -41,11 +41,15 @@
 #include <core/icon.h>
 #include <core/atoms.h>
 #include "core/windowconstrainment.h"
+#include "core/windowproperties.h"
 #include "privatewindow.h"
 #include "privatescreen.h"
 #include "privatestackdebugger.h"
 
 #include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+
+namespace cwp = compiz::window::properties;
 
 template class WrapableInterface<CompWindow, WindowInterface>;
 
@@ -226,8 +230,8 @@ PrivateWindow::updateNormalHints ()
     Status status;
     long   supplied;
 
-    status = XGetWMNormalHints (screen->dpy (), priv->id,
-				&priv->sizeHints, &supplied);
+    status = cwp::getWMNormalHints (screen->dpy (), priv->id,
+				    &priv->sizeHints, &supplied);
 
     if (!status)
 	priv->sizeHints.flags = 0;
@@ -247,7 +251,7 @@ PrivateWindow::updateWmHints ()
 
     inputHint = true;
 
-    newHints = XGetWMHints (screen->dpy (), id);
+    newHints = cwp::getWMHints (screen->dpy (), id);
     if (newHints)
     {
 	dFlags ^= newHints->flags;
@@ -299,8 +303,8 @@ PrivateWindow::updateClassHints ()
 	priv->resClass = NULL;
     }
 
-    status = XGetClassHint (screen->dpy (),
-			    priv->id, &classHint);
+    status = cwp::getClassHint (screen->dpy (),
+				priv->id, &classHint);
     if (status)
     {
 	if (classHint.res_name)
@@ -325,8 +329,8 @@ PrivateWindow::updateTransientHint ()
 
     priv->transientFor = None;
 
-    status = XGetTransientForHint (screen->dpy (),
-				   priv->id, &transientFor);
+    status = cwp::getTransientForHint (screen->dpy (),
+				       priv->id, &transientFor);
 
     if (status)
     {
@@ -402,10 +406,10 @@ PrivateWindow::getClientLeader ()
     unsigned long n, left;
     unsigned char *data;
 
-    result = XGetWindowProperty (screen->dpy (), priv->id,
-				 Atoms::wmClientLeader,
-				 0L, 1L, False, XA_WINDOW, &actual, &format,
-				 &n, &left, &data);
+    result = cwp::getWindowProperty (screen->dpy (), priv->id,
+				      Atoms::wmClientLeader,
+				      0L, 1L, False, XA_WINDOW, &actual, &format,
+				      &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -431,12 +435,12 @@ PrivateWindow::getStartupId ()
     unsigned long n, left;
     unsigned char *data;
 
-    result = XGetWindowProperty (screen->dpy (), priv->id,
-				 Atoms::startupId,
-				 0L, 1024L, False,
-				 Atoms::utf8String,
-				 &actual, &format,
-				 &n, &left, &data);
+    result = cwp::getWindowProperty (screen->dpy (), priv->id,
+				      Atoms::startupId,
+				      0L, 1024L, False,
+				      Atoms::utf8String,
+				      &actual, &format,
+				      &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -452,6 +456,37 @@ PrivateWindow::getStartupId ()
     return NULL;
 }
 
+/* Properties read while a window is being added, see CompWindow::CompWindow */
+std::vector<Atom>
+PrivateWindow::initialProperties ()
+{
+    std::vector<Atom> properties;
+
+    if (attrib.c_class != InputOnly)
+    {
+	properties.push_back (Atoms::winState);
+	properties.push_back (XA_WM_CLASS);
+    }
+
+    properties.push_back (Atoms::winType);
+    properties.push_back (Atoms::wmProtocols);
+
+    if (!attrib.override_redirect)
+    {
+	properties.push_back (XA_WM_NORMAL_HINTS);
+	properties.push_back (Atoms::wmStrutPartial);
+	properties.push_back (Atoms::wmStrut);
+	properties.push_back (XA_WM_HINTS);
+	properties.push_back (XA_WM_TRANSIENT_FOR);
+	properties.push_back (Atoms::wmClientLeader);
+	properties.push_back (Atoms::startupId);
+	properties.push_back (Atoms::mwmHints);
+	properties.push_back (Atoms::winDesktop);
+    }
+
+    return properties;
+}
+
 void
 PrivateWindow::setFullscreenMonitors (CompFullscreenMonitorSet *monitors)
 {
@@ -997,10 +1032,10 @@ CompWindow::updateStruts ()
     newStrut.bottom.width  = screen->width ();
     newStrut.bottom.height = 0;
 
-    result = XGetWindowProperty (screen->dpy (), priv->id,
-				 Atoms::wmStrutPartial,
-				 0L, 12L, false, XA_CARDINAL, &actual, &format,
-				 &n, &left, &data);
+    result = cwp::getWindowProperty (screen->dpy (), priv->id,
+				      Atoms::wmStrutPartial,
+				      0L, 12L, false, XA_CARDINAL, &actual, &format,
+				      &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1034,10 +1069,10 @@ CompWindow::updateStruts ()
 
     if (!hasNew)
     {
-	result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::wmStrut,
-				     0L, 4L, false, XA_CARDINAL,
-				     &actual, &format, &n, &left, &data);
+	result = cwp::getWindowProperty (screen->dpy (), priv->id,
+					  Atoms::wmStrut,
+					  0L, 4L, false, XA_CARDINAL,
+					  &actual, &format, &n, &left, &data);
 
 	if (result == Success && data)
 	{
@@ -6001,6 +6036,12 @@ PrivateWindow::createCompWindow (Window aboveId, Window aboveServerId, XWindowAt
     return fw;
 }
 
+CompWindow *
+PrivateWindow::createStandIn (PrivateWindow *priv)
+{
+    return new CompWindow (priv);
+}
+
 
 CompWindow::CompWindow (Window aboveId,
 			Window aboveServerId,
@@ -6045,6 +6086,14 @@ CompWindow::CompWindow (Window aboveId,
 		  EnterWindowMask    |
 		  FocusChangeMask);
 
+    /* Request all the properties read below up front, so that adding
+     * a window costs one round trip instead of one per property. This
+     * happens after selecting PropertyChangeMask so that no change can
+     * be missed */
+    cwp::XcbFetcher                  fetcher (screen->dpy ());
+    boost::scoped_ptr<cwp::Prefetch> prefetch (
+	new cwp::Prefetch (&fetcher, priv->id, priv->initialProperties ()));
+
     priv->alpha     = (priv->attrib.depth == 32);
     priv->lastPong  = screen->lastPing ();
 
@@ -6099,6 +6148,9 @@ CompWindow::CompWindow (Window aboveId,
 	recalcType ();
     }
 
+    /* The window properties are written from here on */
+    prefetch.reset ();
+
     if (priv->attrib.map_state == IsViewable)
     {
 	priv->placed = true;
@@ -6195,6 +6247,18 @@ CompWindow::CompWindow (Window aboveId,
     }
 }
 
+CompWindow::CompWindow (PrivateWindow *priv) :
+    PluginClassStorage (windowPluginClassIndices),
+    next (NULL),
+    prev (NULL),
+    serverNext (NULL),
+    serverPrev (NULL),
+    isDeepinLauncher (false),
+    priv (priv)
+{
+    priv->window = this;
+}
+
 CompWindow::~CompWindow ()
 {
     if (priv->serverFrame)
@@ -6343,7 +6407,13 @@ PrivateWindow::PrivateWindow () :
 
     syncWait (false),
     closeRequests (false),
-    lastCloseRequestTime (0)
+    lastCloseRequestTime (0),
+    stackPosition (),
+    serverStackPosition (),
+    inStack (false),
+    inServerStack (false),
+    cachedFrame (None),
+    cachedServerFrame (None)
 {
     input.left   = 0;
     input.right  = 0;
@@ -0,0 +1,185 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _COMPWINDOWPROPERTIES_H
+#define _COMPWINDOWPROPERTIES_H
+
+#include <vector>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+namespace compiz
+{
+namespace window
+{
+namespace properties
+{
+
+/**
+ * The contents of a single window property, laid out the way
+ * XGetWindowProperty returns them (format 32 items are stored as
+ * longs). A reply which is not valid could not be fetched and will
+ * be read from the server again.
+ */
+class Reply
+{
+    public:
+
+	Reply ();
+
+	bool			    valid;
+	Atom			    type;
+	int			    format;
+	unsigned long		    nItems;
+	unsigned long		    bytesAfter;
+	std::vector <unsigned char> data;
+};
+
+class FetcherInterface
+{
+    public:
+
+	virtual ~FetcherInterface () {}
+
+	/**
+	 * Fetches the first length 32 bit units of each property of
+	 * the window id, in order, into replies. All requests should be
+	 * issued before waiting for the first reply.
+	 */
+	virtual void fetch (Window		      id,
+			    const std::vector <Atom> &properties,
+			    long		      length,
+			    std::vector <Reply>      &replies) = 0;
+};
+
+/**
+ * Fetches properties of a window over the XCB connection underlying
+ * the Xlib display, costing one round trip for the whole batch.
+ */
+class XcbFetcher :
+    public FetcherInterface
+{
+    public:
+
+	XcbFetcher (Display *dpy);
+
+	void fetch (Window		     id,
+		    const std::vector <Atom> &properties,
+		    long		     length,
+		    std::vector <Reply>	     &replies);
+
+    private:
+
+	Display *mDpy;
+};
+
+/**
+ * Fetches a set of properties of a window up front and serves
+ * getWindowProperty and the hint readers below from those replies
+ * for as long as it is in scope. Reads of other windows or
+ * properties, or of more data than was fetched, go to the server.
+ */
+class Prefetch
+{
+    public:
+
+	static const long DefaultLength = 1024;
+
+	Prefetch (FetcherInterface	   *fetcher,
+		  Window		   id,
+		  const std::vector <Atom> &properties,
+		  long			   length = DefaultLength);
+	~Prefetch ();
+
+	/**
+	 * Emulates XGetWindowProperty from the fetched replies,
+	 * returns false if the request can't be served from them.
+	 */
+	bool read (Window	 id,
+		   Atom		 property,
+		   long		 offset,
+		   long		 length,
+		   Atom		 type,
+		   Atom		 *actualType,
+		   int		 *actualFormat,
+		   unsigned long *nItems,
+		   unsigned long *bytesAfter,
+		   unsigned char **data) const;
+
+	static const Prefetch * active ();
+
+    private:
+
+	Window		    mId;
+	std::vector <Atom>  mProperties;
+	std::vector <Reply> mReplies;
+	Prefetch	    *mPrevious;
+
+	static Prefetch *current;
+};
+
+/**
+ * Drop-in replacements for the Xlib calls of the same names which
+ * are served from the active Prefetch when possible.
+ */
+int getWindowProperty (Display	     *dpy,
+		       Window	     id,
+		       Atom	     property,
+		       long	     offset,
+		       long	     length,
+		       Bool	     deleteProperty,
+		       Atom	     type,
+		       Atom	     *actualType,
+		       int	     *actualFormat,
+		       unsigned long *nItems,
+		       unsigned long *bytesAfter,
+		       unsigned char **data);
+
+Status getWMNormalHints (Display    *dpy,
+			 Window     id,
+			 XSizeHints *hints,
+			 long	    *supplied);
+
+XWMHints * getWMHints (Display *dpy,
+		       Window  id);
+
+Status getClassHint (Display	*dpy,
+		     Window	id,
+		     XClassHint *classHint);
+
+Status getTransientForHint (Display *dpy,
+			    Window  id,
+			    Window  *transientFor);
+
+Status getWMProtocols (Display *dpy,
+		       Window  id,
+		       Atom    wmProtocols,
+		       Atom    **protocols,
+		       int     *count);
+
+}
+}
+}
+
+#endif
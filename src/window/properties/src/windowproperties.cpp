@@ -0,0 +1,487 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
+
+#include <core/windowproperties.h>
+
+namespace cwp = compiz::window::properties;
+
+namespace
+{
+/* Lengths of WM_NORMAL_HINTS and WM_HINTS in 32 bit units, as
+ * defined by the ICCCM */
+const long NumSizeHintsElements    = 18;
+const long OldNumSizeHintsElements = 15;
+const long NumWMHintsElements	   = 9;
+
+/* Size of a format 8, 16 or 32 item in the client side data */
+size_t
+itemSize (int format)
+{
+    switch (format)
+    {
+	case 32:
+	    return sizeof (long);
+	case 16:
+	    return sizeof (short);
+	default:
+	    return 1;
+    }
+}
+}
+
+const long cwp::Prefetch::DefaultLength;
+
+cwp::Prefetch *cwp::Prefetch::current = NULL;
+
+cwp::Reply::Reply () :
+    valid (false),
+    type (None),
+    format (0),
+    nItems (0),
+    bytesAfter (0)
+{
+}
+
+cwp::XcbFetcher::XcbFetcher (Display *dpy) :
+    mDpy (dpy)
+{
+}
+
+void
+cwp::XcbFetcher::fetch (Window			 id,
+			const std::vector <Atom> &properties,
+			long			 length,
+			std::vector <Reply>	 &replies)
+{
+    xcb_connection_t			    *c = XGetXCBConnection (mDpy);
+    std::vector <xcb_get_property_cookie_t> cookies (properties.size ());
+
+    for (unsigned int i = 0; i < properties.size (); ++i)
+	cookies[i] = xcb_get_property (c, 0, id, properties[i],
+				       XCB_GET_PROPERTY_TYPE_ANY, 0, length);
+
+    replies.clear ();
+    replies.resize (properties.size ());
+
+    for (unsigned int i = 0; i < properties.size (); ++i)
+    {
+	xcb_generic_error_t	 *error = NULL;
+	xcb_get_property_reply_t *reply;
+	Reply			 &r = replies[i];
+
+	reply = xcb_get_property_reply (c, cookies[i], &error);
+
+	/* Errors are left for the fallback XGetWindowProperty to
+	 * report through the usual error handler */
+	if (!reply)
+	{
+	    free (error);
+	    continue;
+	}
+
+	r.valid      = true;
+	r.type       = reply->type;
+	r.format     = reply->format;
+	r.bytesAfter = reply->bytes_after;
+
+	if (r.type != None && r.format)
+	{
+	    const unsigned char *value =
+		(const unsigned char *) xcb_get_property_value (reply);
+
+	    r.nItems = xcb_get_property_value_length (reply) / (r.format / 8);
+	    r.data.resize (r.nItems * itemSize (r.format));
+
+	    /* Xlib hands out format 32 data as sign extended longs */
+	    if (r.format == 32)
+	    {
+		long *items = (long *) &r.data[0];
+
+		for (unsigned long j = 0; j < r.nItems; ++j)
+		    items[j] = ((const int32_t *) value)[j];
+	    }
+	    else if (r.nItems)
+	    {
+		memcpy (&r.data[0], value, r.data.size ());
+	    }
+	}
+
+	free (reply);
+    }
+}
+
+cwp::Prefetch::Prefetch (FetcherInterface	  *fetcher,
+			 Window			  id,
+			 const std::vector <Atom> &properties,
+			 long			  length) :
+    mId (id),
+    mProperties (properties),
+    mPrevious (current)
+{
+    fetcher->fetch (id, properties, length, mReplies);
+    current = this;
+}
+
+cwp::Prefetch::~Prefetch ()
+{
+    current = mPrevious;
+}
+
+const cwp::Prefetch *
+cwp::Prefetch::active ()
+{
+    return current;
+}
+
+bool
+cwp::Prefetch::read (Window	   id,
+		     Atom	   property,
+		     long	   offset,
+		     long	   length,
+		     Atom	   type,
+		     Atom	   *actualType,
+		     int	   *actualFormat,
+		     unsigned long *nItems,
+		     unsigned long *bytesAfter,
+		     unsigned char **data) const
+{
+    if (id != mId)
+	return mPrevious && mPrevious->read (id, property, offset, length,
+					     type, actualType, actualFormat,
+					     nItems, bytesAfter, data);
+
+    unsigned int i;
+
+    for (i = 0; i < mProperties.size (); ++i)
+	if (mProperties[i] == property)
+	    break;
+
+    if (i == mReplies.size () || !mReplies[i].valid)
+	return false;
+
+    const Reply &r = mReplies[i];
+
+    *data = NULL;
+
+    if (r.type == None)
+    {
+	*actualType   = None;
+	*actualFormat = 0;
+	*nItems	      = 0;
+	*bytesAfter   = 0;
+
+	return true;
+    }
+
+    /* Everything below is in server side bytes, like the protocol */
+    unsigned long unit    = r.format / 8;
+    unsigned long fetched = r.nItems * unit;
+    unsigned long total   = fetched + r.bytesAfter;
+    unsigned long start   = 0;
+    unsigned long size	  = 0;
+    unsigned long after	  = total;
+
+    if (type == AnyPropertyType || type == r.type)
+    {
+	start = 4 * (unsigned long) offset;
+
+	/* BadValue, let the server report it */
+	if (start > total)
+	    return false;
+
+	size  = std::min (total - start, 4 * (unsigned long) length);
+	after = total - (start + size);
+
+	/* More than was prefetched */
+	if (start + size > fetched)
+	    return false;
+    }
+
+    unsigned long n	= size / unit;
+    size_t	  bytes = n * itemSize (r.format);
+
+    /* Like Xlib, always allocate and null terminate the data even if
+     * it is empty because the type didn't match */
+    *data = (unsigned char *) malloc (bytes + 1);
+    if (!*data)
+	return false;
+
+    if (bytes)
+	memcpy (*data, &r.data[(start / unit) * itemSize (r.format)], bytes);
+    (*data)[bytes] = '\0';
+
+    *actualType	  = r.type;
+    *actualFormat = r.format;
+    *nItems	  = n;
+    *bytesAfter	  = after;
+
+    return true;
+}
+
+int
+cwp::getWindowProperty (Display	      *dpy,
+			Window	      id,
+			Atom	      property,
+			long	      offset,
+			long	      length,
+			Bool	      deleteProperty,
+			Atom	      type,
+			Atom	      *actualType,
+			int	      *actualFormat,
+			unsigned long *nItems,
+			unsigned long *bytesAfter,
+			unsigned char **data)
+{
+    const Prefetch *prefetch = Prefetch::active ();
+
+    if (prefetch && !deleteProperty &&
+	prefetch->read (id, property, offset, length, type, actualType,
+			actualFormat, nItems, bytesAfter, data))
+	return Success;
+
+    return XGetWindowProperty (dpy, id, property, offset, length,
+			       deleteProperty, type, actualType,
+			       actualFormat, nItems, bytesAfter, data);
+}
+
+Status
+cwp::getWMNormalHints (Display	  *dpy,
+		       Window	  id,
+		       XSizeHints *hints,
+		       long	  *supplied)
+{
+    Atom	  actual;
+    int		  format;
+    unsigned long n, left;
+    unsigned char *data;
+
+    if (getWindowProperty (dpy, id, XA_WM_NORMAL_HINTS,
+			   0L, NumSizeHintsElements, False,
+			   XA_WM_SIZE_HINTS, &actual, &format,
+			   &n, &left, &data) != Success)
+	return 0;
+
+    if (actual != XA_WM_SIZE_HINTS || format != 32 ||
+	n < (unsigned long) OldNumSizeHintsElements)
+    {
+	XFree (data);
+	return 0;
+    }
+
+    long *prop = (long *) data;
+
+    hints->flags	= prop[0];
+    hints->x		= prop[1];
+    hints->y		= prop[2];
+    hints->width	= prop[3];
+    hints->height	= prop[4];
+    hints->min_width	= prop[5];
+    hints->min_height	= prop[6];
+    hints->max_width	= prop[7];
+    hints->max_height	= prop[8];
+    hints->width_inc	= prop[9];
+    hints->height_inc	= prop[10];
+    hints->min_aspect.x = prop[11];
+    hints->min_aspect.y = prop[12];
+    hints->max_aspect.x = prop[13];
+    hints->max_aspect.y = prop[14];
+
+    *supplied = USPosition | USSize | PAllHints;
+
+    if (n >= (unsigned long) NumSizeHintsElements)
+    {
+	hints->base_width  = prop[15];
+	hints->base_height = prop[16];
+	hints->win_gravity = prop[17];
+
+	*supplied |= PBaseSize | PWinGravity;
+    }
+
+    hints->flags &= *supplied;
+
+    XFree (data);
+
+    return 1;
+}
+
+XWMHints *
+cwp::getWMHints (Display *dpy,
+		 Window  id)
+{
+    Atom	  actual;
+    int		  format;
+    unsigned long n, left;
+    unsigned char *data;
+    XWMHints	  *hints;
+
+    if (getWindowProperty (dpy, id, XA_WM_HINTS,
+			   0L, NumWMHintsElements, False,
+			   XA_WM_HINTS, &actual, &format,
+			   &n, &left, &data) != Success)
+	return NULL;
+
+    if (actual != XA_WM_HINTS || format != 32 ||
+	n < (unsigned long) NumWMHintsElements - 1)
+    {
+	XFree (data);
+	return NULL;
+    }
+
+    hints = (XWMHints *) calloc (1, sizeof (XWMHints));
+
+    if (hints)
+    {
+	long *prop = (long *) data;
+
+	hints->flags	     = prop[0];
+	hints->input	     = prop[1] ? True : False;
+	hints->initial_state = prop[2];
+	hints->icon_pixmap   = prop[3];
+	hints->icon_window   = prop[4];
+	hints->icon_x	     = prop[5];
+	hints->icon_y	     = prop[6];
+	hints->icon_mask     = prop[7];
+
+	if (n >= (unsigned long) NumWMHintsElements)
+	    hints->window_group = prop[8];
+    }
+
+    XFree (data);
+
+    return hints;
+}
+
+Status
+cwp::getClassHint (Display    *dpy,
+		   Window     id,
+		   XClassHint *classHint)
+{
+    Atom	  actual;
+    int		  format;
+    unsigned long n, left;
+    unsigned char *data;
+
+    if (getWindowProperty (dpy, id, XA_WM_CLASS,
+			   0L, BUFSIZ, False,
+			   XA_STRING, &actual, &format,
+			   &n, &left, &data) != Success)
+	return 0;
+
+    if (actual != XA_STRING || format != 8)
+    {
+	XFree (data);
+	return 0;
+    }
+
+    /* WM_CLASS is the instance and class name, each null terminated,
+     * though the last terminator is often missing */
+    size_t nameLength = strlen ((char *) data);
+
+    if (nameLength == n)
+	nameLength--;
+
+    classHint->res_name  = strdup ((char *) data);
+    classHint->res_class = strdup ((char *) data + nameLength + 1);
+
+    XFree (data);
+
+    if (!classHint->res_name || !classHint->res_class)
+    {
+	free (classHint->res_name);
+	free (classHint->res_class);
+
+	return 0;
+    }
+
+    return 1;
+}
+
+Status
+cwp::getTransientForHint (Display *dpy,
+			  Window  id,
+			  Window  *transientFor)
+{
+    Atom	  actual;
+    int		  format;
+    unsigned long n, left;
+    unsigned char *data;
+
+    Status	  status = 0;
+
+    *transientFor = None;
+
+    if (getWindowProperty (dpy, id, XA_WM_TRANSIENT_FOR,
+			   0L, 1L, False,
+			   XA_WINDOW, &actual, &format,
+			   &n, &left, &data) != Success)
+	return 0;
+
+    if (actual == XA_WINDOW && format == 32 && n)
+    {
+	*transientFor = *((Window *) data);
+	status	      = 1;
+    }
+
+    XFree (data);
+
+    return status;
+}
+
+Status
+cwp::getWMProtocols (Display *dpy,
+		     Window  id,
+		     Atom    wmProtocols,
+		     Atom    **protocols,
+		     int     *count)
+{
+    Atom	  actual;
+    int		  format;
+    unsigned long n, left;
+    unsigned char *data;
+
+    if (getWindowProperty (dpy, id, wmProtocols,
+			   0L, 1000000L, False,
+			   XA_ATOM, &actual, &format,
+			   &n, &left, &data) != Success)
+	return 0;
+
+    if (actual != XA_ATOM || format != 32)
+    {
+	XFree (data);
+	return 0;
+    }
+
+    *protocols = (Atom *) data;
+    *count     = n;
+
+    return 1;
+}
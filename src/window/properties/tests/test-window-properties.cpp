@@ -0,0 +1,379 @@
+/*
+ * Copyright © 2012 Canonical Ltd.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Canonical Ltd. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior permission.
+ * Canonical Ltd. makes no representations about the suitability of this
+ * software for any purpose. It is provided "as is" without express or
+ * implied warranty.
+ *
+ * CANONICAL, LTD. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE,
+ * INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS, IN
+ * NO EVENT SHALL CANONICAL, LTD. BE LIABLE FOR ANY SPECIAL, INDIRECT OR
+ * CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS
+ * OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT,
+ * NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION
+ * WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <map>
+
+#include <X11/Xatom.h>
+
+#include <core/windowproperties.h>
+
+namespace cwp = compiz::window::properties;
+
+namespace
+{
+const Window WindowId = 1;
+const Atom   TestAtom = XA_LAST_PREDEFINED + 1;
+
+class FakeFetcher :
+    public cwp::FetcherInterface
+{
+    public:
+
+	FakeFetcher () :
+	    nFetches (0)
+	{
+	}
+
+	void fetch (Window			 id,
+		    const std::vector <Atom> &properties,
+		    long			 length,
+		    std::vector <cwp::Reply>	 &replies)
+	{
+	    ++nFetches;
+
+	    replies.clear ();
+
+	    for (unsigned int i = 0; i < properties.size (); ++i)
+	    {
+		std::map <Atom, cwp::Reply>::iterator it =
+		    props.find (properties[i]);
+
+		if (it == props.end ())
+		{
+		    cwp::Reply none;
+
+		    none.valid = true;
+		    replies.push_back (none);
+		}
+		else
+		{
+		    replies.push_back (it->second);
+		}
+	    }
+	}
+
+	void set32 (Atom property, Atom type,
+		    const long *items, unsigned long n,
+		    unsigned long bytesAfter = 0)
+	{
+	    cwp::Reply &r = props[property];
+
+	    r.valid	 = true;
+	    r.type	 = type;
+	    r.format	 = 32;
+	    r.nItems	 = n;
+	    r.bytesAfter = bytesAfter;
+	    r.data.assign ((const unsigned char *) items,
+			   (const unsigned char *) (items + n));
+	}
+
+	void set8 (Atom property, Atom type,
+		   const char *bytes, unsigned long n)
+	{
+	    cwp::Reply &r = props[property];
+
+	    r.valid	 = true;
+	    r.type	 = type;
+	    r.format	 = 8;
+	    r.nItems	 = n;
+	    r.bytesAfter = 0;
+	    r.data.assign (bytes, bytes + n);
+	}
+
+	std::map <Atom, cwp::Reply> props;
+	unsigned int		    nFetches;
+};
+
+std::vector <Atom>
+atoms (Atom a, Atom b = None)
+{
+    std::vector <Atom> v (1, a);
+
+    if (b != None)
+	v.push_back (b);
+
+    return v;
+}
+}
+
+class WindowPropertiesTest :
+    public ::testing::Test
+{
+    public:
+
+	Atom	      actual;
+	int	      format;
+	unsigned long n, left;
+	unsigned char *data;
+
+	FakeFetcher fetcher;
+};
+
+TEST_F (WindowPropertiesTest, TestFetchesOnceAndServesLongs)
+{
+    const long items[] = { 1, -2, 3 };
+
+    fetcher.set32 (TestAtom, XA_CARDINAL, items, 3);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (TestAtom, XA_WM_NAME));
+
+    EXPECT_EQ (1u, fetcher.nFetches);
+    ASSERT_EQ (Success, cwp::getWindowProperty (NULL, WindowId, TestAtom,
+						0L, 3L, False, XA_CARDINAL,
+						&actual, &format, &n,
+						&left, &data));
+    EXPECT_EQ ((Atom) XA_CARDINAL, actual);
+    EXPECT_EQ (32, format);
+    ASSERT_EQ (3u, n);
+    EXPECT_EQ (0u, left);
+    EXPECT_EQ (0, memcmp (data, items, sizeof (items)));
+
+    XFree (data);
+}
+
+TEST_F (WindowPropertiesTest, TestTruncatesShorterReads)
+{
+    const long items[] = { 1, 2, 3, 4 };
+
+    fetcher.set32 (TestAtom, XA_CARDINAL, items, 4);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (TestAtom));
+
+    ASSERT_EQ (Success, cwp::getWindowProperty (NULL, WindowId, TestAtom,
+						1L, 2L, False, XA_CARDINAL,
+						&actual, &format, &n,
+						&left, &data));
+    ASSERT_EQ (2u, n);
+    EXPECT_EQ (4u, left);
+    EXPECT_EQ (2, ((long *) data)[0]);
+    EXPECT_EQ (3, ((long *) data)[1]);
+
+    XFree (data);
+}
+
+TEST_F (WindowPropertiesTest, TestTypeMismatchReturnsNoItems)
+{
+    const long items[] = { 1, 2 };
+
+    fetcher.set32 (TestAtom, XA_ATOM, items, 2);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (TestAtom));
+
+    ASSERT_EQ (Success, cwp::getWindowProperty (NULL, WindowId, TestAtom,
+						0L, 2L, False, XA_CARDINAL,
+						&actual, &format, &n,
+						&left, &data));
+    EXPECT_EQ ((Atom) XA_ATOM, actual);
+    EXPECT_EQ (32, format);
+    EXPECT_EQ (0u, n);
+    EXPECT_EQ (8u, left);
+    EXPECT_TRUE (data != NULL);
+
+    XFree (data);
+}
+
+TEST_F (WindowPropertiesTest, TestMissingProperty)
+{
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (TestAtom));
+
+    ASSERT_EQ (Success, cwp::getWindowProperty (NULL, WindowId, TestAtom,
+						0L, 1L, False, XA_CARDINAL,
+						&actual, &format, &n,
+						&left, &data));
+    EXPECT_EQ ((Atom) None, actual);
+    EXPECT_EQ (0, format);
+    EXPECT_EQ (0u, n);
+    EXPECT_TRUE (data == NULL);
+}
+
+TEST_F (WindowPropertiesTest, TestNotServedBeyondPrefetch)
+{
+    const long items[] = { 1, 2 };
+
+    fetcher.set32 (TestAtom, XA_CARDINAL, items, 2, 8);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (TestAtom));
+
+    EXPECT_TRUE (prefetch.read (WindowId, TestAtom, 0L, 2L, XA_CARDINAL,
+				&actual, &format, &n, &left, &data));
+    EXPECT_EQ (8u, left);
+    XFree (data);
+
+    EXPECT_FALSE (prefetch.read (WindowId, TestAtom, 0L, 3L, XA_CARDINAL,
+				 &actual, &format, &n, &left, &data));
+    EXPECT_FALSE (prefetch.read (WindowId, XA_WM_NAME, 0L, 1L, XA_STRING,
+				 &actual, &format, &n, &left, &data));
+    EXPECT_FALSE (prefetch.read (WindowId + 1, TestAtom, 0L, 1L, XA_CARDINAL,
+				 &actual, &format, &n, &left, &data));
+}
+
+TEST_F (WindowPropertiesTest, TestInvalidReplyNotServed)
+{
+    fetcher.props[TestAtom] = cwp::Reply ();
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (TestAtom));
+
+    EXPECT_FALSE (prefetch.read (WindowId, TestAtom, 0L, 1L, XA_CARDINAL,
+				 &actual, &format, &n, &left, &data));
+}
+
+TEST_F (WindowPropertiesTest, TestNestedPrefetches)
+{
+    const long items[] = { 42 };
+
+    fetcher.set32 (TestAtom, XA_CARDINAL, items, 1);
+
+    {
+	cwp::Prefetch outer (&fetcher, WindowId, atoms (TestAtom));
+
+	{
+	    cwp::Prefetch inner (&fetcher, WindowId + 1, atoms (TestAtom));
+
+	    EXPECT_EQ (&inner, cwp::Prefetch::active ());
+	    ASSERT_TRUE (inner.read (WindowId, TestAtom, 0L, 1L, XA_CARDINAL,
+				     &actual, &format, &n, &left, &data));
+	    EXPECT_EQ (42, ((long *) data)[0]);
+	    XFree (data);
+	}
+
+	EXPECT_EQ (&outer, cwp::Prefetch::active ());
+    }
+
+    EXPECT_TRUE (cwp::Prefetch::active () == NULL);
+}
+
+TEST_F (WindowPropertiesTest, TestNormalHints)
+{
+    long items[18] = { 0 };
+
+    items[0]  = PMinSize | PResizeInc | PBaseSize | PWinGravity;
+    items[5]  = 100;
+    items[6]  = 50;
+    items[9]  = 8;
+    items[10] = 16;
+    items[15] = 4;
+    items[16] = 2;
+    items[17] = StaticGravity;
+
+    fetcher.set32 (XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, items, 18);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (XA_WM_NORMAL_HINTS));
+
+    XSizeHints hints;
+    long       supplied;
+
+    ASSERT_TRUE (cwp::getWMNormalHints (NULL, WindowId, &hints, &supplied));
+    EXPECT_EQ (items[0], hints.flags);
+    EXPECT_EQ (100, hints.min_width);
+    EXPECT_EQ (50, hints.min_height);
+    EXPECT_EQ (8, hints.width_inc);
+    EXPECT_EQ (16, hints.height_inc);
+    EXPECT_EQ (4, hints.base_width);
+    EXPECT_EQ (2, hints.base_height);
+    EXPECT_EQ (StaticGravity, hints.win_gravity);
+    EXPECT_TRUE (supplied & PBaseSize);
+}
+
+TEST_F (WindowPropertiesTest, TestOldNormalHintsDropBaseSize)
+{
+    long items[15] = { 0 };
+
+    items[0] = PMinSize | PBaseSize;
+
+    fetcher.set32 (XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, items, 15);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (XA_WM_NORMAL_HINTS));
+
+    XSizeHints hints;
+    long       supplied;
+
+    ASSERT_TRUE (cwp::getWMNormalHints (NULL, WindowId, &hints, &supplied));
+    EXPECT_EQ (PMinSize, hints.flags);
+    EXPECT_FALSE (supplied & PBaseSize);
+}
+
+TEST_F (WindowPropertiesTest, TestWMHints)
+{
+    long items[8] = { InputHint | IconPixmapHint, 1, 0, 0x1234 };
+
+    fetcher.set32 (XA_WM_HINTS, XA_WM_HINTS, items, 8);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (XA_WM_HINTS));
+
+    XWMHints *hints = cwp::getWMHints (NULL, WindowId);
+
+    ASSERT_TRUE (hints != NULL);
+    EXPECT_EQ (items[0], hints->flags);
+    EXPECT_EQ (True, hints->input);
+    EXPECT_EQ (0x1234u, hints->icon_pixmap);
+    EXPECT_EQ (0u, hints->window_group);
+
+    XFree (hints);
+}
+
+TEST_F (WindowPropertiesTest, TestClassHint)
+{
+    /* The terminator of the class name is missing */
+    const char wmClass[] = "xterm\0XTerm";
+
+    fetcher.set8 (XA_WM_CLASS, XA_STRING, wmClass, sizeof (wmClass) - 1);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId, atoms (XA_WM_CLASS));
+
+    XClassHint classHint;
+
+    ASSERT_TRUE (cwp::getClassHint (NULL, WindowId, &classHint));
+    EXPECT_STREQ ("xterm", classHint.res_name);
+    EXPECT_STREQ ("XTerm", classHint.res_class);
+
+    XFree (classHint.res_name);
+    XFree (classHint.res_class);
+}
+
+TEST_F (WindowPropertiesTest, TestTransientForAndProtocols)
+{
+    const long transient[] = { 0x400001 };
+    const long protocols[] = { TestAtom, TestAtom + 1 };
+
+    fetcher.set32 (XA_WM_TRANSIENT_FOR, XA_WINDOW, transient, 1);
+    fetcher.set32 (TestAtom, XA_ATOM, protocols, 2);
+
+    cwp::Prefetch prefetch (&fetcher, WindowId,
+			    atoms (XA_WM_TRANSIENT_FOR, TestAtom));
+
+    Window transientFor;
+    Atom   *atomList;
+    int    count;
+
+    ASSERT_TRUE (cwp::getTransientForHint (NULL, WindowId, &transientFor));
+    EXPECT_EQ (0x400001u, transientFor);
+
+    ASSERT_TRUE (cwp::getWMProtocols (NULL, WindowId, TestAtom,
+				      &atomList, &count));
+    ASSERT_EQ (2, count);
+    EXPECT_EQ (TestAtom + 1, atomList[1]);
+
+    XFree (atomList);
+}
@@ -227,3 +227,138 @@ TEST(WrapSystem, two_wrappers_get_their_functions_called)
     ASSERT_EQ(2, TestWrapper::testMethodReturningVoidCalls);
 }
 
+
+TEST(WrapSystem, disabled_wrappers_in_the_middle_are_skipped)
+{
+    TestWrapper::testMethodReturningVoidCalls = 0;
+    TestImplementation::testMethodReturningVoidCalls = 0;
+
+    TestImplementation imp;
+    {
+        TestWrapper wrap1(imp);
+        TestWrapper wrap2(imp);
+        TestWrapper wrap3(imp);
+
+        wrap2.disableTestMethodReturningVoid();
+
+        imp.testMethodReturningVoid();
+
+        ASSERT_EQ(2, TestWrapper::testMethodReturningVoidCalls);
+        ASSERT_EQ(1, TestImplementation::testMethodReturningVoidCalls);
+    }
+}
+
+namespace {
+// Behaves like a plugin that doesn't implement testMethodReturningVoid
+class PassThroughWrapper : public TestInterface {
+    TestImplementation& impl;
+public:
+
+    PassThroughWrapper(TestImplementation& impl)
+        : impl(impl)
+    { setHandler(&impl, true); }
+
+    ~PassThroughWrapper()
+    { setHandler(&impl, false); }
+
+    virtual void testMethodReturningVoid()
+    { TestInterface::testMethodReturningVoid(); }
+
+    virtual int testMethodReturningInt(int i)
+    { return impl.testMethodReturningInt(i); }
+};
+}
+
+TEST(WrapSystem, wrappers_reaching_the_default_get_disabled)
+{
+    TestWrapper::testMethodReturningVoidCalls = 0;
+    TestImplementation::testMethodReturningVoidCalls = 0;
+
+    TestImplementation imp;
+    {
+        TestWrapper wrap1(imp);
+        PassThroughWrapper pass(imp);
+        TestWrapper wrap2(imp);
+
+        imp.setCountCalls(true);
+
+        imp.testMethodReturningVoid();
+        imp.testMethodReturningVoid();
+
+        ASSERT_EQ(4, TestWrapper::testMethodReturningVoidCalls);
+        ASSERT_EQ(2, TestImplementation::testMethodReturningVoidCalls);
+        ASSERT_EQ(1u, imp.numCalls(&pass, TestImplementation::testMethodReturningVoidIndex));
+    }
+}
+
+TEST(WrapSystem, calls_are_counted_only_when_enabled)
+{
+    TestImplementation imp;
+    {
+        TestWrapper wrap1(imp);
+        TestWrapper wrap2(imp);
+
+        imp.testMethodReturningInt(1);
+        ASSERT_EQ(0u, imp.numCalls(&wrap1, TestImplementation::testMethodReturningIntIndex));
+
+        imp.setCountCalls(true);
+        imp.testMethodReturningInt(1);
+        imp.testMethodReturningInt(1);
+
+        wrap1.disableTestMethodReturningVoid();
+        imp.testMethodReturningVoid();
+
+        ASSERT_EQ(2u, imp.numCalls(&wrap1, TestImplementation::testMethodReturningIntIndex));
+        ASSERT_EQ(2u, imp.numCalls(&wrap2, TestImplementation::testMethodReturningIntIndex));
+        ASSERT_EQ(0u, imp.numCalls(&wrap1, TestImplementation::testMethodReturningVoidIndex));
+        ASSERT_EQ(1u, imp.numCalls(&wrap2, TestImplementation::testMethodReturningVoidIndex));
+
+        imp.resetCallCounts();
+        ASSERT_EQ(0u, imp.numCalls(&wrap2, TestImplementation::testMethodReturningIntIndex));
+    }
+}
+
+TEST(WrapSystem, wrapped_functions_are_reported)
+{
+    TestImplementation imp;
+
+    ASSERT_FALSE(imp.functionWrapped(TestImplementation::testMethodReturningVoidIndex));
+    {
+        TestWrapper wrap(imp);
+
+        ASSERT_TRUE(imp.functionWrapped(TestImplementation::testMethodReturningVoidIndex));
+        ASSERT_TRUE(imp.functionWrapped(TestImplementation::testMethodReturningIntIndex));
+
+        wrap.disableTestMethodReturningVoid();
+
+        ASSERT_FALSE(imp.functionWrapped(TestImplementation::testMethodReturningVoidIndex));
+        ASSERT_TRUE(imp.functionWrapped(TestImplementation::testMethodReturningIntIndex));
+    }
+
+    ASSERT_FALSE(imp.functionWrapped(TestImplementation::testMethodReturningIntIndex));
+}
+
+TEST(WrapSystem, wrapped_functions_besides_ignored_interfaces_are_reported)
+{
+    TestImplementation imp;
+    TestWrapper wrap1(imp);
+    std::vector<TestInterface *> ignored;
+
+    ASSERT_TRUE(imp.functionWrappedBesides(TestImplementation::testMethodReturningVoidIndex, ignored));
+
+    ignored.push_back(&wrap1);
+    ASSERT_FALSE(imp.functionWrappedBesides(TestImplementation::testMethodReturningVoidIndex, ignored));
+
+    {
+        TestWrapper wrap2(imp);
+
+        ASSERT_TRUE(imp.functionWrappedBesides(TestImplementation::testMethodReturningVoidIndex, ignored));
+
+        wrap2.disableTestMethodReturningVoid();
+
+        ASSERT_FALSE(imp.functionWrappedBesides(TestImplementation::testMethodReturningVoidIndex, ignored));
+        ASSERT_TRUE(imp.functionWrappedBesides(TestImplementation::testMethodReturningIntIndex, ignored));
+    }
+
+    ASSERT_FALSE(imp.functionWrappedBesides(TestImplementation::testMethodReturningIntIndex, ignored));
+}